@@ -574,6 +574,7 @@ const cairo_perf_case_t perf_cases[] = {
     { FUNC(unaligned_clip), 100, 100},
     { FUNC(rectangles), 512, 512},
     { FUNC(rounded_rectangles), 512, 512},
+    { FUNC(dots), 512, 512},
     { FUNC(long_dashed_lines), 512, 512},
     { FUNC(composite_checker), 16, 512},
     { FUNC(twin), 800, 800},
@@ -128,6 +128,13 @@ cairo_perf_cover_sources_and_operators (cairo_perf_t	   *perf,
 					cairo_perf_func_t   perf_func,
 					cairo_count_func_t  count_func);
 
+cairo_time_t
+cairo_perf_a1_target (cairo_perf_func_t   perf_func,
+		      cairo_t		 *cr,
+		      int		  width,
+		      int		  height,
+		      int		  loops);
+
 /* reporter convenience routines */
 
 typedef struct _test_report {
@@ -224,6 +231,7 @@ CAIRO_PERF_DECL (long_lines);
 CAIRO_PERF_DECL (unaligned_clip);
 CAIRO_PERF_DECL (rectangles);
 CAIRO_PERF_DECL (rounded_rectangles);
+CAIRO_PERF_DECL (dots);
 CAIRO_PERF_DECL (long_dashed_lines);
 CAIRO_PERF_DECL (composite_checker);
 CAIRO_PERF_DECL (twin);
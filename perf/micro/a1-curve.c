@@ -95,6 +95,18 @@ do_curve_fill (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+do_curve_stroke_a1 (cairo_t *cr, int width, int height, int loops)
+{
+    return cairo_perf_a1_target (do_curve_stroke, cr, width, height, loops);
+}
+
+static cairo_time_t
+do_curve_fill_a1 (cairo_t *cr, int width, int height, int loops)
+{
+    return cairo_perf_a1_target (do_curve_fill, cr, width, height, loops);
+}
+
 cairo_bool_t
 a1_curve_enabled (cairo_perf_t *perf)
 {
@@ -109,4 +121,7 @@ a1_curve (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 
     cairo_perf_run (perf, "a1-curve-stroked", do_curve_stroke, NULL);
     cairo_perf_run (perf, "a1-curve-filled", do_curve_fill, NULL);
+
+    cairo_perf_run (perf, "a1-curve-stroked-a1", do_curve_stroke_a1, NULL);
+    cairo_perf_run (perf, "a1-curve-filled-a1", do_curve_fill_a1, NULL);
 }
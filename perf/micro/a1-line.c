@@ -196,6 +196,24 @@ diagonal_wide (cairo_t *cr, int width, int height, int loops)
     return diagonal (cr, width, height, loops);
 }
 
+static cairo_time_t
+horizontal_wide_a1 (cairo_t *cr, int width, int height, int loops)
+{
+    return cairo_perf_a1_target (horizontal_wide, cr, width, height, loops);
+}
+
+static cairo_time_t
+vertical_wide_a1 (cairo_t *cr, int width, int height, int loops)
+{
+    return cairo_perf_a1_target (vertical_wide, cr, width, height, loops);
+}
+
+static cairo_time_t
+diagonal_wide_a1 (cairo_t *cr, int width, int height, int loops)
+{
+    return cairo_perf_a1_target (diagonal_wide, cr, width, height, loops);
+}
+
 cairo_bool_t
 a1_line_enabled (cairo_perf_t *perf)
 {
@@ -220,4 +238,8 @@ a1_line (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 
     cairo_perf_run (perf, "a1-line-dh", diagonal_hair, NULL);
     cairo_perf_run (perf, "a1-line-dw", diagonal_wide, NULL);
+
+    cairo_perf_run (perf, "a1-line-hw-a1", horizontal_wide_a1, NULL);
+    cairo_perf_run (perf, "a1-line-vw-a1", vertical_wide_a1, NULL);
+    cairo_perf_run (perf, "a1-line-dw-a1", diagonal_wide_a1, NULL);
 }
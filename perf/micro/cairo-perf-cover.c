@@ -337,3 +337,26 @@ cairo_perf_cover_sources_and_operators (cairo_perf_t		*perf,
 	}
     }
 }
+
+/* Runs perf_func straight onto a 1-bit image, as when drawing for a
+ * printer, instead of onto the surface under test. */
+cairo_time_t
+cairo_perf_a1_target (cairo_perf_func_t	 perf_func,
+		      cairo_t		*cr,
+		      int		 width,
+		      int		 height,
+		      int		 loops)
+{
+    cairo_surface_t *surface;
+    cairo_time_t elapsed;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A1, width, height);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_NONE);
+    elapsed = perf_func (cr, width, height, loops);
+    cairo_destroy (cr);
+
+    return elapsed;
+}
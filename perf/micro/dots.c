@@ -0,0 +1,141 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Scatter plots: lots of small filled circles, each filled individually. */
+
+#include "cairo-perf.h"
+
+#define DOT_COUNT (1000)
+
+#if 0
+#define MODE cairo_perf_run
+#else
+#define MODE cairo_perf_cover_sources_and_operators
+#endif
+
+static struct
+{
+    double x;
+    double y;
+    double radius;
+} points[DOT_COUNT];
+
+static cairo_time_t
+do_dot (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	cairo_arc (cr, width/2., height/2., MIN (width, height)/2., 0, 2 * M_PI);
+	cairo_fill (cr);
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_dots (cairo_t *cr, int width, int height, int loops)
+{
+    int i;
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	for (i = 0; i < DOT_COUNT; i++) {
+	    cairo_arc (cr, points[i].x, points[i].y, points[i].radius, 0, 2 * M_PI);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_ellipses (cairo_t *cr, int width, int height, int loops)
+{
+    int i;
+
+    cairo_save (cr);
+    cairo_scale (cr, 1., .5);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	for (i = 0; i < DOT_COUNT; i++) {
+	    cairo_arc (cr, points[i].x, 2 * points[i].y, points[i].radius, 0, 2 * M_PI);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    cairo_restore (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_dots_once (cairo_t *cr, int width, int height, int loops)
+{
+    int i;
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	for (i = 0; i < DOT_COUNT; i++) {
+	    cairo_new_sub_path (cr);
+	    cairo_arc (cr, points[i].x, points[i].y, points[i].radius, 0, 2 * M_PI);
+	}
+	cairo_fill (cr);
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+cairo_bool_t
+dots_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "dots", NULL);
+}
+
+void
+dots (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    int i;
+
+    srand (8478232);
+    for (i = 0; i < DOT_COUNT; i++) {
+	points[i].x = rand () % width;
+	points[i].y = rand () % height;
+	points[i].radius = .5 + (rand () % 40) / 8.;
+    }
+
+    MODE (perf, "one-dot", do_dot, NULL);
+    MODE (perf, "dots", do_dots, NULL);
+    MODE (perf, "dots-ellipses", do_ellipses, NULL);
+    MODE (perf, "dots-once", do_dots_once, NULL);
+}
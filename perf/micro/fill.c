@@ -107,6 +107,22 @@ do_fill_eo_noaa (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+/* The 4x4 tor instance */
+static cairo_time_t
+do_fill_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return do_fill (cr, width, height, loops);
+}
+
+/* The exact area converter, against the default 15x256 tor of "fill" */
+static cairo_time_t
+do_fill_exact (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_BEST);
+    return do_fill (cr, width, height, loops);
+}
+
 cairo_bool_t
 fill_enabled (cairo_perf_t *perf)
 {
@@ -117,6 +133,8 @@ void
 fill (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 {
     cairo_perf_cover_sources_and_operators (perf, "fill", do_fill, NULL);
+    cairo_perf_cover_sources_and_operators (perf, "fill-fast", do_fill_fast, NULL);
+    cairo_perf_cover_sources_and_operators (perf, "fill-exact", do_fill_exact, NULL);
     cairo_perf_cover_sources_and_operators (perf, "fill-annuli", do_fill_annuli, NULL);
     cairo_perf_cover_sources_and_operators (perf, "fill-eo-noaa", do_fill_eo_noaa, NULL);
 }
@@ -56,6 +56,36 @@ do_text (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+do_text_short (cairo_t *cr, int width, int height, int loops)
+{
+    /* the sort of labels found along the axes of a chart */
+    static const char *labels[] = {
+	"0", "25", "50", "75", "100", "x", "y", "Jan", "Feb", "Mar",
+    };
+    double x, y;
+    int i = 0;
+
+    cairo_set_font_size (cr, 9);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	for (y = 10; y < height; y += 10) {
+	    for (x = 0; x < width; x += 20) {
+		cairo_move_to (cr, x, y);
+		cairo_show_text (cr, labels[i]);
+		if (++i == ARRAY_LENGTH (labels))
+		    i = 0;
+	    }
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
 cairo_bool_t
 text_enabled (cairo_perf_t *perf)
 {
@@ -66,4 +96,5 @@ void
 text (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 {
     cairo_perf_cover_sources_and_operators (perf, "text", do_text, NULL);
+    cairo_perf_cover_sources_and_operators (perf, "text-short", do_text_short, NULL);
 }
@@ -93,6 +93,13 @@ do_fast_tiger (cairo_t *cr, int width, int height, int loops)
     return do_tiger (cr, width, height, loops);
 }
 
+static cairo_time_t
+do_default_tiger (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_DEFAULT);
+    return do_tiger (cr, width, height, loops);
+}
+
 static cairo_time_t
 do_best_tiger (cairo_t *cr, int width, int height, int loops)
 {
@@ -111,5 +118,6 @@ tiger (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 {
     cairo_perf_run (perf, "tiger-mono", do_mono_tiger, NULL);
     cairo_perf_run (perf, "tiger-fast", do_fast_tiger, NULL);
+    cairo_perf_run (perf, "tiger-default", do_default_tiger, NULL);
     cairo_perf_run (perf, "tiger-best", do_best_tiger, NULL);
 }
@@ -0,0 +1,537 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* An exact area scan converter.
+ *
+ * Rather than sampling, each pixel row accumulates the signed area
+ * that every edge crossing the row contributes to the cells it passes
+ * through, together with the height it covers, into a row of deltas.
+ * A running sum along the row then gives the winding-weighted area of
+ * each pixel exactly, from which the fill rule gives the coverage:
+ * clamped to 1 for the non-zero rule, and folded back into [0, 1] for
+ * even-odd.
+ *
+ * As the edges need not be sorted, only bucketed by their first row,
+ * the cost is linear in the number of pixels the edges cross. The
+ * result is exact wherever the winding number changes by at most one
+ * within a pixel; where several edges of the same direction cross a
+ * single pixel (overlapping subpaths), their areas add before the
+ * coverage is clamped.
+ */
+
+#include "cairoint.h"
+#include "cairo-combsort-inline.h"
+#include "cairo-spans-private.h"
+#include "cairo-error-private.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+struct edge {
+    struct edge *next;
+
+    /* Vertical extents in pixels relative to the top of the clip */
+    double ytop, ybot;
+    /* and the x, relative to the left of the clip, at ytop */
+    double xtop;
+    double dxdy;
+
+    int dir;
+};
+
+/* The cells an edge touched within a row */
+struct range {
+    int x0, x1;
+};
+
+/* A collection of vertically clipped edges, bucketed by their first
+ * pixel row. Edges are moved from the buckets to the active list while
+ * scan converting. */
+struct polygon {
+    int num_edges;
+    struct edge *edges;
+
+    struct edge **y_buckets;
+
+    struct edge *y_buckets_embedded[64];
+    struct edge edges_embedded[32];
+};
+
+struct area_scan_converter {
+    struct polygon polygon[1];
+
+    /* Edges crossing the current row. */
+    struct edge *active;
+
+    /* Accumulated area and cover deltas for the current row, and the
+     * ranges of cells touched, at most one for each active edge. */
+    double *cells;
+    struct range *ranges;
+    int num_ranges;
+
+    cairo_half_open_span_t *spans;
+    int num_spans;
+
+    double cells_embedded[64];
+    struct range ranges_embedded[32];
+    cairo_half_open_span_t spans_embedded[64];
+
+    /* Clip box. */
+    int32_t xmin, xmax;
+    int32_t ymin, ymax;
+};
+
+static cairo_status_t
+polygon_init (struct polygon *polygon, int h)
+{
+    polygon->num_edges = 0;
+    polygon->edges = polygon->edges_embedded;
+
+    polygon->y_buckets = polygon->y_buckets_embedded;
+    if (h > ARRAY_LENGTH (polygon->y_buckets_embedded)) {
+	polygon->y_buckets = _cairo_malloc_ab (h, sizeof (struct edge *));
+	if (unlikely (NULL == polygon->y_buckets))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+    memset (polygon->y_buckets, 0, h * sizeof (struct edge *));
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+polygon_fini (struct polygon *polygon)
+{
+    if (polygon->y_buckets != polygon->y_buckets_embedded)
+	free (polygon->y_buckets);
+
+    if (polygon->edges != polygon->edges_embedded)
+	free (polygon->edges);
+}
+
+static void
+polygon_add_edge (struct area_scan_converter *c,
+		  const cairo_edge_t *edge)
+{
+    struct polygon *polygon = c->polygon;
+    cairo_fixed_t top, bottom;
+    struct edge *e;
+    double dx, dy;
+    int row;
+
+    top = MAX (edge->top, _cairo_fixed_from_int (c->ymin));
+    bottom = MIN (edge->bottom, _cairo_fixed_from_int (c->ymax));
+    if (bottom <= top)
+	return;
+
+    e = polygon->edges + polygon->num_edges++;
+    e->dir = edge->dir;
+
+    dx = edge->line.p2.x - edge->line.p1.x;
+    dy = edge->line.p2.y - edge->line.p1.y;
+    e->dxdy = dx / dy;
+
+    e->ytop = _cairo_fixed_to_double (top) - c->ymin;
+    e->ybot = _cairo_fixed_to_double (bottom) - c->ymin;
+    e->xtop = _cairo_fixed_to_double (edge->line.p1.x) - c->xmin;
+    if (dx)
+	e->xtop += _cairo_fixed_to_double (top - edge->line.p1.y) * e->dxdy;
+
+    row = floor (e->ytop);
+    e->next = polygon->y_buckets[row];
+    polygon->y_buckets[row] = e;
+}
+
+inline static void
+touch (struct area_scan_converter *c, int x0, int x1)
+{
+    struct range *r = &c->ranges[c->num_ranges++];
+    r->x0 = x0;
+    r->x1 = x1;
+}
+
+#define range_compare(a, b) ((a).x0 - (b).x0)
+
+CAIRO_COMBSORT_DECLARE (sort_ranges, struct range, range_compare)
+
+/* Accumulate the part of an edge within a single row, from x0 to x1 and
+ * covering a height of d (signed by the direction of the edge). */
+static void
+accumulate (struct area_scan_converter *c,
+	    double x0, double x1, double d)
+{
+    double *cells = c->cells;
+    double width = c->xmax - c->xmin;
+    int x0i, x1i;
+
+    if (x0 > x1) {
+	double t = x0;
+	x0 = x1;
+	x1 = t;
+    }
+
+    /* Anything to the left of the clip covers all of it, */
+    if (x1 <= 0) {
+	cells[0] += d;
+	touch (c, 0, 0);
+	return;
+    }
+    /* and anything to the right none of it. */
+    if (x0 >= width)
+	return;
+
+    if (x0 < 0) {
+	double t = -x0 / (x1 - x0);
+	cells[0] += d * t;
+	d -= d * t;
+	x0 = 0;
+    }
+    if (x1 > width) {
+	d -= d * (x1 - width) / (x1 - x0);
+	x1 = width;
+    }
+
+    x0i = floor (x0);
+    x1i = ceil (x1);
+    if (x1i <= x0i + 1) {
+	/* Within a single pixel: split the trapezoid at its midpoint */
+	double xmf = .5 * (x0 + x1) - x0i;
+
+	cells[x0i] += d - d * xmf;
+	cells[x0i + 1] += d * xmf;
+	x1i = x0i + 1;
+    } else {
+	double s = 1. / (x1 - x0);
+	double x0f = x0 - x0i;
+	double a0 = .5 * s * (1 - x0f) * (1 - x0f);
+	double x1f = x1 - x1i + 1;
+	double am = .5 * s * x1f * x1f;
+
+	cells[x0i] += d * a0;
+	if (x1i == x0i + 2) {
+	    cells[x0i + 1] += d * (1 - a0 - am);
+	} else {
+	    double a1 = s * (1.5 - x0f);
+	    double a2;
+	    int x;
+
+	    cells[x0i + 1] += d * (a1 - a0);
+	    for (x = x0i + 2; x < x1i - 1; x++)
+		cells[x] += d * s;
+	    a2 = a1 + (x1i - x0i - 3) * s;
+	    cells[x1i - 1] += d * (1 - a2 - am);
+	}
+	cells[x1i] += d * am;
+    }
+
+    touch (c, x0i, x1i);
+}
+
+inline static int
+coverage_to_alpha (double area, cairo_bool_t even_odd)
+{
+    area = fabs (area);
+    if (even_odd) {
+	area = fmod (area, 2);
+	if (area > 1)
+	    area = 2 - area;
+    } else if (area > 1) {
+	area = 1;
+    }
+
+    return area * 255 + .5;
+}
+
+/* Sum the cells of the row into spans, clearing them for the next. */
+static void
+row (struct area_scan_converter *c, cairo_bool_t even_odd)
+{
+    int width = c->xmax - c->xmin;
+    double *cells = c->cells;
+    double area = 0;
+    int i, x, next, last = 0;
+
+    c->num_spans = 0;
+    if (c->num_ranges == 0)
+	return;
+
+    /* The coverage only changes within the cells touched by an edge. */
+    if (c->num_ranges > 1)
+	sort_ranges (c->ranges, c->num_ranges);
+
+    next = 0;
+    for (i = 0; i < c->num_ranges; i++) {
+	const struct range *r = &c->ranges[i];
+
+	for (x = MAX (r->x0, next); x <= r->x1 && x < width; x++) {
+	    int alpha;
+
+	    area += cells[x];
+	    cells[x] = 0;
+
+	    alpha = coverage_to_alpha (area, even_odd);
+	    if (alpha != last) {
+		c->spans[c->num_spans].x = c->xmin + x;
+		c->spans[c->num_spans].coverage = alpha;
+		c->num_spans++;
+		last = alpha;
+	    }
+	}
+	for (; x <= r->x1; x++)
+	    cells[x] = 0;
+
+	if (x > next)
+	    next = x;
+    }
+    c->num_ranges = 0;
+
+    if (last) {
+	c->spans[c->num_spans].x = c->xmax;
+	c->spans[c->num_spans].coverage = 0;
+	c->num_spans++;
+    }
+}
+
+static cairo_status_t
+area_scan_converter_render (struct area_scan_converter *c,
+			    cairo_bool_t even_odd,
+			    cairo_span_renderer_t *renderer)
+{
+    struct polygon *polygon = c->polygon;
+    int i, j, h = c->ymax - c->ymin;
+    cairo_status_t status;
+
+    for (i = 0; i < h; i = j) {
+	struct edge *e, **prev;
+	cairo_bool_t is_vertical = TRUE;
+	int min_height = INT_MAX;
+
+	j = i + 1;
+
+	if (polygon->y_buckets[i]) {
+	    e = polygon->y_buckets[i];
+	    while (e->next)
+		e = e->next;
+	    e->next = c->active;
+	    c->active = polygon->y_buckets[i];
+	}
+
+	if (c->active == NULL) {
+	    while (j < h && polygon->y_buckets[j] == NULL)
+		j++;
+	    continue;
+	}
+
+	for (e = c->active; e; e = e->next) {
+	    double y0 = MAX (e->ytop, i);
+	    double y1 = MIN (e->ybot, i + 1);
+
+	    accumulate (c,
+			e->xtop + (y0 - e->ytop) * e->dxdy,
+			e->xtop + (y1 - e->ytop) * e->dxdy,
+			e->dir * (y1 - y0));
+
+	    if (e->dxdy != 0 || e->ytop > i) {
+		is_vertical = FALSE;
+	    } else {
+		int height = floor (e->ybot) - i;
+		if (height < min_height)
+		    min_height = height;
+	    }
+	}
+
+	/* Vertical edges spanning the following rows repeat this one. */
+	if (is_vertical) {
+	    while (--min_height >= 1 && polygon->y_buckets[j] == NULL)
+		j++;
+	}
+
+	for (prev = &c->active; (e = *prev) != NULL; ) {
+	    if (e->ybot <= j)
+		*prev = e->next;
+	    else
+		prev = &e->next;
+	}
+
+	row (c, even_odd);
+	if (c->num_spans) {
+	    status = renderer->render_rows (renderer, c->ymin + i, j - i,
+					    c->spans, c->num_spans);
+	    if (unlikely (status))
+		return status;
+	}
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_area_scan_converter_init (struct area_scan_converter *c,
+			   int xmin, int ymin,
+			   int xmax, int ymax)
+{
+    cairo_status_t status;
+    int width = xmax - xmin;
+
+    c->cells = c->cells_embedded;
+    c->ranges = c->ranges_embedded;
+    c->num_ranges = 0;
+    c->spans = c->spans_embedded;
+
+    status = polygon_init (c->polygon, ymax - ymin);
+    if (unlikely (status))
+	return status;
+
+    if (width + 2 > ARRAY_LENGTH (c->cells_embedded)) {
+	c->cells = _cairo_malloc_ab (width + 2, sizeof (double));
+	if (unlikely (c->cells == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+    memset (c->cells, 0, (width + 2) * sizeof (double));
+
+    if (width + 2 > ARRAY_LENGTH (c->spans_embedded)) {
+	c->spans = _cairo_malloc_ab (width + 2,
+				     sizeof (cairo_half_open_span_t));
+	if (unlikely (c->spans == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    c->active = NULL;
+
+    c->xmin = xmin;
+    c->xmax = xmax;
+    c->ymin = ymin;
+    c->ymax = ymax;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_area_scan_converter_fini (struct area_scan_converter *c)
+{
+    if (c->spans != c->spans_embedded)
+	free (c->spans);
+
+    if (c->ranges != c->ranges_embedded)
+	free (c->ranges);
+
+    if (c->cells != c->cells_embedded)
+	free (c->cells);
+
+    polygon_fini (c->polygon);
+}
+
+struct _cairo_area_scan_converter {
+    cairo_scan_converter_t base;
+
+    struct area_scan_converter converter[1];
+    cairo_fill_rule_t fill_rule;
+};
+
+typedef struct _cairo_area_scan_converter cairo_area_scan_converter_t;
+
+static void
+_cairo_area_scan_converter_destroy (void *converter)
+{
+    cairo_area_scan_converter_t *self = converter;
+    _area_scan_converter_fini (self->converter);
+    free (self);
+}
+
+cairo_status_t
+_cairo_area_scan_converter_add_polygon (void		*converter,
+					const cairo_polygon_t *polygon)
+{
+    cairo_area_scan_converter_t *self = converter;
+    struct polygon *p = self->converter->polygon;
+    int i;
+
+    if (polygon->num_edges > ARRAY_LENGTH (p->edges_embedded)) {
+	p->edges = _cairo_malloc_ab (polygon->num_edges, sizeof (struct edge));
+	if (unlikely (p->edges == NULL)) {
+	    p->edges = p->edges_embedded;
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	}
+    }
+
+    if (polygon->num_edges > ARRAY_LENGTH (self->converter->ranges_embedded)) {
+	self->converter->ranges = _cairo_malloc_ab (polygon->num_edges,
+						    sizeof (struct range));
+	if (unlikely (self->converter->ranges == NULL)) {
+	    self->converter->ranges = self->converter->ranges_embedded;
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	}
+    }
+
+    for (i = 0; i < polygon->num_edges; i++)
+	polygon_add_edge (self->converter, &polygon->edges[i]);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_area_scan_converter_generate (void			*converter,
+				     cairo_span_renderer_t	*renderer)
+{
+    cairo_area_scan_converter_t *self = converter;
+
+    return area_scan_converter_render (self->converter,
+				       self->fill_rule == CAIRO_FILL_RULE_EVEN_ODD,
+				       renderer);
+}
+
+cairo_scan_converter_t *
+_cairo_area_scan_converter_create (int			xmin,
+				   int			ymin,
+				   int			xmax,
+				   int			ymax,
+				   cairo_fill_rule_t	fill_rule)
+{
+    cairo_area_scan_converter_t *self;
+    cairo_status_t status;
+
+    self = malloc (sizeof (struct _cairo_area_scan_converter));
+    if (unlikely (self == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto bail_nomem;
+    }
+
+    self->base.destroy = _cairo_area_scan_converter_destroy;
+    self->base.generate = _cairo_area_scan_converter_generate;
+
+    status = _area_scan_converter_init (self->converter,
+					xmin, ymin, xmax, ymax);
+    if (unlikely (status))
+	goto bail;
+
+    self->fill_rule = fill_rule;
+
+    return &self->base;
+
+ bail:
+    self->base.destroy (&self->base);
+ bail_nomem:
+    return _cairo_scan_converter_create_in_error (status);
+}
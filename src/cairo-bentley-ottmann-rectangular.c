@@ -41,6 +41,7 @@
 #include "cairo-boxes-private.h"
 #include "cairo-error-private.h"
 #include "cairo-combsort-inline.h"
+#include "cairo-radixsort-inline.h"
 #include "cairo-list-private.h"
 #include "cairo-traps-private.h"
 
@@ -199,10 +200,30 @@ rectangle_peek_stop (sweep_line_t *sweep_line)
     return sweep_line->stop[PQ_FIRST_ENTRY];
 }
 
-CAIRO_COMBSORT_DECLARE (_rectangle_sort,
+CAIRO_COMBSORT_DECLARE (_rectangle_combsort,
 			rectangle_t *,
 			rectangle_compare_start)
 
+#define RECTANGLE_TOP_KEY(r) _cairo_radixsort_signed_key ((r)->top)
+
+CAIRO_RADIXSORT_DECLARE (_rectangle_radixsort,
+			 rectangle_t *,
+			 RECTANGLE_TOP_KEY)
+
+/* Order by top edge; large arrays come with scratch space for a radix
+ * sort, small ones are left to the comb sort.
+ */
+static void
+_rectangle_sort (rectangle_t **rectangles,
+		 rectangle_t **tmp,
+		 int num_rectangles)
+{
+    if (tmp != NULL)
+	_rectangle_radixsort (rectangles, tmp, num_rectangles);
+    else
+	_rectangle_combsort (rectangles, num_rectangles);
+}
+
 static void
 sweep_line_init (sweep_line_t	 *sweep_line,
 		 rectangle_t	**rectangles,
@@ -669,6 +690,7 @@ _cairo_bentley_ottmann_tessellate_rectangular_traps (cairo_traps_t *traps,
     rectangle_t stack_rectangles[CAIRO_STACK_ARRAY_LENGTH (rectangle_t)];
     rectangle_t *stack_rectangles_ptrs[ARRAY_LENGTH (stack_rectangles) + 3];
     rectangle_t *rectangles, **rectangles_ptrs;
+    rectangle_t **tmp = NULL;
     cairo_status_t status;
     int i;
 
@@ -693,12 +715,13 @@ _cairo_bentley_ottmann_tessellate_rectangular_traps (cairo_traps_t *traps,
     if (traps->num_traps > ARRAY_LENGTH (stack_rectangles)) {
 	rectangles = _cairo_malloc_ab_plus_c (traps->num_traps,
 					      sizeof (rectangle_t) +
-					      sizeof (rectangle_t *),
+					      2*sizeof (rectangle_t *),
 					      3*sizeof (rectangle_t *));
 	if (unlikely (rectangles == NULL))
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
 	rectangles_ptrs = (rectangle_t **) (rectangles + traps->num_traps);
+	tmp = rectangles_ptrs + traps->num_traps + 3;
     }
 
     for (i = 0; i < traps->num_traps; i++) {
@@ -725,7 +748,7 @@ _cairo_bentley_ottmann_tessellate_rectangular_traps (cairo_traps_t *traps,
 	rectangles_ptrs[i+2] = &rectangles[i];
     }
     /* XXX incremental sort */
-    _rectangle_sort (rectangles_ptrs+2, i);
+    _rectangle_sort (rectangles_ptrs+2, tmp, i);
 
     _cairo_traps_clear (traps);
     status = _cairo_bentley_ottmann_tessellate_rectangular (rectangles_ptrs+2, i,
@@ -752,6 +775,7 @@ _cairo_bentley_ottmann_tessellate_boxes (const cairo_boxes_t *in,
     rectangle_t *rectangles, **rectangles_ptrs;
     rectangle_t *stack_rectangles_chain[CAIRO_STACK_ARRAY_LENGTH (rectangle_t *) ];
     rectangle_t **rectangles_chain = NULL;
+    rectangle_t **tmp = NULL;
     const struct _cairo_boxes_chunk *chunk;
     cairo_status_t status;
     int i, j, y_min, y_max;
@@ -815,7 +839,7 @@ _cairo_bentley_ottmann_tessellate_boxes (const cairo_boxes_t *in,
     if (in->num_boxes > ARRAY_LENGTH (stack_rectangles)) {
 	rectangles = _cairo_malloc_ab_plus_c (in->num_boxes,
 					      sizeof (rectangle_t) +
-					      sizeof (rectangle_t *),
+					      2*sizeof (rectangle_t *),
 					      3*sizeof (rectangle_t *));
 	if (unlikely (rectangles == NULL)) {
 	    if (rectangles_chain != stack_rectangles_chain)
@@ -824,6 +848,7 @@ _cairo_bentley_ottmann_tessellate_boxes (const cairo_boxes_t *in,
 	}
 
 	rectangles_ptrs = (rectangle_t **) (rectangles + in->num_boxes);
+	tmp = rectangles_ptrs + in->num_boxes + 3;
     }
 
     j = 0;
@@ -871,7 +896,7 @@ _cairo_bentley_ottmann_tessellate_boxes (const cairo_boxes_t *in,
 	    for (r = rectangles_chain[y_min]; r; r = (rectangle_t *)r->left.next)
 		rectangles_ptrs[j++] = r;
 	    if (j > start + 1)
-		_rectangle_sort (rectangles_ptrs + start, j - start);
+		_rectangle_sort (rectangles_ptrs + start, NULL, j - start);
 	}
 
 	if (rectangles_chain != stack_rectangles_chain)
@@ -879,7 +904,7 @@ _cairo_bentley_ottmann_tessellate_boxes (const cairo_boxes_t *in,
 
 	j -= 2;
     } else {
-	_rectangle_sort (rectangles_ptrs + 2, j);
+	_rectangle_sort (rectangles_ptrs + 2, tmp, j);
     }
 
     _cairo_boxes_clear (out);
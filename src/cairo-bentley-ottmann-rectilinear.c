@@ -40,6 +40,7 @@
 
 #include "cairo-boxes-private.h"
 #include "cairo-combsort-inline.h"
+#include "cairo-radixsort-inline.h"
 #include "cairo-error-private.h"
 #include "cairo-traps-private.h"
 
@@ -127,16 +128,51 @@ _cairo_bo_event_dequeue (cairo_bo_sweep_line_t *sweep_line)
     return *sweep_line->events++;
 }
 
-CAIRO_COMBSORT_DECLARE (_cairo_bo_event_queue_sort,
+CAIRO_COMBSORT_DECLARE (_cairo_bo_event_queue_combsort,
 			cairo_bo_event_t *,
 			cairo_bo_event_compare)
 
+#define EVENT_TYPE_KEY(e) ((uint32_t) (e)->type)
+#define EVENT_X_KEY(e) _cairo_radixsort_signed_key ((e)->point.x)
+#define EVENT_Y_KEY(e) _cairo_radixsort_signed_key ((e)->point.y)
+
+CAIRO_RADIXSORT_DECLARE (_cairo_bo_event_sort_by_type,
+			 cairo_bo_event_t *,
+			 EVENT_TYPE_KEY)
+CAIRO_RADIXSORT_DECLARE (_cairo_bo_event_sort_by_x,
+			 cairo_bo_event_t *,
+			 EVENT_X_KEY)
+CAIRO_RADIXSORT_DECLARE (_cairo_bo_event_sort_by_y,
+			 cairo_bo_event_t *,
+			 EVENT_Y_KEY)
+
+/* Large event lists are ordered with a radix sort on (y, x, type),
+ * using the scratch array allocated alongside the events. The events
+ * start out in address order, so the stable sort also reproduces the
+ * final tie-break of cairo_bo_event_compare().
+ */
+static void
+_cairo_bo_event_queue_sort (cairo_bo_event_t	**events,
+			    cairo_bo_event_t	**tmp,
+			    int			  num_events)
+{
+    if (tmp == NULL) {
+	_cairo_bo_event_queue_combsort (events, num_events);
+	return;
+    }
+
+    _cairo_bo_event_sort_by_type (events, tmp, num_events);
+    _cairo_bo_event_sort_by_x (events, tmp, num_events);
+    _cairo_bo_event_sort_by_y (events, tmp, num_events);
+}
+
 static void
 _cairo_bo_sweep_line_init (cairo_bo_sweep_line_t *sweep_line,
 			   cairo_bo_event_t	**events,
+			   cairo_bo_event_t	**tmp,
 			   int			  num_events)
 {
-    _cairo_bo_event_queue_sort (events, num_events);
+    _cairo_bo_event_queue_sort (events, tmp, num_events);
     events[num_events] = NULL;
     sweep_line->events = events;
 
@@ -392,6 +428,7 @@ _active_edges_to_traps (cairo_bo_edge_t		*left,
 
 static cairo_status_t
 _cairo_bentley_ottmann_tessellate_rectilinear (cairo_bo_event_t   **start_events,
+					       cairo_bo_event_t   **tmp,
 					       int			 num_events,
 					       cairo_fill_rule_t	 fill_rule,
 					       cairo_bool_t		 do_traps,
@@ -401,7 +438,7 @@ _cairo_bentley_ottmann_tessellate_rectilinear (cairo_bo_event_t   **start_events
     cairo_bo_event_t *event;
     cairo_status_t status;
 
-    _cairo_bo_sweep_line_init (&sweep_line, start_events, num_events);
+    _cairo_bo_sweep_line_init (&sweep_line, start_events, tmp, num_events);
 
     while ((event = _cairo_bo_event_dequeue (&sweep_line))) {
 	if (event->point.y != sweep_line.current_y) {
@@ -449,6 +486,7 @@ _cairo_bentley_ottmann_tessellate_rectilinear_polygon_to_boxes (const cairo_poly
     cairo_bo_event_t **event_ptrs;
     cairo_bo_edge_t stack_edges[ARRAY_LENGTH (stack_events)];
     cairo_bo_edge_t *edges;
+    cairo_bo_event_t **tmp = NULL;
     int num_events;
     int i, j;
 
@@ -464,13 +502,14 @@ _cairo_bentley_ottmann_tessellate_rectilinear_polygon_to_boxes (const cairo_poly
 	events = _cairo_malloc_ab_plus_c (num_events,
 					  sizeof (cairo_bo_event_t) +
 					  sizeof (cairo_bo_edge_t) +
-					  sizeof (cairo_bo_event_t *),
+					  2*sizeof (cairo_bo_event_t *),
 					  sizeof (cairo_bo_event_t *));
 	if (unlikely (events == NULL))
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
 	event_ptrs = (cairo_bo_event_t **) (events + num_events);
 	edges = (cairo_bo_edge_t *) (event_ptrs + num_events + 1);
+	tmp = (cairo_bo_event_t **) (edges + num_events);
     }
 
     for (i = j = 0; i < polygon->num_edges; i++) {
@@ -494,7 +533,7 @@ _cairo_bentley_ottmann_tessellate_rectilinear_polygon_to_boxes (const cairo_poly
 	j++;
     }
 
-    status = _cairo_bentley_ottmann_tessellate_rectilinear (event_ptrs, j,
+    status = _cairo_bentley_ottmann_tessellate_rectilinear (event_ptrs, tmp, j,
 							    fill_rule,
 							    FALSE, boxes);
     if (events != stack_events)
@@ -513,6 +552,7 @@ _cairo_bentley_ottmann_tessellate_rectilinear_traps (cairo_traps_t *traps,
     cairo_bo_event_t **event_ptrs;
     cairo_bo_edge_t stack_edges[ARRAY_LENGTH (stack_events)];
     cairo_bo_edge_t *edges;
+    cairo_bo_event_t **tmp = NULL;
     cairo_status_t status;
     int i, j, k;
 
@@ -530,13 +570,14 @@ _cairo_bentley_ottmann_tessellate_rectilinear_traps (cairo_traps_t *traps,
 	events = _cairo_malloc_ab_plus_c (i,
 					  sizeof (cairo_bo_event_t) +
 					  sizeof (cairo_bo_edge_t) +
-					  sizeof (cairo_bo_event_t *),
+					  2*sizeof (cairo_bo_event_t *),
 					  sizeof (cairo_bo_event_t *));
 	if (unlikely (events == NULL))
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
 	event_ptrs = (cairo_bo_event_t **) (events + i);
 	edges = (cairo_bo_edge_t *) (event_ptrs + i + 1);
+	tmp = (cairo_bo_event_t **) (edges + i);
     }
 
     for (i = j = k = 0; i < traps->num_traps; i++) {
@@ -588,7 +629,7 @@ _cairo_bentley_ottmann_tessellate_rectilinear_traps (cairo_traps_t *traps,
     }
 
     _cairo_traps_clear (traps);
-    status = _cairo_bentley_ottmann_tessellate_rectilinear (event_ptrs, j,
+    status = _cairo_bentley_ottmann_tessellate_rectilinear (event_ptrs, tmp, j,
 							    fill_rule,
 							    TRUE, traps);
     traps->is_rectilinear = TRUE;
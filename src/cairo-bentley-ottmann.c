@@ -38,6 +38,7 @@
 /* Provide definitions for standalone compilation */
 #include "cairoint.h"
 
+#include "cairo-atomic-private.h"
 #include "cairo-combsort-inline.h"
 #include "cairo-error-private.h"
 #include "cairo-freelist-private.h"
@@ -121,6 +122,24 @@ typedef struct _cairo_bo_event_queue {
     cairo_bo_event_t **start_events;
 } cairo_bo_event_queue_t;
 
+/* Storage for the event queue and the start events is kept between
+ * tessellations in a cairo_bo_context_t, but only up to these sizes so
+ * that one huge polygon does not pin its memory for good.
+ */
+#define BO_CONTEXT_MAX_EVENTS (16 * 1024)
+#define BO_CONTEXT_MAX_POOL_SIZE (256 * 1024)
+
+typedef struct _cairo_bo_context {
+    cairo_bo_event_queue_t event_queue;
+
+    /* events_size start events, followed by events_size + 1 pointers */
+    cairo_bo_start_event_t *events;
+    int events_size;
+
+    cairo_bo_start_event_t **event_y;
+    int event_y_size;
+} cairo_bo_context_t;
+
 typedef struct _cairo_bo_sweep_line {
     cairo_bo_edge_t *head;
     cairo_bo_edge_t *stopped;
@@ -689,10 +708,10 @@ static cairo_status_t
 _pqueue_grow (pqueue_t *pq)
 {
     cairo_bo_event_t **new_elements;
-    pq->max_size *= 2;
+    int new_size = 2 * pq->max_size;
 
     if (pq->elements == pq->elements_embedded) {
-	new_elements = _cairo_malloc_ab (pq->max_size,
+	new_elements = _cairo_malloc_ab (new_size,
 					 sizeof (cairo_bo_event_t *));
 	if (unlikely (new_elements == NULL))
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
@@ -701,13 +720,14 @@ _pqueue_grow (pqueue_t *pq)
 		sizeof (pq->elements_embedded));
     } else {
 	new_elements = _cairo_realloc_ab (pq->elements,
-					  pq->max_size,
+					  new_size,
 					  sizeof (cairo_bo_event_t *));
 	if (unlikely (new_elements == NULL))
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
     }
 
     pq->elements = new_elements;
+    pq->max_size = new_size;
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -827,15 +847,20 @@ CAIRO_COMBSORT_DECLARE (_cairo_bo_event_queue_sort,
 			cairo_bo_event_compare)
 
 static void
-_cairo_bo_event_queue_init (cairo_bo_event_queue_t	 *event_queue,
-			    cairo_bo_event_t		**start_events,
-			    int				  num_events)
+_cairo_bo_event_queue_init (cairo_bo_event_queue_t *event_queue)
 {
-    event_queue->start_events = start_events;
+    event_queue->start_events = NULL;
 
     _cairo_freepool_init (&event_queue->pool,
 			  sizeof (cairo_bo_queue_event_t));
     _pqueue_init (&event_queue->pqueue);
+}
+
+static void
+_cairo_bo_event_queue_start (cairo_bo_event_queue_t	 *event_queue,
+			     cairo_bo_event_t		**start_events)
+{
+    event_queue->start_events = start_events;
     event_queue->pqueue.elements[PQ_FIRST_ENTRY] = NULL;
 }
 
@@ -861,6 +886,36 @@ _cairo_bo_event_queue_fini (cairo_bo_event_queue_t *event_queue)
     _cairo_freepool_fini (&event_queue->pool);
 }
 
+/* Empty the queue for reuse, keeping its storage unless it has grown
+ * beyond what a typical tessellation needs.
+ */
+static void
+_cairo_bo_event_queue_reset (cairo_bo_event_queue_t *event_queue)
+{
+    cairo_freelist_pool_t *pool;
+    unsigned int size;
+
+    event_queue->start_events = NULL;
+
+    event_queue->pqueue.size = 0;
+    if (event_queue->pqueue.max_size > BO_CONTEXT_MAX_EVENTS) {
+	_pqueue_fini (&event_queue->pqueue);
+	_pqueue_init (&event_queue->pqueue);
+    }
+
+    _cairo_freepool_reset (&event_queue->pool);
+    event_queue->pool.first_free_node = NULL;
+
+    size = 0;
+    for (pool = event_queue->pool.freepools; pool != NULL; pool = pool->next)
+	size += pool->size;
+    if (size > BO_CONTEXT_MAX_POOL_SIZE) {
+	_cairo_freepool_fini (&event_queue->pool);
+	_cairo_freepool_init (&event_queue->pool,
+			      sizeof (cairo_bo_queue_event_t));
+    }
+}
+
 static inline cairo_status_t
 _cairo_bo_event_queue_insert_if_intersect_below_current_y (cairo_bo_event_queue_t	*event_queue,
 							   cairo_bo_edge_t	*left,
@@ -1270,7 +1325,8 @@ _active_edges_to_traps (cairo_bo_edge_t	*pos,
  * generating trapezoids according to the fill_rule and appending them
  * to traps. */
 static cairo_status_t
-_cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
+_cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_queue_t *event_queue,
+					    cairo_bo_event_t   **start_events,
 					    int			 num_events,
 					    unsigned		 fill_rule,
 					    cairo_traps_t	*traps,
@@ -1278,7 +1334,6 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 {
     cairo_status_t status;
     int intersection_count = 0;
-    cairo_bo_event_queue_t event_queue;
     cairo_bo_sweep_line_t sweep_line;
     cairo_bo_event_t *event;
     cairo_bo_edge_t *left, *right;
@@ -1310,10 +1365,10 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
     }
 #endif
 
-    _cairo_bo_event_queue_init (&event_queue, start_events, num_events);
+    _cairo_bo_event_queue_start (event_queue, start_events);
     _cairo_bo_sweep_line_init (&sweep_line);
 
-    while ((event = _cairo_bo_event_dequeue (&event_queue))) {
+    while ((event = _cairo_bo_event_dequeue (event_queue))) {
 	if (event->point.y != sweep_line.current_y) {
 	    for (e1 = sweep_line.stopped; e1; e1 = e1->next) {
 		if (e1->deferred_trap.right != NULL) {
@@ -1346,7 +1401,7 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 
 	    _cairo_bo_sweep_line_insert (&sweep_line, e1);
 
-	    status = _cairo_bo_event_queue_insert_stop (&event_queue, e1);
+	    status = _cairo_bo_event_queue_insert_stop (event_queue, e1);
 	    if (unlikely (status))
 		goto unwind;
 
@@ -1371,13 +1426,13 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 	    right = e1->next;
 
 	    if (left != NULL) {
-		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (&event_queue, left, e1);
+		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (event_queue, left, e1);
 		if (unlikely (status))
 		    goto unwind;
 	    }
 
 	    if (right != NULL) {
-		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (&event_queue, e1, right);
+		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (event_queue, e1, right);
 		if (unlikely (status))
 		    goto unwind;
 	    }
@@ -1386,7 +1441,7 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 
 	case CAIRO_BO_EVENT_TYPE_STOP:
 	    e1 = ((cairo_bo_queue_event_t *) event)->e1;
-	    _cairo_bo_event_queue_delete (&event_queue, event);
+	    _cairo_bo_event_queue_delete (event_queue, event);
 
 	    left = e1->prev;
 	    right = e1->next;
@@ -1403,7 +1458,7 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 	    }
 
 	    if (left != NULL && right != NULL) {
-		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (&event_queue, left, right);
+		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (event_queue, left, right);
 		if (unlikely (status))
 		    goto unwind;
 	    }
@@ -1413,7 +1468,7 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 	case CAIRO_BO_EVENT_TYPE_INTERSECTION:
 	    e1 = ((cairo_bo_queue_event_t *) event)->e1;
 	    e2 = ((cairo_bo_queue_event_t *) event)->e2;
-	    _cairo_bo_event_queue_delete (&event_queue, event);
+	    _cairo_bo_event_queue_delete (event_queue, event);
 
 	    /* skip this intersection if its edges are not adjacent */
 	    if (e2 != e1->next)
@@ -1429,13 +1484,13 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 	    /* after the swap e2 is left of e1 */
 
 	    if (left != NULL) {
-		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (&event_queue, left, e2);
+		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (event_queue, left, e2);
 		if (unlikely (status))
 		    goto unwind;
 	    }
 
 	    if (right != NULL) {
-		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (&event_queue, e1, right);
+		status = _cairo_bo_event_queue_insert_if_intersect_below_current_y (event_queue, e1, right);
 		if (unlikely (status))
 		    goto unwind;
 	    }
@@ -1452,7 +1507,6 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
     }
     status = traps->status;
  unwind:
-    _cairo_bo_event_queue_fini (&event_queue);
 
 #if DEBUG_EVENTS
     event_log ("\n");
@@ -1461,6 +1515,130 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
     return status;
 }
 
+/* A single context is cached for reuse. Whoever takes it owns it until
+ * it is returned; concurrent tessellations simply allocate their own and
+ * the spare is discarded when the slot is already filled.
+ */
+static cairo_bo_context_t *_cairo_bo_context_cache;
+
+static cairo_bo_context_t *
+_cairo_bo_context_get (void)
+{
+    cairo_bo_context_t *context;
+
+    context = _cairo_atomic_ptr_get ((void **) &_cairo_bo_context_cache);
+    if (context != NULL &&
+	_cairo_atomic_ptr_cmpxchg ((void **) &_cairo_bo_context_cache,
+				   context, NULL))
+    {
+	return context;
+    }
+
+    context = _cairo_malloc (sizeof (cairo_bo_context_t));
+    if (unlikely (context == NULL))
+	return NULL;
+
+    _cairo_bo_event_queue_init (&context->event_queue);
+
+    context->events = NULL;
+    context->events_size = 0;
+
+    context->event_y = NULL;
+    context->event_y_size = 0;
+
+    return context;
+}
+
+static void
+_cairo_bo_context_destroy (cairo_bo_context_t *context)
+{
+    _cairo_bo_event_queue_fini (&context->event_queue);
+    free (context->events);
+    free (context->event_y);
+    free (context);
+}
+
+static void
+_cairo_bo_context_put (cairo_bo_context_t *context)
+{
+    _cairo_bo_event_queue_reset (&context->event_queue);
+
+    if (context->events_size > BO_CONTEXT_MAX_EVENTS) {
+	free (context->events);
+	context->events = NULL;
+	context->events_size = 0;
+    }
+
+    if (context->event_y_size > BO_CONTEXT_MAX_EVENTS) {
+	free (context->event_y);
+	context->event_y = NULL;
+	context->event_y_size = 0;
+    }
+
+    if (! _cairo_atomic_ptr_cmpxchg ((void **) &_cairo_bo_context_cache,
+				     NULL, context))
+    {
+	_cairo_bo_context_destroy (context);
+    }
+}
+
+static cairo_status_t
+_cairo_bo_context_reserve_events (cairo_bo_context_t *context,
+				  int num_events)
+{
+    cairo_bo_start_event_t *events;
+
+    if (num_events <= context->events_size)
+	return CAIRO_STATUS_SUCCESS;
+
+    events = _cairo_malloc_ab_plus_c (num_events,
+				      sizeof (cairo_bo_start_event_t) +
+				      sizeof (cairo_bo_event_t *),
+				      sizeof (cairo_bo_event_t *));
+    if (unlikely (events == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    free (context->events);
+    context->events = events;
+    context->events_size = num_events;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_bo_context_reserve_event_y (cairo_bo_context_t *context,
+				   int num_rows)
+{
+    cairo_bo_start_event_t **event_y;
+
+    if (num_rows <= context->event_y_size)
+	return CAIRO_STATUS_SUCCESS;
+
+    event_y = _cairo_malloc_ab (num_rows, sizeof (cairo_bo_start_event_t *));
+    if (unlikely (event_y == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    free (context->event_y);
+    context->event_y = event_y;
+    context->event_y_size = num_rows;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+void
+_cairo_bentley_ottmann_reset_static_data (void)
+{
+    cairo_bo_context_t *context;
+
+    context = _cairo_atomic_ptr_get ((void **) &_cairo_bo_context_cache);
+    if (context != NULL &&
+	_cairo_atomic_ptr_cmpxchg ((void **) &_cairo_bo_context_cache,
+				   context, NULL))
+    {
+	_cairo_bo_context_destroy (context);
+    }
+}
+
 cairo_status_t
 _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
 					   const cairo_polygon_t *polygon,
@@ -1473,6 +1651,9 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
     cairo_bo_event_t **event_ptrs;
     cairo_bo_start_event_t *stack_event_y[64];
     cairo_bo_start_event_t **event_y = NULL;
+    cairo_bo_event_queue_t stack_event_queue;
+    cairo_bo_event_queue_t *event_queue;
+    cairo_bo_context_t *context = NULL;
     int i, num_events, y, ymin, ymax;
     cairo_status_t status;
 
@@ -1480,29 +1661,54 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
     if (unlikely (0 == num_events))
 	return CAIRO_STATUS_SUCCESS;
 
+    /* Small polygons fit on the stack; larger ones borrow the cached
+     * context so that their event arrays, priority queue and event pool
+     * need not be allocated afresh each time.
+     */
+    events = stack_events;
+    event_ptrs = stack_event_ptrs;
+    event_queue = &stack_event_queue;
+    if (num_events > ARRAY_LENGTH (stack_events)) {
+	context = _cairo_bo_context_get ();
+	if (unlikely (context == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+	status = _cairo_bo_context_reserve_events (context, num_events);
+	if (unlikely (status)) {
+	    _cairo_bo_context_put (context);
+	    return status;
+	}
+
+	events = context->events;
+	event_ptrs = (cairo_bo_event_t **) (events + context->events_size);
+	event_queue = &context->event_queue;
+    }
+
     if (polygon->num_limits) {
 	ymin = _cairo_fixed_integer_floor (polygon->limit.p1.y);
 	ymax = _cairo_fixed_integer_ceil (polygon->limit.p2.y) - ymin;
 
-	if (ymax > 64)
-	    event_y = _cairo_malloc_ab(sizeof (cairo_bo_event_t*), ymax);
-	else
-	    event_y = stack_event_y;
+	event_y = stack_event_y;
+	if (ymax > ARRAY_LENGTH (stack_event_y)) {
+	    if (context != NULL) {
+		status = _cairo_bo_context_reserve_event_y (context, ymax);
+		if (unlikely (status)) {
+		    _cairo_bo_context_put (context);
+		    return status;
+		}
+
+		event_y = context->event_y;
+	    } else {
+		event_y = _cairo_malloc_ab (ymax, sizeof (cairo_bo_event_t *));
+		if (unlikely (event_y == NULL))
+		    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    }
+	}
 	memset (event_y, 0, ymax * sizeof(cairo_bo_event_t *));
     }
 
-    events = stack_events;
-    event_ptrs = stack_event_ptrs;
-    if (num_events > ARRAY_LENGTH (stack_events)) {
-	events = _cairo_malloc_ab_plus_c (num_events,
-					  sizeof (cairo_bo_start_event_t) +
-					  sizeof (cairo_bo_event_t *),
-					  sizeof (cairo_bo_event_t *));
-	if (unlikely (events == NULL))
-	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-
-	event_ptrs = (cairo_bo_event_t **) (events + num_events);
-    }
+    if (context == NULL)
+	_cairo_bo_event_queue_init (event_queue);
 
     for (i = 0; i < num_events; i++) {
 	events[i].type = CAIRO_BO_EVENT_TYPE_START;
@@ -1534,7 +1740,7 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
 	    if (i > j + 1)
 		_cairo_bo_event_queue_sort (event_ptrs+j, i-j);
 	}
-	if (event_y != stack_event_y)
+	if (event_y != stack_event_y && context == NULL)
 	    free (event_y);
     } else
 	_cairo_bo_event_queue_sort (event_ptrs, i);
@@ -1548,15 +1754,18 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
      * passes of the Bentley-Ottmann algorithm. It would merely
      * require storing the results of each pass into a temporary
      * cairo_traps_t. */
-    status = _cairo_bentley_ottmann_tessellate_bo_edges (event_ptrs, num_events,
+    status = _cairo_bentley_ottmann_tessellate_bo_edges (event_queue,
+							 event_ptrs, num_events,
 							 fill_rule, traps,
 							 &intersections);
 #if DEBUG_TRAPS
     dump_traps (traps, "bo-polygon-out.txt");
 #endif
 
-    if (events != stack_events)
-	free (events);
+    if (context != NULL)
+	_cairo_bo_context_put (context);
+    else
+	_cairo_bo_event_queue_fini (event_queue);
 
     return status;
 }
@@ -41,9 +41,11 @@
 
 #include "cairoint.h"
 
+#include "cairo-atomic-private.h"
 #include "cairo-box-inline.h"
 #include "cairo-clip-inline.h"
 #include "cairo-clip-private.h"
+#include "cairo-combsort-inline.h"
 #include "cairo-error-private.h"
 #include "cairo-freed-pool-private.h"
 #include "cairo-gstate-private.h"
@@ -65,12 +67,107 @@ pot (int v)
     return v;
 }
 
+/* Clips with at least this many boxes, such as those built from damage
+ * regions, keep a copy of their boxes sorted by top edge so that the few
+ * near a given rectangle can be found without visiting all of them.
+ */
+#define CLIP_BOXES_INDEX_MIN 32
+
+struct _cairo_clip_boxes_index {
+    int num_boxes;
+    cairo_box_t *boxes;		/* sorted by p1.y */
+    cairo_fixed_t *bottom;	/* the lowest p2.y of boxes[0] to boxes[i] */
+};
+
+#define _box_top_compare(a, b) ((a).p1.y < (b).p1.y ? -1 : (a).p1.y > (b).p1.y)
+CAIRO_COMBSORT_DECLARE (_sort_boxes_by_top, cairo_box_t, _box_top_compare)
+
+static const cairo_clip_boxes_index_t *
+_cairo_clip_get_boxes_index (const cairo_clip_t *clip)
+{
+    cairo_clip_boxes_index_t *index;
+    cairo_fixed_t bottom;
+    int i;
+
+    if (clip->num_boxes < CLIP_BOXES_INDEX_MIN)
+	return NULL;
+
+    index = clip->index;
+    if (index != NULL)
+	return index;
+
+    index = _cairo_malloc_ab_plus_c (clip->num_boxes,
+				     sizeof (cairo_box_t) + sizeof (cairo_fixed_t),
+				     sizeof (cairo_clip_boxes_index_t));
+    if (unlikely (index == NULL))
+	return NULL;
+
+    index->num_boxes = clip->num_boxes;
+    index->boxes = (cairo_box_t *) (index + 1);
+    index->bottom = (cairo_fixed_t *) (index->boxes + index->num_boxes);
+
+    memcpy (index->boxes, clip->boxes, clip->num_boxes * sizeof (cairo_box_t));
+    _sort_boxes_by_top (index->boxes, index->num_boxes);
+
+    bottom = index->boxes[0].p2.y;
+    for (i = 0; i < index->num_boxes; i++) {
+	if (index->boxes[i].p2.y > bottom)
+	    bottom = index->boxes[i].p2.y;
+	index->bottom[i] = bottom;
+    }
+
+    /* The clip is otherwise unchanged, so attach the index lazily */
+    if (! _cairo_atomic_ptr_cmpxchg (&((cairo_clip_t *) clip)->index,
+				     NULL, index))
+    {
+	free (index);
+	index = clip->index;
+    }
+
+    return index;
+}
+
+/* Find the range [*lo, *hi) of the sorted boxes that may overlap the rows
+ * between y1 and y2: those starting above y2, after the last of them to
+ * end above y1.
+ */
+static void
+_cairo_clip_boxes_index_find (const cairo_clip_boxes_index_t *index,
+			      cairo_fixed_t y1, cairo_fixed_t y2,
+			      int *lo, int *hi)
+{
+    int min, max, mid;
+
+    min = 0;
+    max = index->num_boxes;
+    while (min < max) {
+	mid = (min + max) / 2;
+	if (index->bottom[mid] > y1)
+	    max = mid;
+	else
+	    min = mid + 1;
+    }
+    *lo = min;
+
+    max = index->num_boxes;
+    while (min < max) {
+	mid = (min + max) / 2;
+	if (index->boxes[mid].p1.y < y2)
+	    min = mid + 1;
+	else
+	    max = mid;
+    }
+    *hi = min;
+}
+
 static cairo_bool_t
 _cairo_clip_contains_rectangle_box (const cairo_clip_t *clip,
 				    const cairo_rectangle_int_t *rect,
 				    const cairo_box_t *box)
 {
-    int i;
+    const cairo_clip_boxes_index_t *index;
+    const cairo_box_t *boxes;
+    int i, num_boxes;
 
     /* clip == NULL means no clip, so the clip contains everything */
     if (clip == NULL)
@@ -89,12 +186,24 @@ _cairo_clip_contains_rectangle_box (const cairo_clip_t *clip,
     if (clip->num_boxes == 0)
 	return TRUE;
 
+    boxes = clip->boxes;
+    num_boxes = clip->num_boxes;
+
+    index = _cairo_clip_get_boxes_index (clip);
+    if (index != NULL) {
+	int lo, hi;
+
+	_cairo_clip_boxes_index_find (index, box->p1.y, box->p2.y, &lo, &hi);
+	boxes = index->boxes + lo;
+	num_boxes = hi - lo;
+    }
+
     /* Check for a clip-box that wholly contains the rectangle */
-    for (i = 0; i < clip->num_boxes; i++) {
-	if (box->p1.x >= clip->boxes[i].p1.x &&
-	    box->p1.y >= clip->boxes[i].p1.y &&
-	    box->p2.x <= clip->boxes[i].p2.x &&
-	    box->p2.y <= clip->boxes[i].p2.y)
+    for (i = 0; i < num_boxes; i++) {
+	if (box->p1.x >= boxes[i].p1.x &&
+	    box->p1.y >= boxes[i].p1.y &&
+	    box->p2.x <= boxes[i].p2.x &&
+	    box->p2.y <= boxes[i].p2.y)
 	{
 	    return TRUE;
 	}
@@ -218,6 +327,8 @@ _cairo_clip_intersect_rectangle_box (cairo_clip_t *clip,
     if (! changed)
 	return clip;
 
+    _cairo_clip_drop_index (clip);
+
     extents_box = clip->boxes[0];
     for (i = 1; i < clip->num_boxes; i++) {
 	    if (clip->boxes[i].p1.x < extents_box.p1.x)
@@ -297,6 +408,7 @@ _cairo_clip_intersect_boxes (cairo_clip_t *clip,
 
 	if (clip->boxes != &clip->embedded_box)
 	    free (clip->boxes);
+	_cairo_clip_drop_index (clip);
 
 	clip->boxes = NULL;
 	boxes = &clip_boxes;
@@ -355,6 +467,97 @@ _cairo_clip_intersect_rectangle (cairo_clip_t       *clip,
     return _cairo_clip_intersect_rectangle_box (clip, r, &box);
 }
 
+cairo_clip_t *
+_cairo_clip_copy_intersect_rectangle (const cairo_clip_t *clip,
+				      const cairo_rectangle_int_t *r)
+{
+    const cairo_clip_boxes_index_t *index;
+    cairo_clip_t *copy;
+    cairo_box_t box, extents;
+    int lo, hi, i, n;
+
+    if (clip == NULL || _cairo_clip_is_all_clipped (clip))
+	return _cairo_clip_intersect_rectangle (_cairo_clip_copy (clip), r);
+
+    if (r->width == 0 || r->height == 0)
+	return _cairo_clip_intersect_rectangle (_cairo_clip_copy (clip), r);
+
+    /* Rather than copy every box only to discard most of them, copy just
+     * those that overlap the rectangle, clipped to it.
+     */
+    index = _cairo_clip_get_boxes_index (clip);
+    if (index == NULL)
+	return _cairo_clip_intersect_rectangle (_cairo_clip_copy (clip), r);
+
+    _cairo_box_from_rectangle (&box, r);
+    _cairo_clip_boxes_index_find (index, box.p1.y, box.p2.y, &lo, &hi);
+    if (lo == hi)
+	return _cairo_clip_set_all_clipped (NULL);
+
+    copy = _cairo_clip_create ();
+    if (unlikely (copy == NULL))
+	return _cairo_clip_set_all_clipped (copy);
+
+    if (hi - lo == 1) {
+	copy->boxes = &copy->embedded_box;
+    } else {
+	copy->boxes = _cairo_malloc_ab (hi - lo, sizeof (cairo_box_t));
+	if (unlikely (copy->boxes == NULL))
+	    return _cairo_clip_set_all_clipped (copy);
+    }
+
+    for (i = lo, n = 0; i < hi; i++) {
+	cairo_box_t *b = &copy->boxes[n];
+
+	*b = index->boxes[i];
+	if (b->p1.x < box.p1.x)
+	    b->p1.x = box.p1.x;
+	if (b->p2.x > box.p2.x)
+	    b->p2.x = box.p2.x;
+	if (b->p1.y < box.p1.y)
+	    b->p1.y = box.p1.y;
+	if (b->p2.y > box.p2.y)
+	    b->p2.y = box.p2.y;
+
+	if (b->p2.x <= b->p1.x || b->p2.y <= b->p1.y)
+	    continue;
+
+	if (n == 0) {
+	    extents = *b;
+	} else {
+	    if (b->p1.x < extents.p1.x)
+		extents.p1.x = b->p1.x;
+	    if (b->p1.y < extents.p1.y)
+		extents.p1.y = b->p1.y;
+	    if (b->p2.x > extents.p2.x)
+		extents.p2.x = b->p2.x;
+	    if (b->p2.y > extents.p2.y)
+		extents.p2.y = b->p2.y;
+	}
+	n++;
+    }
+    copy->num_boxes = n;
+
+    if (n == 0)
+	return _cairo_clip_set_all_clipped (copy);
+
+    if (n == 1 && copy->boxes != &copy->embedded_box) {
+	copy->embedded_box = copy->boxes[0];
+	free (copy->boxes);
+	copy->boxes = &copy->embedded_box;
+    }
+
+    _cairo_box_round_to_rectangle (&extents, &copy->extents);
+    if (clip->path) {
+	if (! _cairo_rectangle_intersect (&copy->extents, &clip->extents))
+	    return _cairo_clip_set_all_clipped (copy);
+
+	copy->path = _cairo_clip_path_reference (clip->path);
+    }
+
+    return copy;
+}
+
 struct reduce {
     cairo_clip_t *clip;
     cairo_box_t limit;
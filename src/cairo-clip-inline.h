@@ -51,13 +51,6 @@ _cairo_clip_set_all_clipped (cairo_clip_t *clip)
     return (cairo_clip_t *) &__cairo_clip_all;
 }
 
-static inline cairo_clip_t *
-_cairo_clip_copy_intersect_rectangle (const cairo_clip_t       *clip,
-				      const cairo_rectangle_int_t *r)
-{
-    return _cairo_clip_intersect_rectangle (_cairo_clip_copy (clip), r);
-}
-
 static inline cairo_clip_t *
 _cairo_clip_copy_intersect_clip (const cairo_clip_t *clip,
 				 const cairo_clip_t *other)
@@ -65,6 +58,13 @@ _cairo_clip_copy_intersect_clip (const cairo_clip_t *clip,
     return _cairo_clip_intersect_clip (_cairo_clip_copy (clip), other);
 }
 
+static inline void
+_cairo_clip_drop_index (cairo_clip_t *clip)
+{
+    free (clip->index);
+    clip->index = NULL;
+}
+
 static inline void
 _cairo_clip_steal_boxes (cairo_clip_t *clip, cairo_boxes_t *boxes)
 {
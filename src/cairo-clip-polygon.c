@@ -36,6 +36,7 @@
  */
 
 #include "cairoint.h"
+#include "cairo-atomic-private.h"
 #include "cairo-clip-inline.h"
 #include "cairo-clip-private.h"
 #include "cairo-error-private.h"
@@ -60,6 +61,76 @@ can_convert_to_polygon (const cairo_clip_t *clip)
     return TRUE;
 }
 
+static cairo_status_t
+_cairo_clip_path_fill_to_polygon (const cairo_clip_path_t *clip_path,
+				  cairo_polygon_t *polygon)
+{
+    cairo_fill_rule_t fill_rule = clip_path->fill_rule;
+    cairo_status_t status;
+
+    _cairo_polygon_init (polygon, NULL, 0);
+    status = _cairo_path_fixed_fill_to_polygon (&clip_path->path,
+						clip_path->tolerance,
+						polygon);
+    if (unlikely (status))
+	return status;
+
+    while ((clip_path = clip_path->prev) != NULL) {
+	cairo_polygon_t next;
+
+	_cairo_polygon_init (&next, NULL, 0);
+	status = _cairo_path_fixed_fill_to_polygon (&clip_path->path,
+						    clip_path->tolerance,
+						    &next);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+		status = _cairo_polygon_intersect (polygon, fill_rule,
+						   &next, clip_path->fill_rule);
+	_cairo_polygon_fini (&next);
+	if (unlikely (status))
+	    return status;
+
+	fill_rule = CAIRO_FILL_RULE_WINDING;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Looks up the polygon covered by the whole chain of clip paths, to be
+ * filled with the rule of the outermost path if it is alone in the chain
+ * and the winding rule otherwise. The reduction is computed once and
+ * shared by every clip derived from the path.
+ */
+static cairo_status_t
+_cairo_clip_path_get_polygon (cairo_clip_path_t *clip_path,
+			      const cairo_polygon_t **out)
+{
+    cairo_polygon_t *polygon;
+    cairo_status_t status;
+
+    polygon = clip_path->polygon;
+    if (polygon == NULL) {
+	polygon = malloc (sizeof (cairo_polygon_t));
+	if (unlikely (polygon == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+	status = _cairo_clip_path_fill_to_polygon (clip_path, polygon);
+	if (unlikely (status)) {
+	    _cairo_polygon_fini (polygon);
+	    free (polygon);
+	    return status;
+	}
+
+	if (! _cairo_atomic_ptr_cmpxchg (&clip_path->polygon, NULL, polygon)) {
+	    _cairo_polygon_fini (polygon);
+	    free (polygon);
+	    polygon = clip_path->polygon;
+	}
+    }
+
+    *out = polygon;
+    return CAIRO_STATUS_SUCCESS;
+}
+
 cairo_int_status_t
 _cairo_clip_get_polygon (const cairo_clip_t *clip,
 			 cairo_polygon_t *polygon,
@@ -67,7 +138,8 @@ _cairo_clip_get_polygon (const cairo_clip_t *clip,
 			 cairo_antialias_t *antialias)
 {
     cairo_status_t status;
-    cairo_clip_path_t *clip_path;
+    const cairo_polygon_t *cached;
+    int n;
 
     if (_cairo_clip_is_all_clipped (clip)) {
 	_cairo_polygon_init (polygon, NULL, 0);
@@ -89,20 +161,28 @@ _cairo_clip_get_polygon (const cairo_clip_t *clip,
     if (! can_convert_to_polygon (clip))
 	return CAIRO_INT_STATUS_UNSUPPORTED;
 
+    status = _cairo_clip_path_get_polygon (clip->path, &cached);
+    if (unlikely (status))
+	return status;
+
     if (clip->num_boxes < 2)
 	_cairo_polygon_init_with_clip (polygon, clip);
     else
 	_cairo_polygon_init_with_clip (polygon, NULL);
 
-    clip_path = clip->path;
-    *fill_rule = clip_path->fill_rule;
-    *antialias = clip_path->antialias;
+    *fill_rule = clip->path->prev ? CAIRO_FILL_RULE_WINDING : clip->path->fill_rule;
+    *antialias = clip->path->antialias;
 
-    status = _cairo_path_fixed_fill_to_polygon (&clip_path->path,
-						clip_path->tolerance,
-						polygon);
-    if (unlikely (status))
-	goto err;
+    /* Trim the shared polygon to the extents of this clip */
+    for (n = 0; n < cached->num_edges; n++) {
+	const cairo_edge_t *edge = &cached->edges[n];
+
+	status = _cairo_polygon_add_line (polygon, &edge->line,
+					  edge->top, edge->bottom,
+					  edge->dir);
+	if (unlikely (status))
+	    goto err;
+    }
 
     if (clip->num_boxes > 1) {
 	status = _cairo_polygon_intersect_with_boxes (polygon, fill_rule,
@@ -114,23 +194,6 @@ _cairo_clip_get_polygon (const cairo_clip_t *clip,
     polygon->limits = NULL;
     polygon->num_limits = 0;
 
-    while ((clip_path = clip_path->prev) != NULL) {
-	cairo_polygon_t next;
-
-	_cairo_polygon_init (&next, NULL, 0);
-	status = _cairo_path_fixed_fill_to_polygon (&clip_path->path,
-						    clip_path->tolerance,
-						    &next);
-	if (likely (status == CAIRO_STATUS_SUCCESS))
-		status = _cairo_polygon_intersect (polygon, *fill_rule,
-						   &next, clip_path->fill_rule);
-	_cairo_polygon_fini (&next);
-	if (unlikely (status))
-	    goto err;
-
-	*fill_rule = CAIRO_FILL_RULE_WINDING;
-    }
-
     return CAIRO_STATUS_SUCCESS;
 
 err:
@@ -43,11 +43,28 @@
 #include "cairo-error-private.h"
 #include "cairo-compiler-private.h"
 #include "cairo-error-private.h"
+#include "cairo-list-private.h"
 #include "cairo-path-fixed-private.h"
 #include "cairo-reference-count-private.h"
 
 extern const cairo_private cairo_rectangle_list_t _cairo_rectangles_nil;
 
+/* The mask of a clip path chain rendered for one type of target, covering
+ * the extents of the chain. The masks of all clip paths are kept on a
+ * global list, and the least recently used are released beyond a total
+ * size.
+ */
+typedef struct _cairo_clip_mask {
+    cairo_list_t link;
+    cairo_clip_path_t *clip_path;
+    unsigned long size;
+
+    const cairo_surface_backend_t *backend;
+    cairo_device_t *device; /* referenced, so as never to match a new one */
+    cairo_surface_t *surface;
+    int x, y;
+} cairo_clip_mask_t;
+
 struct _cairo_clip_path {
     cairo_reference_count_t	 ref_count;
     cairo_path_fixed_t		 path;
@@ -55,14 +72,27 @@ struct _cairo_clip_path {
     double			 tolerance;
     cairo_antialias_t		 antialias;
     cairo_clip_path_t		*prev;
+
+    /* A clip path is immutable once created and shared between every clip
+     * derived from it, so what it rasterises to is computed on first use
+     * and kept for the lifetime of the path. Intersecting a clip with a
+     * new path creates a new clip path, leaving these valid. The mask may
+     * be released earlier to bound the memory held by all clip masks, and
+     * is only accessed under _cairo_clip_mask_mutex.
+     */
+    cairo_polygon_t		*polygon;
+    cairo_clip_mask_t		*mask;
 };
 
+typedef struct _cairo_clip_boxes_index cairo_clip_boxes_index_t;
+
 struct _cairo_clip {
     cairo_rectangle_int_t extents;
     cairo_clip_path_t *path;
 
     cairo_box_t *boxes;
     int num_boxes;
+    cairo_clip_boxes_index_t *index;
 
     cairo_region_t *region;
     cairo_bool_t is_region;
@@ -79,6 +109,9 @@ _cairo_clip_path_reference (cairo_clip_path_t *clip_path);
 cairo_private void
 _cairo_clip_path_destroy (cairo_clip_path_t *clip_path);
 
+cairo_private void
+_cairo_clip_path_release_mask (cairo_clip_path_t *clip_path);
+
 cairo_private void
 _cairo_clip_destroy (cairo_clip_t *clip);
 
@@ -110,6 +143,10 @@ cairo_private cairo_clip_t *
 _cairo_clip_intersect_rectangle (cairo_clip_t       *clip,
 				 const cairo_rectangle_int_t *rectangle);
 
+cairo_private cairo_clip_t *
+_cairo_clip_copy_intersect_rectangle (const cairo_clip_t *clip,
+				      const cairo_rectangle_int_t *r);
+
 cairo_private cairo_clip_t *
 _cairo_clip_intersect_clip (cairo_clip_t *clip,
 			    const cairo_clip_t *other);
@@ -141,6 +178,11 @@ _cairo_clip_get_extents (const cairo_clip_t *clip);
 cairo_private cairo_surface_t *
 _cairo_clip_get_surface (const cairo_clip_t *clip, cairo_surface_t *dst, int *tx, int *ty);
 
+cairo_private cairo_surface_t *
+_cairo_clip_get_shared_surface (const cairo_clip_t *clip,
+				cairo_surface_t *target,
+				int *tx, int *ty);
+
 cairo_private cairo_surface_t *
 _cairo_clip_get_image (const cairo_clip_t *clip,
 		       cairo_surface_t *target,
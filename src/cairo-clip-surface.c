@@ -40,10 +40,12 @@
  */
 
 #include "cairoint.h"
+#include "cairo-box-inline.h"
 #include "cairo-clip-private.h"
 #include "cairo-error-private.h"
 #include "cairo-freed-pool-private.h"
 #include "cairo-gstate-private.h"
+#include "cairo-list-inline.h"
 #include "cairo-path-fixed-private.h"
 #include "cairo-pattern-private.h"
 #include "cairo-composite-rectangles-private.h"
@@ -118,6 +120,206 @@ _cairo_path_fixed_add_box (cairo_path_fixed_t *path,
     return _cairo_path_fixed_close_path (path);
 }
 
+/* Masks larger than this many pixels are not kept with the clip path */
+#define CLIP_MASK_CACHE_MAX_SIZE (4 << 20)
+
+/* nor are more than this many pixels kept over all clip paths */
+#define CLIP_MASK_CACHE_MAX_TOTAL (32 << 20)
+
+static cairo_list_t _cairo_clip_mask_lru = {
+    &_cairo_clip_mask_lru, &_cairo_clip_mask_lru
+};
+static unsigned long _cairo_clip_mask_total;
+
+static void
+_cairo_clip_mask_destroy (cairo_clip_mask_t *mask)
+{
+    cairo_surface_destroy (mask->surface);
+    cairo_device_destroy (mask->device);
+    free (mask);
+}
+
+/* Detaches the mask from its clip path; called with the mutex held */
+static void
+_cairo_clip_mask_unlink (cairo_clip_mask_t *mask)
+{
+    cairo_list_del (&mask->link);
+    _cairo_clip_mask_total -= mask->size;
+    mask->clip_path->mask = NULL;
+}
+
+void
+_cairo_clip_path_release_mask (cairo_clip_path_t *clip_path)
+{
+    cairo_clip_mask_t *mask;
+
+    CAIRO_MUTEX_LOCK (_cairo_clip_mask_mutex);
+    mask = clip_path->mask;
+    if (mask != NULL)
+	_cairo_clip_mask_unlink (mask);
+    CAIRO_MUTEX_UNLOCK (_cairo_clip_mask_mutex);
+
+    if (mask != NULL)
+	_cairo_clip_mask_destroy (mask);
+}
+
+static cairo_status_t
+_cairo_clip_path_render_mask (const cairo_clip_path_t *clip_path,
+			      cairo_surface_t *target,
+			      const cairo_rectangle_int_t *extents,
+			      cairo_surface_t **out)
+{
+    cairo_surface_t *surface;
+    cairo_status_t status;
+    cairo_fixed_t fx, fy;
+
+    surface = _cairo_surface_create_scratch (target,
+					     CAIRO_CONTENT_ALPHA,
+					     extents->width,
+					     extents->height,
+					     CAIRO_COLOR_WHITE);
+    if (unlikely (surface->status))
+	return surface->status;
+
+    fx = -_cairo_fixed_from_int (extents->x);
+    fy = -_cairo_fixed_from_int (extents->y);
+
+    status = CAIRO_STATUS_SUCCESS;
+    do {
+	cairo_path_fixed_t path;
+
+	status = _cairo_path_fixed_init_copy (&path, &clip_path->path);
+	if (unlikely (status))
+	    break;
+
+	_cairo_path_fixed_translate (&path, fx, fy);
+	status = _cairo_surface_fill (surface,
+				      CAIRO_OPERATOR_IN,
+				      &_cairo_pattern_white.base,
+				      &path,
+				      clip_path->fill_rule,
+				      clip_path->tolerance,
+				      clip_path->antialias,
+				      NULL);
+	_cairo_path_fixed_fini (&path);
+    } while (status == CAIRO_STATUS_SUCCESS &&
+	     (clip_path = clip_path->prev) != NULL);
+
+    if (unlikely (status)) {
+	cairo_surface_destroy (surface);
+	return status;
+    }
+
+    *out = surface;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Returns a reference to the mask of the whole chain of clip paths as
+ * rendered for @target, with its origin in @x, @y. The mask is rendered
+ * and attached to the clip path on first use so that every clip sharing
+ * the path reuses it. Returns NULL if the mask would be too large to keep,
+ * or was rendered for a different kind of target.
+ */
+static cairo_surface_t *
+_cairo_clip_path_get_mask (cairo_clip_path_t *clip_path,
+			   cairo_surface_t *target,
+			   int *x, int *y,
+			   cairo_status_t *status)
+{
+    const cairo_clip_path_t *iter;
+    cairo_clip_mask_t *mask;
+    cairo_rectangle_int_t extents;
+    cairo_surface_t *surface;
+    cairo_list_t evicted;
+
+    *status = CAIRO_STATUS_SUCCESS;
+
+    CAIRO_MUTEX_LOCK (_cairo_clip_mask_mutex);
+    mask = clip_path->mask;
+    surface = NULL;
+    if (mask != NULL &&
+	mask->backend == target->backend && mask->device == target->device)
+    {
+	cairo_list_move_tail (&mask->link, &_cairo_clip_mask_lru);
+	surface = cairo_surface_reference (mask->surface);
+	*x = mask->x;
+	*y = mask->y;
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_clip_mask_mutex);
+    if (mask != NULL)
+	return surface;
+
+    _cairo_path_fixed_approximate_clip_extents (&clip_path->path, &extents);
+    for (iter = clip_path->prev; iter != NULL; iter = iter->prev) {
+	cairo_rectangle_int_t r;
+
+	_cairo_path_fixed_approximate_clip_extents (&iter->path, &r);
+	if (! _cairo_rectangle_intersect (&extents, &r))
+	    return NULL;
+    }
+
+    if ((double) extents.width * extents.height > CLIP_MASK_CACHE_MAX_SIZE)
+	return NULL;
+
+    mask = malloc (sizeof (cairo_clip_mask_t));
+    if (unlikely (mask == NULL)) {
+	*status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	return NULL;
+    }
+
+    *status = _cairo_clip_path_render_mask (clip_path, target,
+					    &extents, &mask->surface);
+    if (unlikely (*status)) {
+	free (mask);
+	return NULL;
+    }
+
+    mask->clip_path = clip_path;
+    mask->size = (unsigned long) extents.width * extents.height;
+    mask->backend = target->backend;
+    mask->device = cairo_device_reference (target->device);
+    mask->x = *x = extents.x;
+    mask->y = *y = extents.y;
+    surface = cairo_surface_reference (mask->surface);
+
+    /* Release the least recently used masks beyond the total, outside of
+     * the lock since that may call into the backend.
+     */
+    cairo_list_init (&evicted);
+    CAIRO_MUTEX_LOCK (_cairo_clip_mask_mutex);
+    if (clip_path->mask == NULL) {
+	cairo_list_add_tail (&mask->link, &_cairo_clip_mask_lru);
+	_cairo_clip_mask_total += mask->size;
+	clip_path->mask = mask;
+
+	while (_cairo_clip_mask_total > CLIP_MASK_CACHE_MAX_TOTAL) {
+	    cairo_clip_mask_t *old;
+
+	    old = cairo_list_first_entry (&_cairo_clip_mask_lru,
+					  cairo_clip_mask_t, link);
+	    if (old == mask)
+		break;
+
+	    _cairo_clip_mask_unlink (old);
+	    cairo_list_add (&old->link, &evicted);
+	}
+    } else {
+	/* rendered concurrently by another thread, keep theirs */
+	cairo_list_add (&mask->link, &evicted);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_clip_mask_mutex);
+
+    while (! cairo_list_is_empty (&evicted)) {
+	cairo_clip_mask_t *old;
+
+	old = cairo_list_first_entry (&evicted, cairo_clip_mask_t, link);
+	cairo_list_del (&old->link);
+	_cairo_clip_mask_destroy (old);
+    }
+
+    return surface;
+}
+
 cairo_surface_t *
 _cairo_clip_get_surface (const cairo_clip_t *clip,
 			 cairo_surface_t *target,
@@ -171,6 +373,42 @@ _cairo_clip_get_surface (const cairo_clip_t *clip,
 	    return surface;
     }
 
+    if (clip->path != NULL) {
+	cairo_surface_t *mask;
+	int mask_x, mask_y;
+
+	mask = _cairo_clip_path_get_mask (clip->path, target,
+					  &mask_x, &mask_y, &status);
+	if (unlikely (status)) {
+	    cairo_surface_destroy (surface);
+	    return _cairo_surface_create_in_error (status);
+	}
+
+	if (mask != NULL) {
+	    cairo_surface_pattern_t pattern;
+
+	    _cairo_pattern_init_for_surface (&pattern, mask);
+	    cairo_surface_destroy (mask);
+	    cairo_matrix_init_translate (&pattern.base.matrix,
+					 clip->extents.x - mask_x,
+					 clip->extents.y - mask_y);
+	    pattern.base.filter = CAIRO_FILTER_NEAREST;
+	    status = _cairo_surface_paint (surface,
+					   CAIRO_OPERATOR_IN,
+					   &pattern.base,
+					   NULL);
+	    _cairo_pattern_fini (&pattern.base);
+	    if (unlikely (status)) {
+		cairo_surface_destroy (surface);
+		return _cairo_surface_create_in_error (status);
+	    }
+
+	    *tx = clip->extents.x;
+	    *ty = clip->extents.y;
+	    return surface;
+	}
+    }
+
     copy = _cairo_clip_copy_with_translation (clip,
 					      -clip->extents.x,
 					      -clip->extents.y);
@@ -210,6 +448,34 @@ _cairo_clip_get_surface (const cairo_clip_t *clip,
     return surface;
 }
 
+/* Returns a reference to the mask kept with the clip paths if that alone
+ * describes @clip, that is if the boxes of @clip add nothing beyond its
+ * pixel-aligned extents, or NULL otherwise. The surface is shared by every
+ * clip derived from the same paths and must not be modified.
+ */
+cairo_surface_t *
+_cairo_clip_get_shared_surface (const cairo_clip_t *clip,
+				cairo_surface_t *target,
+				int *tx, int *ty)
+{
+    cairo_surface_t *mask;
+    cairo_status_t status;
+
+    if (clip->path == NULL)
+	return NULL;
+
+    if (clip->num_boxes > 1)
+	return NULL;
+    if (clip->num_boxes == 1 && ! _cairo_box_is_pixel_aligned (&clip->boxes[0]))
+	return NULL;
+
+    mask = _cairo_clip_path_get_mask (clip->path, target, tx, ty, &status);
+    if (unlikely (status))
+	return _cairo_surface_create_in_error (status);
+
+    return mask;
+}
+
 cairo_surface_t *
 _cairo_clip_get_image (const cairo_clip_t *clip,
 		       cairo_surface_t *target,
@@ -69,6 +69,9 @@ _cairo_clip_path_create (cairo_clip_t *clip)
 
     CAIRO_REFERENCE_COUNT_INIT (&clip_path->ref_count, 1);
 
+    clip_path->polygon = NULL;
+    clip_path->mask = NULL;
+
     clip_path->prev = clip->path;
     clip->path = clip_path;
 
@@ -95,6 +98,13 @@ _cairo_clip_path_destroy (cairo_clip_path_t *clip_path)
 
     _cairo_path_fixed_fini (&clip_path->path);
 
+    if (clip_path->polygon != NULL) {
+	_cairo_polygon_fini (clip_path->polygon);
+	free (clip_path->polygon);
+    }
+
+    _cairo_clip_path_release_mask (clip_path);
+
     if (clip_path->prev != NULL)
 	_cairo_clip_path_destroy (clip_path->prev);
 
@@ -118,6 +128,7 @@ _cairo_clip_create (void)
     clip->path = NULL;
     clip->boxes = NULL;
     clip->num_boxes = 0;
+    clip->index = NULL;
     clip->region = NULL;
     clip->is_region = FALSE;
 
@@ -135,6 +146,7 @@ _cairo_clip_destroy (cairo_clip_t *clip)
 
     if (clip->boxes != &clip->embedded_box)
 	free (clip->boxes);
+    free (clip->index);
     cairo_region_destroy (clip->region);
 
     _freed_pool_put (&clip_pool, clip);
@@ -450,6 +462,7 @@ _cairo_clip_translate (cairo_clip_t *clip, int tx, int ty)
     fx = _cairo_fixed_from_int (tx);
     fy = _cairo_fixed_from_int (ty);
 
+    _cairo_clip_drop_index (clip);
     for (i = 0; i < clip->num_boxes; i++) {
 	clip->boxes[i].p1.x += fx;
 	clip->boxes[i].p2.x += fx;
@@ -235,6 +235,10 @@ _cairo_compositor_glyphs (const cairo_compositor_t		*compositor,
     cairo_int_status_t status;
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
+
+    /* Computing the extents loads only the metrics of the glyphs, in a
+     * batch of their own, and finds whether any of the run is visible.
+     */
     status = _cairo_composite_rectangles_init_for_glyphs (&extents, surface,
 							  op, source,
 							  scaled_font,
@@ -243,6 +247,13 @@ _cairo_compositor_glyphs (const cairo_compositor_t		*compositor,
     if (unlikely (status))
 	return status;
 
+    /* Then rasterize the glyphs of long runs together whilst they are
+     * cold, unless images will be wanted for their subpixel phases
+     * instead.
+     */
+    if (scaled_font->subpixel_phases <= 1)
+	cairo_scaled_font_prefetch_glyphs (scaled_font, glyphs, num_glyphs);
+
     do {
 	while (compositor->glyphs == NULL)
 	    compositor = compositor->delegate;
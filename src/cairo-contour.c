@@ -250,7 +250,7 @@ _cairo_contour_simplify_chain (cairo_contour_t *contour, const double tolerance,
 			       const cairo_contour_iter_t *last)
 {
     cairo_contour_iter_t iter, furthest;
-    uint64_t max_error;
+    double max_error;
     int x0, y0;
     int nx, ny;
     int count;
@@ -270,7 +270,9 @@ _cairo_contour_simplify_chain (cairo_contour_t *contour, const double tolerance,
     do {
 	cairo_point_t *p = iter.point;
 	if (! DELETED(p)) {
-	    uint64_t d = (uint64_t)nx * (x0 - p->x) + (uint64_t)ny * (y0 - p->y);
+	    /* in doubles, as the square overflows 64 bits for lines
+	     * spanning more than a few hundred units */
+	    double d = (double) nx * (x0 - p->x) + (double) ny * (y0 - p->y);
 	    if (d * d > max_error) {
 		max_error = d * d;
 		furthest = iter;
@@ -282,7 +284,7 @@ _cairo_contour_simplify_chain (cairo_contour_t *contour, const double tolerance,
     if (count == 0)
 	return FALSE;
 
-    if (max_error > tolerance * ((uint64_t)nx * nx + (uint64_t)ny * ny)) {
+    if (max_error > tolerance * ((double) nx * nx + (double) ny * ny)) {
 	cairo_bool_t simplified;
 
 	simplified = FALSE;
@@ -319,10 +321,11 @@ _cairo_contour_simplify (cairo_contour_t *contour, double tolerance)
     tolerance = tolerance * CAIRO_FIXED_ONE;
     tolerance *= tolerance;
 
-    /* stage 1: vertex reduction */
+    /* stage 1: vertex reduction, keeping both end points */
     for (chain = &contour->chain; chain; chain = chain->next) {
 	for (i = 0; i < chain->num_points; i++) {
 	    if (last == NULL ||
+		(chain->next == NULL && i == chain->num_points - 1) ||
 		point_distance_sq (last, &chain->points[i]) > tolerance) {
 		last = &chain->points[i];
 	    } else {
@@ -351,7 +354,8 @@ _cairo_contour_simplify (cairo_contour_t *contour, double tolerance)
 		}
 	    }
 	}
-	assert (max);
+	if (max == 0) /* every remaining point coincides with the first */
+	    break;
 
 	simplified = FALSE;
 	iter_init (&iter, contour);
@@ -84,7 +84,13 @@ cairo_debug_reset_static_data (void)
 
     _cairo_clip_reset_static_data ();
 
+    _cairo_bentley_ottmann_reset_static_data ();
+
+    _cairo_tor_scan_converter_reset_static_data ();
+    _cairo_tor22_scan_converter_reset_static_data ();
+
     _cairo_image_reset_static_data ();
+    _cairo_image_glyph_atlas_reset_static_data ();
 
 #if CAIRO_HAS_DRM_SURFACE
     _cairo_drm_device_reset_static_data ();
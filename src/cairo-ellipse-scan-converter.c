@@ -0,0 +1,229 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-error-private.h"
+#include "cairo-spans-private.h"
+
+/* An analytic scan converter for a single axis-aligned ellipse.
+ *
+ * Rather than supersampling the flattened outline, the coverage of each
+ * pixel is computed exactly as the area of its intersection with the
+ * ellipse. Scaling the ellipse onto the unit disc, the area of the disc
+ * lying within the quadrant { X < u, Y < v } has a closed form, and the
+ * area within any axis-aligned box follows by inclusion-exclusion of its
+ * corners. Only the pixels straddling the outline need evaluating; the
+ * interior of each row is emitted as a single opaque span.
+ */
+
+/* ∫₀ᵗ √(1 - s²) ds */
+static inline double
+_half_chord_integral (double t)
+{
+    return .5 * (t * sqrt (1. - t * t) + asin (t));
+}
+
+/* Area of the unit disc within { X < u, Y < v } */
+static double
+_disc_quadrant_area (double u, double v)
+{
+    double w, t, area;
+
+    if (u <= -1. || v <= -1.)
+	return 0.;
+
+    if (u > 1.)
+	u = 1.;
+    if (v >= 1.)
+	return 2. * _half_chord_integral (u) + M_PI / 2;
+
+    /* Between ±w the disc extends beyond v in both directions; outside
+     * it, the column lies either wholly below v (for v >= 0) or not at
+     * all. */
+    w = sqrt (1. - v * v);
+    area = 0.;
+
+    if (v >= 0.)
+	area += 2. * _half_chord_integral (MIN (u, -w)) + M_PI / 2;
+
+    if (u > -w) {
+	t = MIN (u, w);
+	area += v * (t + w) +
+	    _half_chord_integral (t) - _half_chord_integral (-w);
+    }
+
+    if (u > w && v >= 0.)
+	area += 2. * (_half_chord_integral (u) - _half_chord_integral (w));
+
+    return area;
+}
+
+/* Area of the unit disc within { X < u, v0 <= Y < v1 } */
+static inline double
+_disc_band_area (double u, double v0, double v1)
+{
+    return _disc_quadrant_area (u, v1) - _disc_quadrant_area (u, v0);
+}
+
+static inline int
+_add_span (cairo_half_open_span_t *spans, int num_spans,
+	   int x, double area)
+{
+    int coverage;
+
+    coverage = _cairo_lround (area * 255.);
+    if (coverage < 0)
+	coverage = 0;
+    else if (coverage > 255)
+	coverage = 255;
+
+    if (num_spans && spans[num_spans-1].coverage == coverage)
+	return num_spans;
+
+    spans[num_spans].x = x;
+    spans[num_spans].coverage = coverage;
+    spans[num_spans].inverse = 0;
+    return num_spans + 1;
+}
+
+static cairo_status_t
+_cairo_ellipse_scan_converter_generate (void			*converter,
+					cairo_span_renderer_t	*renderer)
+{
+    cairo_ellipse_scan_converter_t *self = converter;
+    const cairo_ellipse_double_t *e = &self->ellipse;
+    cairo_half_open_span_t spans_stack[CAIRO_STACK_ARRAY_LENGTH (cairo_half_open_span_t)];
+    cairo_half_open_span_t *spans;
+    cairo_status_t status;
+    double scale;
+    int xmin, xmax, ymin, ymax;
+    int y;
+
+    xmin = self->extents.x;
+    xmax = self->extents.x + self->extents.width;
+    ymin = MAX (self->extents.y, floor (e->center.y - e->ry));
+    ymax = MIN (self->extents.y + self->extents.height,
+		ceil (e->center.y + e->ry));
+    if (unlikely (ymin >= ymax || xmin >= xmax)) {
+	return renderer->render_rows (renderer,
+				      self->extents.y, self->extents.height,
+				      NULL, 0);
+    }
+
+    spans = spans_stack;
+    if (unlikely (xmax - xmin + 2 > ARRAY_LENGTH (spans_stack))) {
+	spans = _cairo_malloc_ab (xmax - xmin + 2,
+				  sizeof (cairo_half_open_span_t));
+	if (unlikely (spans == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    scale = e->rx * e->ry; /* pixel area per unit disc area */
+    status = CAIRO_STATUS_SUCCESS;
+    for (y = ymin; y < ymax; y++) {
+	double v0, v1, inner, outer, prev, next;
+	int x0, x1, ix0, ix1, x;
+	int num_spans = 0;
+
+	v0 = (y - e->center.y) / e->ry;
+	v1 = (y + 1 - e->center.y) / e->ry;
+	if (v0 < -1.)
+	    v0 = -1.;
+	if (v1 > 1.)
+	    v1 = 1.;
+
+	/* half-widths of the narrowest and widest chords across the row */
+	inner = MAX (v0 * v0, v1 * v1);
+	inner = inner < 1. ? sqrt (1. - inner) : 0.;
+	if (v0 <= 0. && v1 >= 0.)
+	    outer = 1.;
+	else
+	    outer = sqrt (1. - MIN (v0 * v0, v1 * v1));
+
+	x0 = MAX (xmin, floor (e->center.x - e->rx * outer));
+	x1 = MIN (xmax, ceil (e->center.x + e->rx * outer));
+	if (x0 >= x1)
+	    continue;
+
+	ix0 = MAX (x0, ceil (e->center.x - e->rx * inner));
+	ix1 = MIN (x1, floor (e->center.x + e->rx * inner));
+	if (ix1 <= ix0)
+	    ix0 = ix1 = x1;
+
+	prev = _disc_band_area ((x0 - e->center.x) / e->rx, v0, v1);
+	for (x = x0; x < ix0; x++) {
+	    next = _disc_band_area ((x + 1 - e->center.x) / e->rx, v0, v1);
+	    num_spans = _add_span (spans, num_spans, x, (next - prev) * scale);
+	    prev = next;
+	}
+
+	if (ix1 > ix0) {
+	    num_spans = _add_span (spans, num_spans, ix0, 1.);
+	    prev = _disc_band_area ((ix1 - e->center.x) / e->rx, v0, v1);
+	}
+
+	for (x = ix1; x < x1; x++) {
+	    next = _disc_band_area ((x + 1 - e->center.x) / e->rx, v0, v1);
+	    num_spans = _add_span (spans, num_spans, x, (next - prev) * scale);
+	    prev = next;
+	}
+
+	spans[num_spans].x = x1;
+	spans[num_spans].coverage = 0;
+	spans[num_spans].inverse = 0;
+	num_spans++;
+
+	status = renderer->render_rows (renderer, y, 1, spans, num_spans);
+	if (unlikely (status))
+	    break;
+    }
+
+    if (spans != spans_stack)
+	free (spans);
+
+    return status;
+}
+
+static void
+_cairo_ellipse_scan_converter_destroy (void *converter)
+{
+}
+
+void
+_cairo_ellipse_scan_converter_init (cairo_ellipse_scan_converter_t *self,
+				    const cairo_rectangle_int_t *extents,
+				    const cairo_ellipse_double_t *ellipse)
+{
+    self->base.destroy = _cairo_ellipse_scan_converter_destroy;
+    self->base.generate = _cairo_ellipse_scan_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+
+    self->extents = *extents;
+    self->ellipse = *ellipse;
+}
@@ -55,7 +55,8 @@ static const cairo_font_options_t _cairo_font_options_nil = {
     CAIRO_LCD_FILTER_DEFAULT,
     CAIRO_HINT_STYLE_DEFAULT,
     CAIRO_HINT_METRICS_DEFAULT,
-    CAIRO_ROUND_GLYPH_POS_DEFAULT
+    CAIRO_ROUND_GLYPH_POS_DEFAULT,
+    0 /* subpixel_phases */
 };
 
 /**
@@ -73,6 +74,7 @@ _cairo_font_options_init_default (cairo_font_options_t *options)
     options->hint_style = CAIRO_HINT_STYLE_DEFAULT;
     options->hint_metrics = CAIRO_HINT_METRICS_DEFAULT;
     options->round_glyph_positions = CAIRO_ROUND_GLYPH_POS_DEFAULT;
+    options->subpixel_phases = 0;
 }
 
 void
@@ -85,6 +87,7 @@ _cairo_font_options_init_copy (cairo_font_options_t		*options,
     options->hint_style = other->hint_style;
     options->hint_metrics = other->hint_metrics;
     options->round_glyph_positions = other->round_glyph_positions;
+    options->subpixel_phases = other->subpixel_phases;
 }
 
 /**
@@ -226,6 +229,8 @@ cairo_font_options_merge (cairo_font_options_t       *options,
 	options->hint_metrics = other->hint_metrics;
     if (other->round_glyph_positions != CAIRO_ROUND_GLYPH_POS_DEFAULT)
 	options->round_glyph_positions = other->round_glyph_positions;
+    if (other->subpixel_phases != 0)
+	options->subpixel_phases = other->subpixel_phases;
 }
 slim_hidden_def (cairo_font_options_merge);
 
@@ -259,7 +264,8 @@ cairo_font_options_equal (const cairo_font_options_t *options,
 	    options->lcd_filter == other->lcd_filter &&
 	    options->hint_style == other->hint_style &&
 	    options->hint_metrics == other->hint_metrics &&
-	    options->round_glyph_positions == other->round_glyph_positions);
+	    options->round_glyph_positions == other->round_glyph_positions &&
+	    options->subpixel_phases == other->subpixel_phases);
 }
 slim_hidden_def (cairo_font_options_equal);
 
@@ -287,7 +293,8 @@ cairo_font_options_hash (const cairo_font_options_t *options)
 	    (options->subpixel_order << 4) |
 	    (options->lcd_filter << 8) |
 	    (options->hint_style << 12) |
-	    (options->hint_metrics << 16));
+	    (options->hint_metrics << 16) |
+	    (options->subpixel_phases << 20));
 }
 slim_hidden_def (cairo_font_options_hash);
 
@@ -448,6 +455,65 @@ _cairo_font_options_get_round_glyph_positions (const cairo_font_options_t *optio
     return options->round_glyph_positions;
 }
 
+/**
+ * cairo_font_options_set_subpixel_phases:
+ * @options: a #cairo_font_options_t
+ * @phases: the number of horizontal positions within a pixel, or 0
+ *
+ * Sets the number of horizontal subpixel positions at which glyph
+ * images are rendered. By default glyphs are placed on whole pixels
+ * by the image backend; with @phases greater than 1, each glyph is
+ * instead placed at the nearest of @phases evenly spaced positions
+ * within the pixel, and a separate image is rendered and cached for
+ * every position used. This allows smooth text animation and precise
+ * spacing at the cost of up to @phases times as many cached glyph
+ * images. At most 16 phases are supported; larger values are clamped.
+ *
+ * Only fonts whose glyphs can be rendered at a fraction of a pixel,
+ * currently those of scalable FreeType faces without embedded bitmaps,
+ * make use of this; the glyphs of other fonts stay on whole pixels.
+ *
+ * A value of 0 leaves the choice to the surface, which currently
+ * means whole pixel positioning.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_font_options_set_subpixel_phases (cairo_font_options_t *options,
+					int                   phases)
+{
+    if (cairo_font_options_status (options))
+	return;
+
+    if (phases < 0)
+	phases = 0;
+    if (phases > CAIRO_SCALED_GLYPH_MAX_PHASES)
+	phases = CAIRO_SCALED_GLYPH_MAX_PHASES;
+
+    options->subpixel_phases = phases;
+}
+
+/**
+ * cairo_font_options_get_subpixel_phases:
+ * @options: a #cairo_font_options_t
+ *
+ * Gets the number of horizontal subpixel glyph positions for the
+ * font options object.
+ * See cairo_font_options_set_subpixel_phases() for full details.
+ *
+ * Return value: the number of subpixel phases, or 0 if unset
+ *
+ * Since: 1.16
+ **/
+int
+cairo_font_options_get_subpixel_phases (const cairo_font_options_t *options)
+{
+    if (cairo_font_options_status ((cairo_font_options_t *) options))
+	return 0;
+
+    return options->subpixel_phases;
+}
+
 /**
  * cairo_font_options_set_hint_style:
  * @options: a #cairo_font_options_t
@@ -43,9 +43,11 @@
 
 #include "cairo-error-private.h"
 #include "cairo-image-surface-private.h"
+#include "cairo-list-inline.h"
 #include "cairo-ft-private.h"
 #include "cairo-pattern-private.h"
 #include "cairo-pixman-private.h"
+#include "cairo-time-private.h"
 
 #include <float.h>
 
@@ -101,6 +103,18 @@
  */
 #define MAX_OPEN_FACES 10
 
+/* This is the max number of extra FT_Face objects we open on a single
+ * font for concurrent glyph loading; the default may be lowered (or the
+ * pool disabled with 0) by setting CAIRO_FT_MAX_POOLED_FACES.
+ */
+#define MAX_POOLED_FACES 8
+#define DEFAULT_POOLED_FACES 4
+
+/* and this the max number of them we keep open over all fonts; beyond it,
+ * the least recently used idle ones are closed to make room.
+ */
+#define MAX_OPEN_POOLED_FACES 16
+
 /**
  * SECTION:cairo-ft
  * @Title: FreeType Fonts
@@ -148,6 +162,7 @@ typedef struct _cairo_ft_font_transform {
  */
 
 typedef struct _cairo_ft_font_face cairo_ft_font_face_t;
+typedef struct _cairo_ft_pooled_face cairo_ft_pooled_face_t;
 
 struct _cairo_ft_unscaled_font {
     cairo_unscaled_font_t base;
@@ -170,10 +185,28 @@ struct _cairo_ft_unscaled_font {
 
     cairo_mutex_t mutex;
     int lock_count;
+    cairo_atomic_int_t num_lockers; /* threads holding or waiting on mutex */
+
+    /* Extra faces on the same file, lent to glyph loads that would
+     * otherwise have to wait for the face above; guarded by
+     * _cairo_ft_pooled_face_mutex */
+    cairo_ft_pooled_face_t *pool[MAX_POOLED_FACES];
+    int pool_size;
 
     cairo_ft_font_face_t *faces;	/* Linked list of faces for this font */
 };
 
+/* A private copy of an unscaled font, with its own face and scale, and
+ * its own library so that it shares no state with other threads.
+ */
+struct _cairo_ft_pooled_face {
+    cairo_ft_unscaled_font_t unscaled;
+    FT_Library library;
+    cairo_ft_unscaled_font_t *owner;
+    cairo_bool_t busy;
+    cairo_list_t link; /* in _cairo_ft_idle_pooled_faces whilst not busy */
+};
+
 static int
 _cairo_ft_unscaled_font_keys_equal (const void *key_a,
 				    const void *key_b);
@@ -438,12 +471,32 @@ _cairo_ft_unscaled_font_init (cairo_ft_unscaled_font_t *unscaled,
     unscaled->have_scale = FALSE;
     CAIRO_MUTEX_INIT (unscaled->mutex);
     unscaled->lock_count = 0;
+    unscaled->num_lockers = 0;
+
+    unscaled->pool_size = 0;
 
     unscaled->faces = NULL;
 
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* The idle pooled faces of all fonts, least recently used first, and the
+ * number of pooled faces open, busy or not.
+ */
+static cairo_list_t _cairo_ft_idle_pooled_faces = {
+    &_cairo_ft_idle_pooled_faces, &_cairo_ft_idle_pooled_faces
+};
+static int _cairo_ft_num_pooled_faces;
+
+static void
+_cairo_ft_pooled_face_destroy (cairo_ft_pooled_face_t *pooled)
+{
+    FT_Done_Face (pooled->unscaled.face);
+    FT_Done_FreeType (pooled->library);
+    CAIRO_MUTEX_FINI (pooled->unscaled.mutex);
+    free (pooled);
+}
+
 /**
  * _cairo_ft_unscaled_font_fini:
  *
@@ -458,8 +511,22 @@ _cairo_ft_unscaled_font_init (cairo_ft_unscaled_font_t *unscaled,
 static void
 _cairo_ft_unscaled_font_fini (cairo_ft_unscaled_font_t *unscaled)
 {
+    int i;
+
     assert (unscaled->face == NULL);
 
+    CAIRO_MUTEX_LOCK (_cairo_ft_pooled_face_mutex);
+    for (i = 0; i < unscaled->pool_size; i++) {
+	assert (! unscaled->pool[i]->busy);
+	cairo_list_del (&unscaled->pool[i]->link);
+	_cairo_ft_num_pooled_faces--;
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_pooled_face_mutex);
+
+    for (i = 0; i < unscaled->pool_size; i++)
+	_cairo_ft_pooled_face_destroy (unscaled->pool[i]);
+    unscaled->pool_size = 0;
+
     free (unscaled->filename);
     unscaled->filename = NULL;
 
@@ -658,6 +725,7 @@ _cairo_ft_unscaled_font_lock_face (cairo_ft_unscaled_font_t *unscaled)
     FT_Face face = NULL;
     FT_Error error;
 
+    _cairo_atomic_int_inc (&unscaled->num_lockers);
     CAIRO_MUTEX_LOCK (unscaled->mutex);
     unscaled->lock_count++;
 
@@ -694,6 +762,7 @@ _cairo_ft_unscaled_font_lock_face (cairo_ft_unscaled_font_t *unscaled)
     {
 	unscaled->lock_count--;
 	CAIRO_MUTEX_UNLOCK (unscaled->mutex);
+	_cairo_atomic_int_dec (&unscaled->num_lockers);
 	_cairo_error_throw (_ft_to_cairo_error (error));
 	return NULL;
     }
@@ -716,8 +785,210 @@ _cairo_ft_unscaled_font_unlock_face (cairo_ft_unscaled_font_t *unscaled)
     unscaled->lock_count--;
 
     CAIRO_MUTEX_UNLOCK (unscaled->mutex);
+    _cairo_atomic_int_dec (&unscaled->num_lockers);
+}
+
+static int
+_cairo_ft_max_pooled_faces (void)
+{
+    static int max_pooled_faces = -1;
+
+    if (max_pooled_faces < 0) {
+	const char *env = getenv ("CAIRO_FT_MAX_POOLED_FACES");
+	int max = DEFAULT_POOLED_FACES;
+
+	if (env != NULL) {
+	    max = atoi (env);
+	    if (max < 0)
+		max = 0;
+	    if (max > MAX_POOLED_FACES)
+		max = MAX_POOLED_FACES;
+	}
+
+	max_pooled_faces = max;
+    }
+
+    return max_pooled_faces;
+}
+
+static cairo_ft_pooled_face_t *
+_cairo_ft_pooled_face_create (cairo_ft_unscaled_font_t *unscaled)
+{
+    cairo_ft_pooled_face_t *pooled;
+    FT_Error error;
+
+    pooled = calloc (1, sizeof (cairo_ft_pooled_face_t));
+    if (unlikely (pooled == NULL))
+	return NULL;
+
+    if (FT_Init_FreeType (&pooled->library)) {
+	free (pooled);
+	return NULL;
+    }
+
+    error = FT_New_Face (pooled->library,
+			 unscaled->filename,
+			 unscaled->id,
+			 &pooled->unscaled.face);
+    if (error) {
+	FT_Done_FreeType (pooled->library);
+	free (pooled);
+	return NULL;
+    }
+
+    /* The copy owns its face outright, just as if it had been given one */
+    pooled->unscaled.from_face = TRUE;
+    pooled->unscaled.have_scale = FALSE;
+    CAIRO_MUTEX_INIT (pooled->unscaled.mutex);
+
+    pooled->owner = unscaled;
+    cairo_list_init (&pooled->link);
+
+    return pooled;
+}
+
+/* Takes an idle face out of the pool of its font, to be closed.
+ * Called with _cairo_ft_pooled_face_mutex held.
+ */
+static void
+_cairo_ft_pooled_face_remove (cairo_ft_pooled_face_t *pooled)
+{
+    cairo_ft_unscaled_font_t *owner = pooled->owner;
+    int i;
+
+    for (i = 0; owner->pool[i] != pooled; i++)
+	;
+    owner->pool[i] = owner->pool[--owner->pool_size];
+
+    cairo_list_del (&pooled->link);
+    _cairo_ft_num_pooled_faces--;
+}
+
+/* Borrows an idle face from the pool of @unscaled, preferring one already
+ * at @scale, or opens another if neither the pool of the font nor the
+ * total are full, closing the least recently used idle face of any font
+ * to keep within the total. Never waits for a face to become free, but
+ * returns NULL if there is none to be had. The face is released with
+ * _cairo_ft_pooled_face_release().
+ */
+static cairo_ft_pooled_face_t *
+_cairo_ft_pooled_face_borrow (cairo_ft_unscaled_font_t *unscaled,
+			      const cairo_matrix_t     *scale)
+{
+    cairo_ft_pooled_face_t *pooled = NULL, *closed = NULL;
+    cairo_bool_t can_open;
+    int max = _cairo_ft_max_pooled_faces ();
+    int i;
+
+    if (unscaled->from_face || max == 0)
+	return NULL;
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_pooled_face_mutex);
+    for (i = 0; i < unscaled->pool_size; i++) {
+	cairo_ft_pooled_face_t *entry = unscaled->pool[i];
+
+	if (entry->busy)
+	    continue;
+
+	pooled = entry;
+	if (entry->unscaled.have_scale &&
+	    entry->unscaled.current_scale.xx == scale->xx &&
+	    entry->unscaled.current_scale.yx == scale->yx &&
+	    entry->unscaled.current_scale.xy == scale->xy &&
+	    entry->unscaled.current_scale.yy == scale->yy)
+	    break;
+    }
+    if (pooled != NULL) {
+	pooled->busy = TRUE;
+	cairo_list_del (&pooled->link);
+    }
+    can_open = pooled == NULL && unscaled->pool_size < max;
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_pooled_face_mutex);
+
+    if (! can_open)
+	return pooled;
+
+    /* Open the file without holding up the other fonts */
+    pooled = _cairo_ft_pooled_face_create (unscaled);
+    if (pooled == NULL)
+	return NULL;
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_pooled_face_mutex);
+    if (unscaled->pool_size < max &&
+	_cairo_ft_num_pooled_faces >= MAX_OPEN_POOLED_FACES &&
+	! cairo_list_is_empty (&_cairo_ft_idle_pooled_faces))
+    {
+	closed = cairo_list_first_entry (&_cairo_ft_idle_pooled_faces,
+					 cairo_ft_pooled_face_t, link);
+	_cairo_ft_pooled_face_remove (closed);
+    }
+    if (unscaled->pool_size < max &&
+	_cairo_ft_num_pooled_faces < MAX_OPEN_POOLED_FACES)
+    {
+	pooled->busy = TRUE;
+	unscaled->pool[unscaled->pool_size++] = pooled;
+	_cairo_ft_num_pooled_faces++;
+    } else {
+	/* filled up by other threads in the meantime */
+	_cairo_ft_pooled_face_destroy (pooled);
+	pooled = NULL;
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_pooled_face_mutex);
+
+    if (closed != NULL)
+	_cairo_ft_pooled_face_destroy (closed);
+
+    return pooled;
+}
+
+static void
+_cairo_ft_pooled_face_release (cairo_ft_pooled_face_t *pooled)
+{
+    CAIRO_MUTEX_LOCK (_cairo_ft_pooled_face_mutex);
+    pooled->busy = FALSE;
+    cairo_list_add_tail (&pooled->link, &_cairo_ft_idle_pooled_faces);
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_pooled_face_mutex);
+}
+
+/* Locks a face for loading glyphs at @scale. This is usually the shared
+ * face of the unscaled font, but if another thread is already using that,
+ * then rather than wait we borrow one from the pool, preferring one
+ * already at @scale. Returns the unscaled font owning the face, to be
+ * released with _cairo_ft_unscaled_font_unlock_glyph_face().
+ */
+static cairo_ft_unscaled_font_t *
+_cairo_ft_unscaled_font_lock_glyph_face (cairo_ft_unscaled_font_t *unscaled,
+					 const cairo_matrix_t	  *scale)
+{
+    cairo_ft_pooled_face_t *pooled = NULL;
+
+    if (_cairo_atomic_int_get (&unscaled->num_lockers) != 0)
+	pooled = _cairo_ft_pooled_face_borrow (unscaled, scale);
+
+    if (pooled != NULL) {
+	/* Uncontended, as only we may use the copy whilst it is busy */
+	(void) _cairo_ft_unscaled_font_lock_face (&pooled->unscaled);
+	return &pooled->unscaled;
+    }
+
+    if (_cairo_ft_unscaled_font_lock_face (unscaled) == NULL)
+	return NULL;
+
+    return unscaled;
 }
 
+static void
+_cairo_ft_unscaled_font_unlock_glyph_face (cairo_ft_unscaled_font_t *unscaled,
+					   cairo_ft_unscaled_font_t *locked)
+{
+    _cairo_ft_unscaled_font_unlock_face (locked);
+
+    if (locked != unscaled) {
+	_cairo_ft_pooled_face_release (cairo_container_of (locked,
+							   cairo_ft_pooled_face_t,
+							   unscaled));
+    }
+}
 
 static cairo_status_t
 _compute_transform (cairo_ft_font_transform_t *sf,
@@ -1958,6 +2229,15 @@ _cairo_ft_font_face_scaled_font_create (void		    *abstract_font_face,
 	return status;
     }
 
+    /* Only outlines can be nudged to a subpixel phase, so a face that may
+     * hand us bitmaps instead keeps its glyphs to whole pixels.
+     */
+    if (FT_IS_SCALABLE (face) &&
+	(! FT_HAS_FIXED_SIZES (face) ||
+	 scaled_font->ft_options.load_flags & FT_LOAD_NO_BITMAP))
+    {
+	scaled_font->base.subpixel_phases = scaled_font->base.options.subpixel_phases;
+    }
 
     metrics = &face->size->metrics;
 
@@ -2187,17 +2467,16 @@ _decompose_glyph_outline (FT_Face		  face,
  * Translate glyph to match its metrics.
  */
 static void
-_cairo_ft_scaled_glyph_vertical_layout_bearing_fix (void        *abstract_font,
-						    FT_GlyphSlot glyph)
+_cairo_ft_scaled_glyph_vertical_layout_bearing_fix (cairo_ft_unscaled_font_t *unscaled,
+						    FT_GlyphSlot	      glyph)
 {
-    cairo_ft_scaled_font_t *scaled_font = abstract_font;
     FT_Vector vector;
 
     vector.x = glyph->metrics.vertBearingX - glyph->metrics.horiBearingX;
     vector.y = -glyph->metrics.vertBearingY - glyph->metrics.horiBearingY;
 
     if (glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
-	FT_Vector_Transform (&vector, &scaled_font->unscaled->Current_Shape);
+	FT_Vector_Transform (&vector, &unscaled->Current_Shape);
 	FT_Outline_Translate(&glyph->outline, vector.x, vector.y);
     } else if (glyph->format == FT_GLYPH_FORMAT_BITMAP) {
 	glyph->bitmap_left += vector.x / 64;
@@ -2205,71 +2484,22 @@ _cairo_ft_scaled_glyph_vertical_layout_bearing_fix (void        *abstract_font,
     }
 }
 
-static cairo_int_status_t
-_cairo_ft_scaled_glyph_init (void			*abstract_font,
-			     cairo_scaled_glyph_t	*scaled_glyph,
-			     cairo_scaled_glyph_info_t	 info)
+static cairo_status_t
+_cairo_ft_scaled_glyph_load (cairo_ft_scaled_font_t	*scaled_font,
+			     cairo_ft_unscaled_font_t	*unscaled,
+			     FT_Face			 face,
+			     unsigned long	     index,
+			     int		     load_flags,
+			     cairo_bool_t	     vertical_layout)
 {
-    cairo_text_extents_t    fs_metrics;
-    cairo_ft_scaled_font_t *scaled_font = abstract_font;
-    cairo_ft_unscaled_font_t *unscaled = scaled_font->unscaled;
     FT_GlyphSlot glyph;
-    FT_Face face;
     FT_Error error;
-    int load_flags = scaled_font->ft_options.load_flags;
-    FT_Glyph_Metrics *metrics;
-    double x_factor, y_factor;
-    cairo_bool_t vertical_layout = FALSE;
-    cairo_status_t status;
-
-    face = _cairo_ft_unscaled_font_lock_face (unscaled);
-    if (!face)
-	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-
-    status = _cairo_ft_unscaled_font_set_scale (scaled_font->unscaled,
-				                &scaled_font->base.scale);
-    if (unlikely (status))
-	goto FAIL;
-
-    /* Ignore global advance unconditionally */
-    load_flags |= FT_LOAD_IGNORE_GLOBAL_ADVANCE_WIDTH;
-
-    if ((info & CAIRO_SCALED_GLYPH_INFO_PATH) != 0 &&
-	(info & CAIRO_SCALED_GLYPH_INFO_SURFACE) == 0)
-	load_flags |= FT_LOAD_NO_BITMAP;
-
-    /*
-     * Don't pass FT_LOAD_VERTICAL_LAYOUT to FT_Load_Glyph here as
-     * suggested by freetype people.
-     */
-    if (load_flags & FT_LOAD_VERTICAL_LAYOUT) {
-	load_flags &= ~FT_LOAD_VERTICAL_LAYOUT;
-	vertical_layout = TRUE;
-    }
-
-#ifdef FT_LOAD_COLOR
-    /* Color-glyph support:
-     *
-     * This flags needs plumbing through fontconfig (does it?), and
-     * maybe we should cache color and grayscale bitmaps separately
-     * such that users of the font (ie. the surface) can choose which
-     * version to use based on target content type.
-     *
-     * Moreover, none of our backends and compositors currently support
-     * color glyphs.  As such, this is currently disabled.
-     */
-    /* load_flags |= FT_LOAD_COLOR; */
-#endif
 
-    error = FT_Load_Glyph (face,
-			   _cairo_scaled_glyph_index(scaled_glyph),
-			   load_flags);
+    error = FT_Load_Glyph (face, index, load_flags);
     /* XXX ignoring all other errors for now.  They are not fatal, typically
      * just a glyph-not-found. */
-    if (error == FT_Err_Out_Of_Memory) {
-	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	goto FAIL;
-    }
+    if (error == FT_Err_Out_Of_Memory)
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
     glyph = face->glyph;
 
@@ -2287,191 +2517,561 @@ _cairo_ft_scaled_glyph_init (void			*abstract_font,
 #endif
 
     if (vertical_layout)
-	_cairo_ft_scaled_glyph_vertical_layout_bearing_fix (scaled_font, glyph);
-
-    if (info & CAIRO_SCALED_GLYPH_INFO_METRICS) {
-
-	cairo_bool_t hint_metrics = scaled_font->base.options.hint_metrics != CAIRO_HINT_METRICS_OFF;
-	/*
-	 * Compute font-space metrics
-	 */
-	metrics = &glyph->metrics;
-
-	if (unscaled->x_scale == 0)
-	    x_factor = 0;
-	else
-	    x_factor = 1 / unscaled->x_scale;
+	_cairo_ft_scaled_glyph_vertical_layout_bearing_fix (unscaled, glyph);
 
-	if (unscaled->y_scale == 0)
-	    y_factor = 0;
-	else
-	    y_factor = 1 / unscaled->y_scale;
+    return CAIRO_STATUS_SUCCESS;
+}
 
-	/*
-	 * Note: Y coordinates of the horizontal bearing need to be negated.
-	 *
-	 * Scale metrics back to glyph space from the scaled glyph space returned
-	 * by FreeType
-	 *
-	 * If we want hinted metrics but aren't asking for hinted glyphs from
-	 * FreeType, then we need to do the metric hinting ourselves.
-	 */
+static void
+_cairo_ft_scaled_glyph_fs_metrics (cairo_ft_scaled_font_t	  *scaled_font,
+				   cairo_ft_unscaled_font_t *unscaled,
+				   FT_GlyphSlot		   glyph,
+				   int			   load_flags,
+				   cairo_bool_t		   vertical_layout,
+				   cairo_text_extents_t	  *fs_metrics)
+{
+    cairo_bool_t hint_metrics = scaled_font->base.options.hint_metrics != CAIRO_HINT_METRICS_OFF;
+    FT_Glyph_Metrics *metrics;
+    double x_factor, y_factor;
 
-	if (hint_metrics && (load_flags & FT_LOAD_NO_HINTING))
-	{
-	    FT_Pos x1, x2;
-	    FT_Pos y1, y2;
-	    FT_Pos advance;
+    /*
+     * Compute font-space metrics
+     */
+    metrics = &glyph->metrics;
 
-	    if (!vertical_layout) {
-		x1 = (metrics->horiBearingX) & -64;
-		x2 = (metrics->horiBearingX + metrics->width + 63) & -64;
-		y1 = (-metrics->horiBearingY) & -64;
-		y2 = (-metrics->horiBearingY + metrics->height + 63) & -64;
+    if (unscaled->x_scale == 0)
+	x_factor = 0;
+    else
+	x_factor = 1 / unscaled->x_scale;
 
-		advance = ((metrics->horiAdvance + 32) & -64);
+    if (unscaled->y_scale == 0)
+	y_factor = 0;
+    else
+	y_factor = 1 / unscaled->y_scale;
 
-		fs_metrics.x_bearing = DOUBLE_FROM_26_6 (x1) * x_factor;
-		fs_metrics.y_bearing = DOUBLE_FROM_26_6 (y1) * y_factor;
+    /*
+     * Note: Y coordinates of the horizontal bearing need to be negated.
+     *
+     * Scale metrics back to glyph space from the scaled glyph space returned
+     * by FreeType
+     *
+     * If we want hinted metrics but aren't asking for hinted glyphs from
+     * FreeType, then we need to do the metric hinting ourselves.
+     */
 
-		fs_metrics.width  = DOUBLE_FROM_26_6 (x2 - x1) * x_factor;
-		fs_metrics.height  = DOUBLE_FROM_26_6 (y2 - y1) * y_factor;
+    if (hint_metrics && (load_flags & FT_LOAD_NO_HINTING))
+    {
+	FT_Pos x1, x2;
+	FT_Pos y1, y2;
+	FT_Pos advance;
 
-		fs_metrics.x_advance = DOUBLE_FROM_26_6 (advance) * x_factor;
-		fs_metrics.y_advance = 0;
-	    } else {
-		x1 = (metrics->vertBearingX) & -64;
-		x2 = (metrics->vertBearingX + metrics->width + 63) & -64;
-		y1 = (metrics->vertBearingY) & -64;
-		y2 = (metrics->vertBearingY + metrics->height + 63) & -64;
+	if (!vertical_layout) {
+	    x1 = (metrics->horiBearingX) & -64;
+	    x2 = (metrics->horiBearingX + metrics->width + 63) & -64;
+	    y1 = (-metrics->horiBearingY) & -64;
+	    y2 = (-metrics->horiBearingY + metrics->height + 63) & -64;
 
-		advance = ((metrics->vertAdvance + 32) & -64);
+	    advance = ((metrics->horiAdvance + 32) & -64);
 
-		fs_metrics.x_bearing = DOUBLE_FROM_26_6 (x1) * x_factor;
-		fs_metrics.y_bearing = DOUBLE_FROM_26_6 (y1) * y_factor;
+	    fs_metrics->x_bearing = DOUBLE_FROM_26_6 (x1) * x_factor;
+	    fs_metrics->y_bearing = DOUBLE_FROM_26_6 (y1) * y_factor;
 
-		fs_metrics.width  = DOUBLE_FROM_26_6 (x2 - x1) * x_factor;
-		fs_metrics.height  = DOUBLE_FROM_26_6 (y2 - y1) * y_factor;
+	    fs_metrics->width  = DOUBLE_FROM_26_6 (x2 - x1) * x_factor;
+	    fs_metrics->height  = DOUBLE_FROM_26_6 (y2 - y1) * y_factor;
 
-		fs_metrics.x_advance = 0;
-		fs_metrics.y_advance = DOUBLE_FROM_26_6 (advance) * y_factor;
-	    }
-	 } else {
-	    fs_metrics.width  = DOUBLE_FROM_26_6 (metrics->width) * x_factor;
-	    fs_metrics.height = DOUBLE_FROM_26_6 (metrics->height) * y_factor;
+	    fs_metrics->x_advance = DOUBLE_FROM_26_6 (advance) * x_factor;
+	    fs_metrics->y_advance = 0;
+	} else {
+	    x1 = (metrics->vertBearingX) & -64;
+	    x2 = (metrics->vertBearingX + metrics->width + 63) & -64;
+	    y1 = (metrics->vertBearingY) & -64;
+	    y2 = (metrics->vertBearingY + metrics->height + 63) & -64;
 
-	    if (!vertical_layout) {
-		fs_metrics.x_bearing = DOUBLE_FROM_26_6 (metrics->horiBearingX) * x_factor;
-		fs_metrics.y_bearing = DOUBLE_FROM_26_6 (-metrics->horiBearingY) * y_factor;
+	    advance = ((metrics->vertAdvance + 32) & -64);
 
-		if (hint_metrics || glyph->format != FT_GLYPH_FORMAT_OUTLINE)
-		    fs_metrics.x_advance = DOUBLE_FROM_26_6 (metrics->horiAdvance) * x_factor;
-		else
-		    fs_metrics.x_advance = DOUBLE_FROM_16_16 (glyph->linearHoriAdvance) * x_factor;
-		fs_metrics.y_advance = 0 * y_factor;
-	    } else {
-		fs_metrics.x_bearing = DOUBLE_FROM_26_6 (metrics->vertBearingX) * x_factor;
-		fs_metrics.y_bearing = DOUBLE_FROM_26_6 (metrics->vertBearingY) * y_factor;
+	    fs_metrics->x_bearing = DOUBLE_FROM_26_6 (x1) * x_factor;
+	    fs_metrics->y_bearing = DOUBLE_FROM_26_6 (y1) * y_factor;
 
-		fs_metrics.x_advance = 0 * x_factor;
-		if (hint_metrics || glyph->format != FT_GLYPH_FORMAT_OUTLINE)
-		    fs_metrics.y_advance = DOUBLE_FROM_26_6 (metrics->vertAdvance) * y_factor;
-		else
-		    fs_metrics.y_advance = DOUBLE_FROM_16_16 (glyph->linearVertAdvance) * y_factor;
-	    }
-	 }
+	    fs_metrics->width  = DOUBLE_FROM_26_6 (x2 - x1) * x_factor;
+	    fs_metrics->height  = DOUBLE_FROM_26_6 (y2 - y1) * y_factor;
 
-	_cairo_scaled_glyph_set_metrics (scaled_glyph,
-					 &scaled_font->base,
-					 &fs_metrics);
-    }
+	    fs_metrics->x_advance = 0;
+	    fs_metrics->y_advance = DOUBLE_FROM_26_6 (advance) * y_factor;
+	}
+     } else {
+	fs_metrics->width  = DOUBLE_FROM_26_6 (metrics->width) * x_factor;
+	fs_metrics->height = DOUBLE_FROM_26_6 (metrics->height) * y_factor;
 
-    if ((info & CAIRO_SCALED_GLYPH_INFO_SURFACE) != 0) {
-	cairo_image_surface_t	*surface;
+	if (!vertical_layout) {
+	    fs_metrics->x_bearing = DOUBLE_FROM_26_6 (metrics->horiBearingX) * x_factor;
+	    fs_metrics->y_bearing = DOUBLE_FROM_26_6 (-metrics->horiBearingY) * y_factor;
 
-	if (glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
-	    status = _render_glyph_outline (face, &scaled_font->ft_options.base,
-					    &surface);
+	    if (hint_metrics || glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+		fs_metrics->x_advance = DOUBLE_FROM_26_6 (metrics->horiAdvance) * x_factor;
+	    else
+		fs_metrics->x_advance = DOUBLE_FROM_16_16 (glyph->linearHoriAdvance) * x_factor;
+	    fs_metrics->y_advance = 0 * y_factor;
 	} else {
-	    status = _render_glyph_bitmap (face, &scaled_font->ft_options.base,
-					   &surface);
-	    if (likely (status == CAIRO_STATUS_SUCCESS) &&
-		unscaled->have_shape)
-	    {
-		status = _transform_glyph_bitmap (&unscaled->current_shape,
-						  &surface);
-		if (unlikely (status))
-		    cairo_surface_destroy (&surface->base);
-	    }
+	    fs_metrics->x_bearing = DOUBLE_FROM_26_6 (metrics->vertBearingX) * x_factor;
+	    fs_metrics->y_bearing = DOUBLE_FROM_26_6 (metrics->vertBearingY) * y_factor;
+
+	    fs_metrics->x_advance = 0 * x_factor;
+	    if (hint_metrics || glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+		fs_metrics->y_advance = DOUBLE_FROM_26_6 (metrics->vertAdvance) * y_factor;
+	    else
+		fs_metrics->y_advance = DOUBLE_FROM_16_16 (glyph->linearVertAdvance) * y_factor;
 	}
-	if (unlikely (status))
-	    goto FAIL;
+     }
+}
 
-	_cairo_scaled_glyph_set_surface (scaled_glyph,
-					 &scaled_font->base,
-					 surface);
-    }
+static cairo_status_t
+_cairo_ft_scaled_glyph_render (cairo_ft_scaled_font_t	 *scaled_font,
+			       cairo_ft_unscaled_font_t	 *unscaled,
+			       FT_Face			  face,
+			       int			  xphase,
+			       cairo_image_surface_t	**surface)
+{
+    cairo_status_t status;
 
-    if (info & CAIRO_SCALED_GLYPH_INFO_PATH) {
-	cairo_path_fixed_t *path = NULL; /* hide compiler warning */
+    if (face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+	int phases = scaled_font->base.subpixel_phases;
 
-	/*
-	 * A kludge -- the above code will trash the outline,
-	 * so reload it. This will probably never occur though
-	 */
-	if ((info & CAIRO_SCALED_GLYPH_INFO_SURFACE) != 0) {
-	    error = FT_Load_Glyph (face,
-				   _cairo_scaled_glyph_index(scaled_glyph),
-				   load_flags | FT_LOAD_NO_BITMAP);
-	    /* XXX ignoring all other errors for now.  They are not fatal, typically
-	     * just a glyph-not-found. */
-	    if (error == FT_Err_Out_Of_Memory) {
-		status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-		goto FAIL;
-	    }
-#if HAVE_FT_GLYPHSLOT_EMBOLDEN
-	    if (scaled_font->ft_options.synth_flags & CAIRO_FT_SYNTHESIZE_BOLD)
-		FT_GlyphSlot_Embolden (glyph);
-#endif
-#if HAVE_FT_GLYPHSLOT_OBLIQUE
-	    if (scaled_font->ft_options.synth_flags & CAIRO_FT_SYNTHESIZE_OBLIQUE)
-		FT_GlyphSlot_Oblique (glyph);
-#endif
-	    if (vertical_layout)
-		_cairo_ft_scaled_glyph_vertical_layout_bearing_fix (scaled_font, glyph);
+	/* nudge the outline right to the requested subpixel phase */
+	if (xphase > 0 && xphase < phases)
+	    FT_Outline_Translate (&face->glyph->outline,
+				  xphase * 64 / phases, 0);
 
-	}
-	if (glyph->format == FT_GLYPH_FORMAT_OUTLINE)
-	    status = _decompose_glyph_outline (face, &scaled_font->ft_options.base,
-					       &path);
-	else
-	    status = CAIRO_INT_STATUS_UNSUPPORTED;
+	return _render_glyph_outline (face, &scaled_font->ft_options.base,
+				      surface);
+    }
 
+    status = _render_glyph_bitmap (face, &scaled_font->ft_options.base,
+				   surface);
+    if (likely (status == CAIRO_STATUS_SUCCESS) && unscaled->have_shape) {
+	status = _transform_glyph_bitmap (&unscaled->current_shape, surface);
 	if (unlikely (status))
-	    goto FAIL;
-
-	_cairo_scaled_glyph_set_path (scaled_glyph,
-				      &scaled_font->base,
-				      path);
+	    cairo_surface_destroy (&(*surface)->base);
     }
- FAIL:
-    _cairo_ft_unscaled_font_unlock_face (unscaled);
 
     return status;
 }
 
-static unsigned long
-_cairo_ft_ucs4_to_index (void	    *abstract_font,
-			 uint32_t    ucs4)
+static int
+_cairo_ft_scaled_glyph_load_flags (cairo_ft_scaled_font_t    *scaled_font,
+				   cairo_scaled_glyph_info_t  info,
+				   cairo_bool_t		     *vertical_layout)
 {
-    cairo_ft_scaled_font_t *scaled_font = abstract_font;
-    cairo_ft_unscaled_font_t *unscaled = scaled_font->unscaled;
-    FT_Face face;
-    FT_UInt index;
+    int load_flags = scaled_font->ft_options.load_flags;
 
-    face = _cairo_ft_unscaled_font_lock_face (unscaled);
-    if (!face)
-	return 0;
+    /* Ignore global advance unconditionally */
+    load_flags |= FT_LOAD_IGNORE_GLOBAL_ADVANCE_WIDTH;
+
+    if ((info & CAIRO_SCALED_GLYPH_INFO_PATH) != 0 &&
+	(info & CAIRO_SCALED_GLYPH_INFO_SURFACE) == 0)
+	load_flags |= FT_LOAD_NO_BITMAP;
+
+    /*
+     * Don't pass FT_LOAD_VERTICAL_LAYOUT to FT_Load_Glyph here as
+     * suggested by freetype people.
+     */
+    *vertical_layout = FALSE;
+    if (load_flags & FT_LOAD_VERTICAL_LAYOUT) {
+	load_flags &= ~FT_LOAD_VERTICAL_LAYOUT;
+	*vertical_layout = TRUE;
+    }
+
+#ifdef FT_LOAD_COLOR
+    /* Color-glyph support:
+     *
+     * This flags needs plumbing through fontconfig (does it?), and
+     * maybe we should cache color and grayscale bitmaps separately
+     * such that users of the font (ie. the surface) can choose which
+     * version to use based on target content type.
+     *
+     * Moreover, none of our backends and compositors currently support
+     * color glyphs.  As such, this is currently disabled.
+     */
+    /* load_flags |= FT_LOAD_COLOR; */
+#endif
+
+    return load_flags;
+}
+
+static cairo_int_status_t
+_cairo_ft_scaled_glyph_init (void			*abstract_font,
+			     cairo_scaled_glyph_t	*scaled_glyph,
+			     cairo_scaled_glyph_info_t	 info)
+{
+    cairo_ft_scaled_font_t *scaled_font = abstract_font;
+    cairo_ft_unscaled_font_t *unscaled;
+    FT_GlyphSlot glyph;
+    FT_Face face;
+    int load_flags;
+    cairo_bool_t vertical_layout;
+    cairo_status_t status;
+
+    unscaled = _cairo_ft_unscaled_font_lock_glyph_face (scaled_font->unscaled,
+							&scaled_font->base.scale);
+    if (!unscaled)
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    face = unscaled->face;
+
+    status = _cairo_ft_unscaled_font_set_scale (unscaled,
+				                &scaled_font->base.scale);
+    if (unlikely (status))
+	goto FAIL;
+
+    load_flags = _cairo_ft_scaled_glyph_load_flags (scaled_font, info,
+						    &vertical_layout);
+
+    status = _cairo_ft_scaled_glyph_load (scaled_font, unscaled, face,
+					  _cairo_scaled_glyph_index (scaled_glyph),
+					  load_flags, vertical_layout);
+    if (unlikely (status))
+	goto FAIL;
+
+    glyph = face->glyph;
+
+    if (info & CAIRO_SCALED_GLYPH_INFO_METRICS) {
+	cairo_text_extents_t fs_metrics;
+
+	_cairo_ft_scaled_glyph_fs_metrics (scaled_font, unscaled, glyph,
+					   load_flags, vertical_layout,
+					   &fs_metrics);
+	_cairo_scaled_glyph_set_metrics (scaled_glyph,
+					 &scaled_font->base,
+					 &fs_metrics);
+    }
+
+    if ((info & CAIRO_SCALED_GLYPH_INFO_SURFACE) != 0) {
+	cairo_image_surface_t	*surface;
+
+	status = _cairo_ft_scaled_glyph_render (scaled_font, unscaled, face,
+						_cairo_scaled_glyph_xphase (scaled_glyph),
+						&surface);
+	if (unlikely (status))
+	    goto FAIL;
+
+	_cairo_scaled_glyph_set_surface (scaled_glyph,
+					 &scaled_font->base,
+					 surface);
+    }
+
+    if (info & CAIRO_SCALED_GLYPH_INFO_PATH) {
+	cairo_path_fixed_t *path = NULL; /* hide compiler warning */
+
+	/*
+	 * A kludge -- the above code will trash the outline,
+	 * so reload it. This will probably never occur though
+	 */
+	if ((info & CAIRO_SCALED_GLYPH_INFO_SURFACE) != 0) {
+	    status = _cairo_ft_scaled_glyph_load (scaled_font, unscaled, face,
+						  _cairo_scaled_glyph_index (scaled_glyph),
+						  load_flags | FT_LOAD_NO_BITMAP,
+						  vertical_layout);
+	    if (unlikely (status))
+		goto FAIL;
+	}
+	if (glyph->format == FT_GLYPH_FORMAT_OUTLINE)
+	    status = _decompose_glyph_outline (face, &scaled_font->ft_options.base,
+					       &path);
+	else
+	    status = CAIRO_INT_STATUS_UNSUPPORTED;
+
+	if (unlikely (status))
+	    goto FAIL;
+
+	_cairo_scaled_glyph_set_path (scaled_glyph,
+				      &scaled_font->base,
+				      path);
+    }
+ FAIL:
+    _cairo_ft_unscaled_font_unlock_glyph_face (scaled_font->unscaled, unscaled);
+
+    return status;
+}
+
+#if CAIRO_HAS_REAL_PTHREAD && defined (__GNUC__) && HAVE_UNISTD_H
+/* libcairo itself is not linked against the thread library, so we only
+ * spread the work out over threads if the application has them.
+ */
+#pragma weak pthread_create
+#pragma weak pthread_join
+#define CAIRO_FT_THREADED_GLYPHS 1
+#endif
+
+#if CAIRO_FT_THREADED_GLYPHS
+#include <pthread.h>
+
+/* Don't bother starting a thread for less than this many glyphs */
+#define MIN_GLYPHS_PER_THREAD 32
+#define MAX_GLYPH_THREADS 8
+
+typedef struct _cairo_ft_glyph_result {
+    cairo_text_extents_t fs_metrics;
+    cairo_image_surface_t *surface;
+} cairo_ft_glyph_result_t;
+
+typedef struct _cairo_ft_glyph_job {
+    cairo_ft_scaled_font_t *scaled_font;
+    cairo_ft_pooled_face_t *pooled; /* NULL to use the shared face */
+    cairo_scaled_glyph_t **scaled_glyphs;
+    cairo_ft_glyph_result_t *results;
+    int num_glyphs;
+    cairo_scaled_glyph_info_t info;
+    cairo_status_t status;
+} cairo_ft_glyph_job_t;
+
+static cairo_status_t
+_cairo_ft_glyph_job_run (cairo_ft_glyph_job_t     *job,
+			 cairo_ft_unscaled_font_t *unscaled)
+{
+    cairo_ft_scaled_font_t *scaled_font = job->scaled_font;
+    FT_Face face = unscaled->face;
+    cairo_bool_t vertical_layout;
+    cairo_status_t status;
+    int load_flags, i;
+
+    load_flags = _cairo_ft_scaled_glyph_load_flags (scaled_font, job->info,
+						    &vertical_layout);
+
+    for (i = 0; i < job->num_glyphs; i++) {
+	cairo_ft_glyph_result_t *result = &job->results[i];
+
+	status = _cairo_ft_scaled_glyph_load (scaled_font, unscaled, face,
+					      _cairo_scaled_glyph_index (job->scaled_glyphs[i]),
+					      load_flags, vertical_layout);
+	if (unlikely (status))
+	    return status;
+
+	if (job->info & CAIRO_SCALED_GLYPH_INFO_METRICS) {
+	    _cairo_ft_scaled_glyph_fs_metrics (scaled_font, unscaled, face->glyph,
+					       load_flags, vertical_layout,
+					       &result->fs_metrics);
+	}
+
+	if (job->info & CAIRO_SCALED_GLYPH_INFO_SURFACE) {
+	    status = _cairo_ft_scaled_glyph_render (scaled_font, unscaled, face,
+						    _cairo_scaled_glyph_xphase (job->scaled_glyphs[i]),
+						    &result->surface);
+	    if (unlikely (status)) {
+		result->surface = NULL;
+		return status;
+	    }
+	}
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* FreeType objects may only be used from one thread at a time, so each
+ * worker is lent a face from the pool of the font and scales it to
+ * match. Should that fail, the share is left undone and its status set,
+ * without raising an error, for the caller to redo it on the shared face.
+ */
+static void *
+_cairo_ft_glyph_job_thread (void *closure)
+{
+    cairo_ft_glyph_job_t *job = closure;
+    cairo_ft_unscaled_font_t *unscaled = &job->pooled->unscaled;
+
+    /* Uncontended, as only we may use the copy whilst it is busy */
+    (void) _cairo_ft_unscaled_font_lock_face (unscaled);
+
+    job->status = _cairo_ft_unscaled_font_set_scale (unscaled,
+						     &job->scaled_font->base.scale);
+    if (likely (job->status == CAIRO_STATUS_SUCCESS))
+	job->status = _cairo_ft_glyph_job_run (job, unscaled);
+
+    _cairo_ft_unscaled_font_unlock_face (unscaled);
+    return NULL;
+}
+
+static int
+_cairo_ft_glyph_num_threads (int num_glyphs)
+{
+    long num_cpus;
+
+    if (pthread_create == NULL || pthread_join == NULL)
+	return 1;
+
+    num_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+    if (num_cpus > MAX_GLYPH_THREADS)
+	num_cpus = MAX_GLYPH_THREADS;
+    if (num_cpus > num_glyphs / MIN_GLYPHS_PER_THREAD)
+	num_cpus = num_glyphs / MIN_GLYPHS_PER_THREAD;
+
+    return num_cpus > 1 ? num_cpus : 1;
+}
+
+/* Load and rasterize a large batch of glyphs by splitting it between
+ * threads, each with a face borrowed from the pool of the font, so that
+ * the batch counts against the same limits as any other copy. The results are only
+ * attached to the glyphs once every thread has finished, as the scaled
+ * font itself is not ours to share.
+ */
+static cairo_int_status_t
+_cairo_ft_scaled_glyphs_init (void			 *abstract_font,
+			      cairo_scaled_glyph_t	**scaled_glyphs,
+			      int			  num_glyphs,
+			      cairo_scaled_glyph_info_t	  info)
+{
+    cairo_ft_scaled_font_t *scaled_font = abstract_font;
+    cairo_ft_unscaled_font_t *unscaled = scaled_font->unscaled;
+    cairo_ft_glyph_job_t jobs[MAX_GLYPH_THREADS];
+    pthread_t threads[MAX_GLYPH_THREADS];
+    cairo_bool_t started[MAX_GLYPH_THREADS];
+    cairo_ft_glyph_result_t *results;
+    cairo_status_t status;
+    FT_Face face;
+    int num_threads, start, i;
+
+    /* Paths are cheap to make and rarely wanted in bulk */
+    if (info & ~(CAIRO_SCALED_GLYPH_INFO_METRICS |
+		 CAIRO_SCALED_GLYPH_INFO_SURFACE))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    /* We can only make copies of faces that we loaded from a file */
+    if (unscaled->from_face)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    num_threads = _cairo_ft_glyph_num_threads (num_glyphs);
+    if (num_threads == 1)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    /* The first share is done on the shared face, the others on whatever
+     * the pool can spare, which may be none at all.
+     */
+    jobs[0].pooled = NULL;
+    for (i = 1; i < num_threads; i++) {
+	jobs[i].pooled = _cairo_ft_pooled_face_borrow (unscaled,
+						       &scaled_font->base.scale);
+	if (jobs[i].pooled == NULL)
+	    break;
+    }
+    num_threads = i;
+    if (num_threads == 1)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    results = _cairo_malloc_ab (num_glyphs, sizeof (cairo_ft_glyph_result_t));
+    if (unlikely (results == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto RELEASE;
+    }
+
+    face = _cairo_ft_unscaled_font_lock_face (unscaled);
+    if (!face) {
+	free (results);
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto RELEASE;
+    }
+
+    status = _cairo_ft_unscaled_font_set_scale (unscaled,
+						&scaled_font->base.scale);
+    if (unlikely (status))
+	goto FAIL;
+
+    /* Whilst we hold the lock on the shared face its scale is fixed, and
+     * the first share of the work is done on it by this thread.
+     */
+    start = 0;
+    for (i = 0; i < num_threads; i++) {
+	cairo_ft_glyph_job_t *job = &jobs[i];
+	int end = (long) num_glyphs * (i + 1) / num_threads;
+
+	job->scaled_font = scaled_font;
+	job->scaled_glyphs = scaled_glyphs + start;
+	job->results = results + start;
+	job->num_glyphs = end - start;
+	job->info = info;
+	job->status = CAIRO_STATUS_SUCCESS;
+	memset (job->results, 0, job->num_glyphs * sizeof (cairo_ft_glyph_result_t));
+	start = end;
+
+	started[i] = i > 0 &&
+	    pthread_create (&threads[i], NULL,
+			    _cairo_ft_glyph_job_thread, job) == 0;
+    }
+
+    for (i = 0; i < num_threads; i++) {
+	cairo_ft_glyph_job_t *job = &jobs[i];
+
+	if (started[i])
+	    pthread_join (threads[i], NULL);
+	else if (job->pooled != NULL)
+	    _cairo_ft_glyph_job_thread (job);
+	else
+	    job->status = _cairo_ft_glyph_job_run (job, unscaled);
+
+	/* Whatever went wrong with a borrowed copy of the face, from failing
+	 * to scale it to running out of memory, is either transient or will
+	 * happen again on the shared face, so redo the share there and
+	 * only report what fails on that.
+	 */
+	if (unlikely (job->status) && job->pooled != NULL) {
+	    int j;
+
+	    for (j = 0; j < job->num_glyphs; j++) {
+		if (job->results[j].surface != NULL)
+		    cairo_surface_destroy (&job->results[j].surface->base);
+	    }
+	    memset (job->results, 0,
+		    job->num_glyphs * sizeof (cairo_ft_glyph_result_t));
+
+	    job->status = _cairo_ft_glyph_job_run (job, unscaled);
+	}
+
+	if (status == CAIRO_STATUS_SUCCESS)
+	    status = job->status;
+    }
+
+    for (i = 0; i < num_glyphs; i++) {
+	cairo_ft_glyph_result_t *result = &results[i];
+
+	if (unlikely (status)) {
+	    if (result->surface != NULL)
+		cairo_surface_destroy (&result->surface->base);
+	    continue;
+	}
+
+	if (info & CAIRO_SCALED_GLYPH_INFO_METRICS) {
+	    _cairo_scaled_glyph_set_metrics (scaled_glyphs[i],
+					     &scaled_font->base,
+					     &result->fs_metrics);
+	}
+
+	if (info & CAIRO_SCALED_GLYPH_INFO_SURFACE) {
+	    _cairo_scaled_glyph_set_surface (scaled_glyphs[i],
+					     &scaled_font->base,
+					     result->surface);
+	}
+    }
+
+ FAIL:
+    _cairo_ft_unscaled_font_unlock_face (unscaled);
+    free (results);
+
+ RELEASE:
+    for (i = 1; i < num_threads; i++)
+	_cairo_ft_pooled_face_release (jobs[i].pooled);
+
+    return status;
+}
+#endif
+
+static unsigned long
+_cairo_ft_ucs4_to_index (void	    *abstract_font,
+			 uint32_t    ucs4)
+{
+    cairo_ft_scaled_font_t *scaled_font = abstract_font;
+    cairo_ft_unscaled_font_t *unscaled = scaled_font->unscaled;
+    FT_Face face;
+    FT_UInt index;
+
+    face = _cairo_ft_unscaled_font_lock_face (unscaled);
+    if (!face)
+	return 0;
 
 #if CAIRO_HAS_FC_FONT
     index = FcFreeTypeCharIndex (face, ucs4);
@@ -2708,7 +3308,12 @@ static const cairo_scaled_font_backend_t _cairo_ft_scaled_font_backend = {
     _cairo_ft_index_to_ucs4,
     _cairo_ft_is_synthetic,
     _cairo_index_to_glyph_name,
-    _cairo_ft_load_type1_data
+    _cairo_ft_load_type1_data,
+#if CAIRO_FT_THREADED_GLYPHS
+    _cairo_ft_scaled_glyphs_init,
+#else
+    NULL,			/* scaled_glyphs_init */
+#endif
 };
 
 /* #cairo_ft_font_face_t */
@@ -2849,6 +3454,311 @@ _cairo_ft_font_face_destroy (void *abstract_face)
     return TRUE;
 }
 
+#if CAIRO_HAS_FC_FONT
+/*
+ * Resolving a pattern through fontconfig, with FcConfigSubstitute() and
+ * FcFontMatch(), is slow, and was repeated for every new toy or pattern
+ * font face even when an identical face had been resolved moments
+ * before and then freed. The resolved faces are kept in a cache shared
+ * by all faces, keyed by the unresolved pattern and the font options,
+ * and flushed whenever the fontconfig configuration changes or fonts
+ * are added to it. As for the resolved face cached on each face, the
+ * size of the font is not part of the key.
+ *
+ * The number of faces kept may be set (or the cache disabled with 0)
+ * by setting CAIRO_FT_RESOLVED_PATTERN_CACHE_SIZE, which is read once,
+ * and again after cairo_debug_reset_static_data(). Setting
+ * CAIRO_DEBUG_FC_MATCH reports each lookup, whether found in the cache or resolved, and the
+ * running totals, on stderr, and the totals again on
+ * cairo_debug_reset_static_data().
+ */
+#define DEFAULT_RESOLVED_PATTERN_CACHE_SIZE 64
+#define MAX_RESOLVED_PATTERN_CACHE_SIZE 4096
+
+typedef struct _cairo_ft_resolved_pattern {
+    cairo_cache_entry_t base;
+
+    FcPattern *pattern;
+    cairo_font_options_t options;
+
+    cairo_font_face_t *font_face;
+} cairo_ft_resolved_pattern_t;
+
+/* All guarded by _cairo_ft_resolved_pattern_mutex */
+static cairo_cache_t _cairo_ft_resolved_pattern_cache;
+static int _cairo_ft_resolved_pattern_cache_size = -1;
+
+/* The configuration the cache was filled from: fonts may be added to
+ * the current configuration without it changing, so the number of
+ * fonts in its sets is kept too. */
+static struct {
+    FcConfig *config;
+    int application_fonts;
+    int system_fonts;
+} _cairo_ft_resolved_pattern_config;
+
+static struct {
+    unsigned int hits;
+    unsigned int matches;
+    cairo_time_t hit_time;
+    cairo_time_t match_time;
+} _cairo_ft_resolved_pattern_stats;
+
+static int
+_cairo_ft_resolved_pattern_debug (void)
+{
+    static int debug = -1;
+
+    if (debug < 0)
+	debug = getenv ("CAIRO_DEBUG_FC_MATCH") != NULL;
+
+    return debug;
+}
+
+static void
+_cairo_ft_resolved_pattern_print_stats (void)
+{
+    fprintf (stderr,
+	     "cairo: %u of %u patterns found in the cache in %.3fms, "
+	     "%u resolved in %.3fms\n",
+	     _cairo_ft_resolved_pattern_stats.hits,
+	     _cairo_ft_resolved_pattern_stats.hits +
+	     _cairo_ft_resolved_pattern_stats.matches,
+	     1e3 * _cairo_time_to_s (_cairo_ft_resolved_pattern_stats.hit_time),
+	     _cairo_ft_resolved_pattern_stats.matches,
+	     1e3 * _cairo_time_to_s (_cairo_ft_resolved_pattern_stats.match_time));
+}
+
+/* Counts a lookup of @pattern that took @t, found in the cache or not. */
+static void
+_cairo_ft_resolved_pattern_count (FcPattern    *pattern,
+				  cairo_bool_t  hit,
+				  cairo_time_t  t)
+{
+    FcChar8 *family = NULL;
+
+    if (! _cairo_ft_resolved_pattern_debug ())
+	return;
+
+    FcPatternGetString (pattern, FC_FAMILY, 0, &family);
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolved_pattern_mutex);
+    if (hit) {
+	_cairo_ft_resolved_pattern_stats.hits++;
+	_cairo_ft_resolved_pattern_stats.hit_time =
+	    _cairo_time_add (_cairo_ft_resolved_pattern_stats.hit_time, t);
+    } else {
+	_cairo_ft_resolved_pattern_stats.matches++;
+	_cairo_ft_resolved_pattern_stats.match_time =
+	    _cairo_time_add (_cairo_ft_resolved_pattern_stats.match_time, t);
+    }
+
+    fprintf (stderr, "cairo: %s \"%s\" in %.3fms\n",
+	     hit ? "found" : "resolved",
+	     family ? (const char *) family : "",
+	     1e3 * _cairo_time_to_s (t));
+    _cairo_ft_resolved_pattern_print_stats ();
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolved_pattern_mutex);
+}
+
+/* Called with _cairo_ft_resolved_pattern_mutex held. */
+static int
+_cairo_ft_resolved_pattern_get_cache_size (void)
+{
+    if (_cairo_ft_resolved_pattern_cache_size < 0) {
+	const char *env = getenv ("CAIRO_FT_RESOLVED_PATTERN_CACHE_SIZE");
+	int size = DEFAULT_RESOLVED_PATTERN_CACHE_SIZE;
+
+	if (env != NULL) {
+	    size = atoi (env);
+	    if (size < 0)
+		size = 0;
+	    if (size > MAX_RESOLVED_PATTERN_CACHE_SIZE)
+		size = MAX_RESOLVED_PATTERN_CACHE_SIZE;
+	}
+
+	_cairo_ft_resolved_pattern_cache_size = size;
+    }
+
+    return _cairo_ft_resolved_pattern_cache_size;
+}
+
+static int
+_cairo_ft_config_count_fonts (FcConfig *config, FcSetName set)
+{
+    FcFontSet *fonts = FcConfigGetFonts (config, set);
+
+    return fonts != NULL ? fonts->nfont : 0;
+}
+
+/* Called with _cairo_ft_resolved_pattern_mutex held. */
+static cairo_bool_t
+_cairo_ft_resolved_pattern_config_is_current (FcConfig *config,
+					      int       application_fonts,
+					      int       system_fonts)
+{
+    return _cairo_ft_resolved_pattern_config.config == config &&
+	   _cairo_ft_resolved_pattern_config.application_fonts == application_fonts &&
+	   _cairo_ft_resolved_pattern_config.system_fonts == system_fonts;
+}
+
+/* Called with _cairo_ft_resolved_pattern_mutex held. */
+static void
+_cairo_ft_resolved_pattern_cache_flush (void)
+{
+    if (_cairo_ft_resolved_pattern_cache.hash_table != NULL) {
+	_cairo_cache_fini (&_cairo_ft_resolved_pattern_cache);
+	_cairo_ft_resolved_pattern_cache.hash_table = NULL;
+    }
+    _cairo_ft_resolved_pattern_config.config = NULL;
+}
+
+static cairo_bool_t
+_cairo_ft_resolved_pattern_equal (const void *key_a, const void *key_b)
+{
+    const cairo_ft_resolved_pattern_t *a = key_a;
+    const cairo_ft_resolved_pattern_t *b = key_b;
+
+    return FcPatternEqual (a->pattern, b->pattern) &&
+	   cairo_font_options_equal (&a->options, &b->options);
+}
+
+static void
+_cairo_ft_resolved_pattern_destroy (void *abstract_entry)
+{
+    cairo_ft_resolved_pattern_t *entry = abstract_entry;
+
+    FcPatternDestroy (entry->pattern);
+    cairo_font_face_destroy (entry->font_face);
+    free (entry);
+}
+
+static cairo_font_face_t *
+_cairo_ft_resolve_pattern_cached (FcPattern		     *pattern,
+				  const cairo_matrix_t       *font_matrix,
+				  const cairo_matrix_t       *ctm,
+				  const cairo_font_options_t *options)
+{
+    cairo_ft_resolved_pattern_t key, *entry;
+    cairo_font_face_t *font_face;
+    FcConfig *config;
+    cairo_time_t t;
+    int cache_size, application_fonts, system_fonts;
+
+    if (! FcInitBringUptoDate ()) {
+	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
+	return (cairo_font_face_t *) &_cairo_font_face_nil;
+    }
+
+    t = _cairo_time_get ();
+
+    key.base.hash = FcPatternHash (pattern) ^ cairo_font_options_hash (options);
+    key.pattern = pattern;
+    key.options = *options;
+
+    config = FcConfigGetCurrent ();
+    application_fonts = _cairo_ft_config_count_fonts (config, FcSetApplication);
+    system_fonts = _cairo_ft_config_count_fonts (config, FcSetSystem);
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolved_pattern_mutex);
+    if (! _cairo_ft_resolved_pattern_config_is_current (config,
+							application_fonts,
+							system_fonts))
+    {
+	_cairo_ft_resolved_pattern_cache_flush ();
+	_cairo_ft_resolved_pattern_config.config = config;
+	_cairo_ft_resolved_pattern_config.application_fonts = application_fonts;
+	_cairo_ft_resolved_pattern_config.system_fonts = system_fonts;
+    }
+    cache_size = _cairo_ft_resolved_pattern_get_cache_size ();
+
+    entry = NULL;
+    if (_cairo_ft_resolved_pattern_cache.hash_table != NULL)
+	entry = _cairo_cache_lookup (&_cairo_ft_resolved_pattern_cache, &key.base);
+    if (entry != NULL)
+	font_face = cairo_font_face_reference (entry->font_face);
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolved_pattern_mutex);
+
+    if (entry != NULL) {
+	_cairo_ft_resolved_pattern_count (pattern, TRUE,
+					  _cairo_time_get_delta (t));
+	return font_face;
+    }
+
+    /* Fontconfig may be slow, so let other threads use the cache
+     * meanwhile. */
+    font_face = _cairo_ft_resolve_pattern (pattern, font_matrix, ctm, options);
+    _cairo_ft_resolved_pattern_count (pattern, FALSE,
+				      _cairo_time_get_delta (t));
+    if (unlikely (font_face->status) || cache_size == 0)
+	return font_face;
+
+    entry = malloc (sizeof (cairo_ft_resolved_pattern_t));
+    if (unlikely (entry == NULL))
+	return font_face;
+
+    entry->pattern = FcPatternDuplicate (pattern);
+    if (unlikely (entry->pattern == NULL)) {
+	free (entry);
+	return font_face;
+    }
+
+    entry->base.hash = key.base.hash;
+    entry->base.size = 1;
+    entry->options = *options;
+    entry->font_face = cairo_font_face_reference (font_face);
+
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolved_pattern_mutex);
+    if (_cairo_ft_resolved_pattern_config_is_current (config,
+						      application_fonts,
+						      system_fonts) &&
+	_cairo_ft_resolved_pattern_cache.hash_table == NULL)
+    {
+	if (_cairo_cache_init (&_cairo_ft_resolved_pattern_cache,
+			       _cairo_ft_resolved_pattern_equal,
+			       NULL,
+			       _cairo_ft_resolved_pattern_destroy,
+			       cache_size))
+	{
+	    _cairo_ft_resolved_pattern_cache.hash_table = NULL;
+	}
+    }
+
+    /* Another thread may have resolved the same pattern meanwhile, or
+     * found the configuration changed, making ours stale. */
+    if (! _cairo_ft_resolved_pattern_config_is_current (config,
+							application_fonts,
+							system_fonts) ||
+	_cairo_ft_resolved_pattern_cache.hash_table == NULL ||
+	_cairo_cache_lookup (&_cairo_ft_resolved_pattern_cache, &key.base) != NULL ||
+	_cairo_cache_insert (&_cairo_ft_resolved_pattern_cache, &entry->base))
+    {
+	_cairo_ft_resolved_pattern_destroy (entry);
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolved_pattern_mutex);
+
+    return font_face;
+}
+
+static void
+_cairo_ft_resolved_pattern_cache_reset (void)
+{
+    CAIRO_MUTEX_LOCK (_cairo_ft_resolved_pattern_mutex);
+    _cairo_ft_resolved_pattern_cache_flush ();
+    _cairo_ft_resolved_pattern_cache_size = -1;
+
+    if (_cairo_ft_resolved_pattern_debug () &&
+	_cairo_ft_resolved_pattern_stats.hits +
+	_cairo_ft_resolved_pattern_stats.matches)
+    {
+	_cairo_ft_resolved_pattern_print_stats ();
+    }
+    memset (&_cairo_ft_resolved_pattern_stats, 0,
+	    sizeof (_cairo_ft_resolved_pattern_stats));
+    CAIRO_MUTEX_UNLOCK (_cairo_ft_resolved_pattern_mutex);
+}
+#endif
+
 static cairo_font_face_t *
 _cairo_ft_font_face_get_implementation (void                     *abstract_face,
 					const cairo_matrix_t       *font_matrix,
@@ -2889,10 +3799,10 @@ _cairo_ft_font_face_get_implementation (void                     *abstract_face,
 	    font_face->resolved_font_face = NULL;
 	}
 
-	resolved = _cairo_ft_resolve_pattern (font_face->pattern,
-					      font_matrix,
-					      ctm,
-					      options);
+	resolved = _cairo_ft_resolve_pattern_cached (font_face->pattern,
+						     font_matrix,
+						     ctm,
+						     options);
 	if (unlikely (resolved->status))
 	    return resolved;
 
@@ -3563,6 +4473,208 @@ cairo_ft_scaled_font_unlock_face (cairo_scaled_font_t *abstract_font)
     _cairo_ft_unscaled_font_unlock_face (scaled_font->unscaled);
 }
 
+/* Identifies the font file, and the FreeType version and settings used
+ * to render it, for the glyph cache file. It is followed by the file
+ * name, family and style of the face.
+ */
+typedef struct _cairo_ft_glyph_cache_key {
+    int32_t ft_version[3];
+    uint32_t load_flags;
+    uint32_t synth_flags;
+    int32_t options[5];
+    int32_t face_index;
+    int32_t num_glyphs;
+    int32_t units_per_em;
+    uint32_t checksum;
+    uint32_t modified[2];
+} cairo_ft_glyph_cache_key_t;
+
+static cairo_status_t
+_cairo_ft_scaled_font_glyph_cache_key (cairo_ft_scaled_font_t *scaled_font,
+				       void **key_out,
+				       unsigned int *length_out)
+{
+    cairo_ft_unscaled_font_t *unscaled = scaled_font->unscaled;
+    const cairo_font_options_t *options = &scaled_font->ft_options.base;
+    cairo_ft_glyph_cache_key_t key;
+    const char *strings[3];
+    unsigned int length, len[3];
+    FT_Int major, minor, patch;
+    TT_Header *head;
+    FT_Face face;
+    char *p;
+    int i;
+
+    face = _cairo_ft_unscaled_font_lock_face (unscaled);
+    if (unlikely (face == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    memset (&key, 0, sizeof (key));
+
+    FT_Library_Version (face->glyph->library, &major, &minor, &patch);
+    key.ft_version[0] = major;
+    key.ft_version[1] = minor;
+    key.ft_version[2] = patch;
+
+    key.load_flags = scaled_font->ft_options.load_flags;
+    key.synth_flags = scaled_font->ft_options.synth_flags;
+    key.options[0] = options->antialias;
+    key.options[1] = options->subpixel_order;
+    key.options[2] = options->lcd_filter;
+    key.options[3] = options->hint_style;
+    key.options[4] = options->hint_metrics;
+
+    key.face_index = face->face_index;
+    key.num_glyphs = face->num_glyphs;
+    key.units_per_em = face->units_per_EM;
+
+    head = FT_Get_Sfnt_Table (face, ft_sfnt_head);
+    if (head != NULL) {
+	key.checksum = head->CheckSum_Adjust;
+	key.modified[0] = head->Modified[0];
+	key.modified[1] = head->Modified[1];
+    }
+
+    strings[0] = unscaled->filename ? unscaled->filename : "";
+    strings[1] = face->family_name ? face->family_name : "";
+    strings[2] = face->style_name ? face->style_name : "";
+
+    length = sizeof (key);
+    for (i = 0; i < 3; i++) {
+	len[i] = strlen (strings[i]) + 1;
+	length += len[i];
+    }
+
+    p = _cairo_malloc (length);
+    if (unlikely (p == NULL)) {
+	_cairo_ft_unscaled_font_unlock_face (unscaled);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    *key_out = p;
+    *length_out = length;
+
+    memcpy (p, &key, sizeof (key));
+    p += sizeof (key);
+    for (i = 0; i < 3; i++) {
+	memcpy (p, strings[i], len[i]);
+	p += len[i];
+    }
+
+    _cairo_ft_unscaled_font_unlock_face (unscaled);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * cairo_ft_scaled_font_write_glyph_cache:
+ * @scaled_font: A #cairo_scaled_font_t from the FreeType font backend.
+ * @write_func: a #cairo_write_func_t to accept the data
+ * @closure: the closure argument for @write_func
+ *
+ * Writes out the metrics and images of all the glyphs currently
+ * cached by @scaled_font, so that a later process may start with them
+ * by passing the data to cairo_ft_scaled_font_load_glyph_cache(). The
+ * data is tied to the font file, the size and transformation of the
+ * font, its font options and the version of FreeType in use.
+ *
+ * @write_func is called with @scaled_font locked, and so must not use
+ * the font.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, or the error returned by
+ * @write_func, or %CAIRO_STATUS_FONT_TYPE_MISMATCH if @scaled_font is
+ * not a FreeType font.
+ *
+ * Since: 1.16
+ **/
+cairo_status_t
+cairo_ft_scaled_font_write_glyph_cache (cairo_scaled_font_t *abstract_font,
+					cairo_write_func_t   write_func,
+					void		    *closure)
+{
+    cairo_ft_scaled_font_t *scaled_font = (cairo_ft_scaled_font_t *) abstract_font;
+    cairo_status_t status;
+    unsigned int length;
+    void *key;
+
+    if (! _cairo_scaled_font_is_ft (abstract_font))
+	return _cairo_error (CAIRO_STATUS_FONT_TYPE_MISMATCH);
+
+    if (scaled_font->base.status)
+	return scaled_font->base.status;
+
+    status = _cairo_ft_scaled_font_glyph_cache_key (scaled_font, &key, &length);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_scaled_font_write_glyph_cache (&scaled_font->base,
+						   key, length,
+						   write_func, closure);
+    free (key);
+
+    return status;
+}
+
+/**
+ * cairo_ft_scaled_font_load_glyph_cache:
+ * @scaled_font: A #cairo_scaled_font_t from the FreeType font backend.
+ * @data: the data written by cairo_ft_scaled_font_write_glyph_cache()
+ * @length: the size of @data in bytes
+ * @destroy: a function to call once @data is no longer needed, or %NULL
+ * @closure: the argument for @destroy
+ *
+ * Adds the glyphs in @data, as written out for a font with the same
+ * file, size, transformation and options by
+ * cairo_ft_scaled_font_write_glyph_cache(), to the glyphs cached by
+ * @scaled_font, so that they need not be rendered again.
+ *
+ * The glyph images are used where they lie in @data rather than
+ * copied, which makes this cheap for a file mapped into memory, but
+ * @data must then remain valid, and unchanged, until @destroy is
+ * called. @data must be aligned to at least 4 bytes.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS if the glyphs were loaded,
+ * %CAIRO_STATUS_FONT_TYPE_MISMATCH if @data was written for a
+ * different font, with different settings or by a different version
+ * of FreeType, or %CAIRO_STATUS_READ_ERROR if @data is damaged. In
+ * those cases nothing is loaded and @destroy is not called. Otherwise
+ * @destroy is called once the font is done with @data, even if
+ * another error is returned.
+ *
+ * Since: 1.16
+ **/
+cairo_status_t
+cairo_ft_scaled_font_load_glyph_cache (cairo_scaled_font_t  *abstract_font,
+				       const unsigned char  *data,
+				       unsigned long	     length,
+				       cairo_destroy_func_t  destroy,
+				       void		    *closure)
+{
+    cairo_ft_scaled_font_t *scaled_font = (cairo_ft_scaled_font_t *) abstract_font;
+    cairo_status_t status;
+    unsigned int key_length;
+    void *key;
+
+    if (! _cairo_scaled_font_is_ft (abstract_font))
+	return _cairo_error (CAIRO_STATUS_FONT_TYPE_MISMATCH);
+
+    if (scaled_font->base.status)
+	return scaled_font->base.status;
+
+    status = _cairo_ft_scaled_font_glyph_cache_key (scaled_font,
+						    &key, &key_length);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_scaled_font_load_glyph_cache (&scaled_font->base,
+						  key, key_length,
+						  data, length,
+						  destroy, closure);
+    free (key);
+
+    return status;
+}
+
 static cairo_bool_t
 _cairo_ft_scaled_font_is_vertical (cairo_scaled_font_t *scaled_font)
 {
@@ -3592,5 +4704,8 @@ _cairo_ft_scaled_font_get_load_flags (cairo_scaled_font_t *scaled_font)
 void
 _cairo_ft_font_reset_static_data (void)
 {
+#if CAIRO_HAS_FC_FONT
+    _cairo_ft_resolved_pattern_cache_reset ();
+#endif
     _cairo_ft_unscaled_font_map_destroy ();
 }
@@ -98,6 +98,18 @@ cairo_ft_scaled_font_lock_face (cairo_scaled_font_t *scaled_font);
 cairo_public void
 cairo_ft_scaled_font_unlock_face (cairo_scaled_font_t *scaled_font);
 
+cairo_public cairo_status_t
+cairo_ft_scaled_font_write_glyph_cache (cairo_scaled_font_t *scaled_font,
+					cairo_write_func_t   write_func,
+					void		    *closure);
+
+cairo_public cairo_status_t
+cairo_ft_scaled_font_load_glyph_cache (cairo_scaled_font_t  *scaled_font,
+				       const unsigned char  *data,
+				       unsigned long	     length,
+				       cairo_destroy_func_t  destroy,
+				       void		    *closure);
+
 #if CAIRO_HAS_FC_FONT
 
 cairo_public cairo_font_face_t *
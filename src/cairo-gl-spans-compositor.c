@@ -431,6 +431,9 @@ _cairo_gl_span_renderer_init (cairo_abstract_span_renderer_t	*_r,
     cairo_operator_t op = composite->op;
     cairo_int_status_t status;
 
+    if (needs_clip)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
     if (op == CAIRO_OPERATOR_SOURCE) {
 	if (! _cairo_pattern_is_opaque (&composite->source_pattern.base,
 					&composite->source_sample_area))
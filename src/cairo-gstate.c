@@ -1335,10 +1335,10 @@ _cairo_gstate_in_fill (cairo_gstate_t	  *gstate,
 {
     _cairo_gstate_user_to_backend (gstate, &x, &y);
 
-    return _cairo_path_fixed_in_fill (path,
-				      gstate->fill_rule,
-				      gstate->tolerance,
-				      x, y);
+    return _cairo_path_fixed_in_fill_indexed (path,
+					      gstate->fill_rule,
+					      gstate->tolerance,
+					      x, y);
 }
 
 cairo_bool_t
@@ -43,6 +43,7 @@
 
 #include "cairoint.h"
 
+#include "cairo-image-surface-inline.h"
 #include "cairo-image-surface-private.h"
 
 #include "cairo-compositor-private.h"
@@ -285,6 +286,75 @@ fill_reduces_to_source (cairo_operator_t op,
     return FALSE;
 }
 
+/* pixman stores a1 pixels in 32-bit words, least significant bit first
+ * on little-endian machines and most significant bit first otherwise.
+ */
+#ifdef WORDS_BIGENDIAN
+#define A1_MASK_FROM(x)		(0xffffffffu >> (x))
+#define A1_MASK_BEFORE(x)	(~(0xffffffffu >> (x)))
+#else
+#define A1_MASK_FROM(x)		(0xffffffffu << (x))
+#define A1_MASK_BEFORE(x)	((1u << (x)) - 1)
+#endif
+
+static cairo_bool_t
+fill_reduces_to_a1 (cairo_operator_t op,
+		    const cairo_color_t *color,
+		    const cairo_image_surface_t *dst,
+		    uint32_t *pixel)
+{
+    if (dst->pixman_format != PIXMAN_a1 ||
+	! __fill_reduces_to_source (op, color, dst))
+	return FALSE;
+
+    /* as pixman, keep just the most significant bit of the alpha */
+    *pixel = op == CAIRO_OPERATOR_CLEAR ? 0 : color->alpha_short >> 15;
+    return TRUE;
+}
+
+/* Set or clear the bits [x1, x2) of an a1 row a word at a time */
+static void
+fill_a1_row (uint8_t *row, int x1, int x2, uint32_t pixel)
+{
+    uint32_t *d = (uint32_t *) row + (x1 >> 5);
+    uint32_t mask = A1_MASK_FROM (x1 & 31);
+    int n = (x2 >> 5) - (x1 >> 5);
+
+    if (n) {
+	*d = pixel ? *d | mask : *d & ~mask;
+	d++;
+
+	if (--n) {
+	    memset (d, pixel ? 0xff : 0, n * sizeof (uint32_t));
+	    d += n;
+	}
+
+	if ((x2 & 31) == 0)
+	    return;
+
+	mask = A1_MASK_BEFORE (x2 & 31);
+    } else
+	mask &= A1_MASK_BEFORE (x2 & 31);
+
+    *d = pixel ? *d | mask : *d & ~mask;
+}
+
+static void
+fill_a1 (cairo_image_surface_t *dst,
+	 int x, int y, int w, int h,
+	 uint32_t pixel)
+{
+    uint8_t *row = dst->data + y * dst->stride;
+
+    if (w <= 0)
+	return;
+
+    while (h--) {
+	fill_a1_row (row, x, x + w, pixel);
+	row += dst->stride;
+    }
+}
+
 static cairo_int_status_t
 fill_rectangles (void			*_dst,
 		 cairo_operator_t	 op,
@@ -306,6 +376,13 @@ fill_rectangles (void			*_dst,
 			 rects[i].width, rects[i].height,
 			 pixel);
 	}
+    } else if (fill_reduces_to_a1 (op, color, dst, &pixel)) {
+	for (i = 0; i < num_rects; i++) {
+	    fill_a1 (dst,
+		     rects[i].x, rects[i].y,
+		     rects[i].width, rects[i].height,
+		     pixel);
+	}
     } else {
 	pixman_image_t *src = _pixman_image_for_color (color);
 	if (unlikely (src == NULL))
@@ -354,6 +431,18 @@ fill_boxes (void		*_dst,
 	    }
 	}
     }
+    else if (fill_reduces_to_a1 (op, color, dst, &pixel))
+    {
+	for (chunk = &boxes->chunks; chunk; chunk = chunk->next) {
+	    for (i = 0; i < chunk->count; i++) {
+		int x = _cairo_fixed_integer_part (chunk->base[i].p1.x);
+		int y = _cairo_fixed_integer_part (chunk->base[i].p1.y);
+		int w = _cairo_fixed_integer_part (chunk->base[i].p2.x) - x;
+		int h = _cairo_fixed_integer_part (chunk->base[i].p2.y) - y;
+		fill_a1 (dst, x, y, w, h, pixel);
+	    }
+	}
+    }
     else
     {
 	pixman_image_t *src = _pixman_image_for_color (color);
@@ -829,7 +918,7 @@ _cairo_image_scaled_glyph_fini (cairo_scaled_font_t *scaled_font,
     if (global_glyph_cache) {
 	pixman_glyph_cache_remove (
 	    global_glyph_cache, scaled_font,
-	    (void *)_cairo_scaled_glyph_index (scaled_glyph));
+	    (void *)_cairo_scaled_glyph_key (scaled_glyph));
     }
 
     CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
@@ -874,9 +963,13 @@ composite_glyphs (void				*_dst,
 
     pg = pglyphs;
     for (i = 0; i < info->num_glyphs; i++) {
-	unsigned long index = info->glyphs[i].index;
+	double x = info->glyphs[i].x;
+	unsigned long index;
 	const void *glyph;
 
+	index = _cairo_scaled_font_glyph_phase (info->font,
+						info->glyphs[i].index, &x);
+
 	glyph = pixman_glyph_cache_lookup (glyph_cache, info->font, (void *)index);
 	if (!glyph) {
 	    cairo_scaled_glyph_t *scaled_glyph;
@@ -905,7 +998,7 @@ composite_glyphs (void				*_dst,
 	    }
 	}
 
-	pg->x = _cairo_lround (info->glyphs[i].x);
+	pg->x = _cairo_lround (x);
 	pg->y = _cairo_lround (info->glyphs[i].y);
 	pg->glyph = glyph;
 	pg++;
@@ -964,12 +1057,17 @@ composite_one_glyph (void				*_dst,
     cairo_image_surface_t *glyph_surface;
     cairo_scaled_glyph_t *scaled_glyph;
     cairo_status_t status;
+    unsigned long index;
+    double gx;
     int x, y;
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
+    gx = info->glyphs[0].x;
+    index = _cairo_scaled_font_glyph_phase (info->font,
+					    info->glyphs[0].index, &gx);
     status = _cairo_scaled_glyph_lookup (info->font,
-					 info->glyphs[0].index,
+					 index,
 					 CAIRO_SCALED_GLYPH_INFO_SURFACE,
 					 &scaled_glyph);
 
@@ -982,8 +1080,7 @@ composite_one_glyph (void				*_dst,
 
     /* round glyph locations to the nearest pixel */
     /* XXX: FRAGILE: We're ignoring device_transform scaling here. A bug? */
-    x = _cairo_lround (info->glyphs[0].x -
-		       glyph_surface->base.device_transform.x0);
+    x = _cairo_lround (gx - glyph_surface->base.device_transform.x0);
     y = _cairo_lround (info->glyphs[0].y -
 		       glyph_surface->base.device_transform.y0);
 
@@ -1017,6 +1114,8 @@ composite_glyphs_via_mask (void				*_dst,
     pixman_image_t *mask;
     pixman_format_code_t format;
     cairo_status_t status;
+    unsigned long glyph_index;
+    double gx;
     int i;
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
@@ -1030,8 +1129,11 @@ composite_glyphs_via_mask (void				*_dst,
      * mask formats.
      */
 
+    gx = info->glyphs[0].x;
+    glyph_index = _cairo_scaled_font_glyph_phase (info->font,
+						  info->glyphs[0].index, &gx);
     status = _cairo_scaled_glyph_lookup (info->font,
-					 info->glyphs[0].index,
+					 glyph_index,
 					 CAIRO_SCALED_GLYPH_INFO_SURFACE,
 					 &scaled_glyph);
     if (unlikely (status)) {
@@ -1040,7 +1142,7 @@ composite_glyphs_via_mask (void				*_dst,
     }
 
     memset (glyph_cache, 0, sizeof (glyph_cache));
-    glyph_cache[info->glyphs[0].index % ARRAY_LENGTH (glyph_cache)] = scaled_glyph;
+    glyph_cache[glyph_index % ARRAY_LENGTH (glyph_cache)] = scaled_glyph;
 
     format = PIXMAN_a8;
     i = (info->extents.width + 3) & ~3;
@@ -1068,14 +1170,19 @@ composite_glyphs_via_mask (void				*_dst,
 
     status = CAIRO_STATUS_SUCCESS;
     for (i = 0; i < info->num_glyphs; i++) {
-	unsigned long glyph_index = info->glyphs[i].index;
-	int cache_index = glyph_index % ARRAY_LENGTH (glyph_cache);
 	cairo_image_surface_t *glyph_surface;
+	int cache_index;
 	int x, y;
 
+	gx = info->glyphs[i].x;
+	glyph_index = _cairo_scaled_font_glyph_phase (info->font,
+						      info->glyphs[i].index,
+						      &gx);
+	cache_index = glyph_index % ARRAY_LENGTH (glyph_cache);
+
 	scaled_glyph = glyph_cache[cache_index];
 	if (scaled_glyph == NULL ||
-	    _cairo_scaled_glyph_index (scaled_glyph) != glyph_index)
+	    _cairo_scaled_glyph_key (scaled_glyph) != glyph_index)
 	{
 	    status = _cairo_scaled_glyph_lookup (info->font, glyph_index,
 						 CAIRO_SCALED_GLYPH_INFO_SURFACE,
@@ -1120,8 +1227,7 @@ composite_glyphs_via_mask (void				*_dst,
 
 	    /* round glyph locations to the nearest pixel */
 	    /* XXX: FRAGILE: We're ignoring device_transform scaling here. A bug? */
-	    x = _cairo_lround (info->glyphs[i].x -
-			       glyph_surface->base.device_transform.x0);
+	    x = _cairo_lround (gx - glyph_surface->base.device_transform.x0);
 	    y = _cairo_lround (info->glyphs[i].y -
 			       glyph_surface->base.device_transform.y0);
 
@@ -1196,12 +1302,18 @@ composite_glyphs (void				*_dst,
 	int x, y;
 	cairo_image_surface_t *glyph_surface;
 	cairo_scaled_glyph_t *scaled_glyph;
-	unsigned long glyph_index = info->glyphs[i].index;
-	int cache_index = glyph_index % ARRAY_LENGTH (glyph_cache);
+	double gx = info->glyphs[i].x;
+	unsigned long glyph_index;
+	int cache_index;
+
+	glyph_index = _cairo_scaled_font_glyph_phase (info->font,
+						      info->glyphs[i].index,
+						      &gx);
+	cache_index = glyph_index % ARRAY_LENGTH (glyph_cache);
 
 	scaled_glyph = glyph_cache[cache_index];
 	if (scaled_glyph == NULL ||
-	    _cairo_scaled_glyph_index (scaled_glyph) != glyph_index)
+	    _cairo_scaled_glyph_key (scaled_glyph) != glyph_index)
 	{
 	    status = _cairo_scaled_glyph_lookup (info->font, glyph_index,
 						 CAIRO_SCALED_GLYPH_INFO_SURFACE,
@@ -1217,8 +1329,7 @@ composite_glyphs (void				*_dst,
 	if (glyph_surface->width && glyph_surface->height) {
 	    /* round glyph locations to the nearest pixel */
 	    /* XXX: FRAGILE: We're ignoring device_transform scaling here. A bug? */
-	    x = _cairo_lround (info->glyphs[i].x -
-			       glyph_surface->base.device_transform.x0);
+	    x = _cairo_lround (gx - glyph_surface->base.device_transform.x0);
 	    y = _cairo_lround (info->glyphs[i].y -
 			       glyph_surface->base.device_transform.y0);
 
@@ -1573,6 +1684,7 @@ typedef struct _cairo_image_span_renderer {
     int bpp;
 
     pixman_image_t *src, *mask;
+    cairo_surface_t *clip;
     union {
 	struct fill {
 	    int stride;
@@ -1596,6 +1708,8 @@ typedef struct _cairo_image_span_renderer {
 	    int src_x, src_y;
 	    int stride;
 	    uint8_t *data;
+	    int clip_stride;
+	    uint8_t *clip_data;
 	} mask;
     } u;
     uint8_t _buf[0];
@@ -1707,6 +1821,30 @@ _cairo_image_finish_spans_and_zero (void *abstract_renderer)
     return CAIRO_STATUS_SUCCESS;
 }
 
+static cairo_status_t
+_fill1_spans (void *abstract_renderer, int y, int h,
+	      const cairo_half_open_span_t *spans, unsigned num_spans)
+{
+    cairo_image_span_renderer_t *r = abstract_renderer;
+
+    if (num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    do {
+	if (spans[0].coverage) {
+	    uint8_t *row = r->u.fill.data + r->u.fill.stride*y;
+	    int hh = h;
+	    do {
+		fill_a1_row (row, spans[0].x, spans[1].x, r->u.fill.pixel);
+		row += r->u.fill.stride;
+	    } while (--hh);
+	}
+	spans++;
+    } while (--num_spans > 1);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 static cairo_status_t
 _fill8_spans (void *abstract_renderer, int y, int h,
 	       const cairo_half_open_span_t *spans, unsigned num_spans)
@@ -2074,6 +2212,10 @@ mono_renderer_init (cairo_image_span_renderer_t	*r,
 	    }
 	    r->u.fill.data = dst->data;
 	    r->u.fill.stride = dst->stride;
+	} else if (fill_reduces_to_a1 (composite->op, color, dst, &r->u.fill.pixel)) {
+	    r->base.render_rows = _fill1_spans;
+	    r->u.fill.data = dst->data;
+	    r->u.fill.stride = dst->stride;
 	}
     } else if ((composite->op == CAIRO_OPERATOR_SOURCE ||
 		(composite->op == CAIRO_OPERATOR_OVER &&
@@ -2936,6 +3078,95 @@ inplace_renderer_init (cairo_image_span_renderer_t	*r,
     return CAIRO_INT_STATUS_SUCCESS;
 }
 
+static cairo_status_t
+_cairo_image_spans_and_clip (void *abstract_renderer,
+			     int y, int height,
+			     const cairo_half_open_span_t *spans,
+			     unsigned num_spans)
+{
+    cairo_image_span_renderer_t *r = abstract_renderer;
+    uint8_t *mask, *clip;
+
+    if (num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    mask = r->u.mask.data + (y - r->u.mask.extents.y) * r->u.mask.stride;
+    mask += spans[0].x - r->u.mask.extents.x;
+    clip = r->u.mask.clip_data + (y - r->u.mask.extents.y) * r->u.mask.clip_stride;
+    clip += spans[0].x - r->u.mask.extents.x;
+
+    do {
+	const cairo_half_open_span_t *s = spans;
+	uint8_t *row = mask, *c = clip;
+	unsigned n = num_spans;
+
+	do {
+	    int len = s[1].x - s[0].x;
+	    if (s[0].coverage) {
+		uint8_t a = r->opacity * s[0].coverage;
+		int i;
+
+		if (a == 0xff) {
+		    memcpy (row, c, len);
+		} else {
+		    for (i = 0; i < len; i++)
+			row[i] = mul8_8 (a, c[i]);
+		}
+	    }
+	    row += len;
+	    c += len;
+	    s++;
+	} while (--n > 1);
+
+	mask += r->u.mask.stride;
+	clip += r->u.mask.clip_stride;
+    } while (--height);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Look up the coverage of the clip over the operation, so that it can be
+ * multiplied into the mask as the spans are rendered. This is only valid for
+ * bounded operators, for which masking the shape and clipping coincide.
+ */
+static cairo_int_status_t
+clip_renderer_init (cairo_image_span_renderer_t	*r,
+		    const cairo_composite_rectangles_t *composite)
+{
+    const cairo_rectangle_int_t *extents = &composite->unbounded;
+    cairo_image_surface_t *clip;
+    int clip_x, clip_y;
+
+    if (! composite->is_bounded)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    clip = (cairo_image_surface_t *)
+	_cairo_clip_get_shared_surface (composite->clip, composite->surface,
+					&clip_x, &clip_y);
+    if (clip == NULL) {
+	clip = (cairo_image_surface_t *)
+	    _cairo_clip_get_surface (composite->clip, composite->surface,
+				     &clip_x, &clip_y);
+    }
+    if (unlikely (clip->base.status))
+	return clip->base.status;
+
+    r->clip = &clip->base;
+
+    if (! _cairo_surface_is_image (&clip->base) ||
+	clip->format != CAIRO_FORMAT_A8 ||
+	extents->x < clip_x || extents->y < clip_y ||
+	extents->x + extents->width > clip_x + clip->width ||
+	extents->y + extents->height > clip_y + clip->height)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    r->u.mask.clip_stride = clip->stride;
+    r->u.mask.clip_data = clip->data;
+    r->u.mask.clip_data += (extents->y - clip_y) * clip->stride;
+    r->u.mask.clip_data += extents->x - clip_x;
+    return CAIRO_STATUS_SUCCESS;
+}
+
 static cairo_int_status_t
 span_renderer_init (cairo_abstract_span_renderer_t	*_r,
 		    const cairo_composite_rectangles_t *composite,
@@ -2951,23 +3182,28 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
     TRACE ((stderr, "%s: antialias=%d, needs_clip=%d\n", __FUNCTION__,
 	    antialias, needs_clip));
 
-    if (needs_clip)
-	return CAIRO_INT_STATUS_UNSUPPORTED;
-
     r->composite = composite;
     r->mask = NULL;
     r->src = NULL;
+    r->clip = NULL;
     r->base.finish = NULL;
+    r->bpp = 0;
 
-    status = mono_renderer_init (r, composite, antialias, needs_clip);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+    if (needs_clip) {
+	status = clip_renderer_init (r, composite);
+	if (unlikely (status))
+	    return status;
+    } else {
+	status = mono_renderer_init (r, composite, antialias, needs_clip);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    return status;
 
-    status = inplace_renderer_init (r, composite, antialias, needs_clip);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+	status = inplace_renderer_init (r, composite, antialias, needs_clip);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    return status;
 
-    r->bpp = 0;
+	r->bpp = 0;
+    }
 
     if (op == CAIRO_OPERATOR_CLEAR) {
 #if PIXMAN_HAS_OP_LERP
@@ -3049,6 +3285,14 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
 					    NULL, 0);
 
 	r->base.render_rows = _cairo_image_spans;
+	r->base.finish = NULL;
+    } else if (r->clip) {
+	memset (r->_buf, 0, r->u.mask.extents.height * r->u.mask.stride);
+	r->mask = pixman_image_create_bits (PIXMAN_a8,
+					    r->u.mask.extents.width,
+					    r->u.mask.extents.height,
+					    (uint32_t *)r->_buf, r->u.mask.stride);
+
 	r->base.finish = NULL;
     } else {
 	r->mask = pixman_image_create_bits (PIXMAN_a8,
@@ -3065,6 +3309,9 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
     r->u.mask.data = (uint8_t *) pixman_image_get_data (r->mask);
     r->u.mask.stride = pixman_image_get_stride (r->mask);
 
+    if (r->clip)
+	r->base.render_rows = _cairo_image_spans_and_clip;
+
     r->u.mask.extents.height += r->u.mask.extents.y;
     return CAIRO_STATUS_SUCCESS;
 }
@@ -3099,6 +3346,7 @@ span_renderer_fini (cairo_abstract_span_renderer_t *_r,
 	pixman_image_unref (r->src);
     if (r->mask)
 	pixman_image_unref (r->mask);
+    cairo_surface_destroy (r->clip);
 }
 #endif
 
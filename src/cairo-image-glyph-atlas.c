@@ -0,0 +1,348 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* A shared atlas for the images of small glyphs.
+ *
+ * Rather than every cached glyph owning a small pixel buffer of its
+ * own, the images of glyphs up to ATLAS_MAX_GLYPH pixels square are
+ * copied into a few large pages, one set of pages per format, and the
+ * glyph surface becomes a view onto its rectangle of the page.
+ *
+ * Each page is carved into horizontal shelves whose heights are
+ * rounded up to a multiple of SHELF_QUANTUM rows. A glyph goes onto
+ * the open shelf of its height class, simply bumping the shelf's fill
+ * position, and a new shelf is stacked on top of the page when the
+ * open one is full. Freeing only counts down the glyphs still living
+ * on the shelf: once a shelf is empty it is rewound, and empty shelves
+ * at the top of a page are handed back for reuse by any height class.
+ * Unlike the quad-tree of cairo-rtree.c, used by the GL and DRM glyph
+ * caches where the whole texture is evicted at once, neither
+ * operation needs to search more than the handful of shelves of a
+ * page.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-image-surface-private.h"
+#include "cairo-list-inline.h"
+
+#define ATLAS_STRIDE		1024	/* bytes in each row of a page */
+#define ATLAS_HEIGHT		256	/* rows in a page */
+#define ATLAS_MAX_GLYPH		64	/* larger glyphs keep their own image */
+#define ATLAS_MAX_PAGES		64	/* per format, 16MiB */
+
+#define SHELF_QUANTUM		4
+#define NUM_SHELF_CLASSES	(ATLAS_MAX_GLYPH / SHELF_QUANTUM)
+#define MAX_SHELVES		(ATLAS_HEIGHT / SHELF_QUANTUM)
+
+typedef struct _cairo_image_glyph_atlas_page cairo_image_glyph_atlas_page_t;
+
+struct _cairo_image_glyph_shelf {
+    cairo_image_glyph_atlas_page_t *page;
+    uint16_t y;
+    uint16_t height;
+    uint16_t x;		/* next free byte in the row */
+    uint16_t live;
+};
+
+struct _cairo_image_glyph_atlas_page {
+    cairo_list_t link;
+    struct _cairo_image_glyph_atlas *atlas;
+    uint8_t *data;
+
+    int live;
+    int used;		/* rows given over to shelves */
+    int num_shelves;
+    cairo_image_glyph_shelf_t *open[NUM_SHELF_CLASSES];
+    cairo_image_glyph_shelf_t shelves[MAX_SHELVES];
+};
+
+typedef struct _cairo_image_glyph_atlas {
+    cairo_list_t pages;
+    int num_pages;
+} cairo_image_glyph_atlas_t;
+
+enum {
+    ATLAS_A1,
+    ATLAS_A8,
+    ATLAS_ARGB32,
+    NUM_ATLASES
+};
+
+#define ATLAS_INIT(n) { \
+    { &_cairo_image_glyph_atlases[n].pages, \
+      &_cairo_image_glyph_atlases[n].pages }, 0 }
+
+/* Only ever touched with _cairo_image_glyph_atlas_mutex held */
+static cairo_image_glyph_atlas_t _cairo_image_glyph_atlases[NUM_ATLASES] = {
+    ATLAS_INIT (ATLAS_A1),
+    ATLAS_INIT (ATLAS_A8),
+    ATLAS_INIT (ATLAS_ARGB32),
+};
+
+static cairo_image_glyph_atlas_t *
+_cairo_image_glyph_atlas_for_format (cairo_format_t format)
+{
+    switch ((int) format) {
+    case CAIRO_FORMAT_A1:
+	return &_cairo_image_glyph_atlases[ATLAS_A1];
+    case CAIRO_FORMAT_A8:
+	return &_cairo_image_glyph_atlases[ATLAS_A8];
+    case CAIRO_FORMAT_ARGB32:
+	return &_cairo_image_glyph_atlases[ATLAS_ARGB32];
+    default:
+	return NULL;
+    }
+}
+
+/* The space a glyph takes along a shelf, padded so that every glyph
+ * starts on a 32-bit boundary (for a1, on a word of pixels) as pixman
+ * requires of the rows of an image.
+ */
+static int
+_cairo_image_glyph_atlas_bytes (cairo_format_t format, int width)
+{
+    switch ((int) format) {
+    case CAIRO_FORMAT_A1:
+	return (width + 31) / 32 * 4;
+    case CAIRO_FORMAT_A8:
+	return (width + 3) & -4;
+    default:
+	return width * 4;
+    }
+}
+
+static cairo_image_glyph_atlas_page_t *
+_cairo_image_glyph_atlas_page_create (cairo_image_glyph_atlas_t *atlas)
+{
+    cairo_image_glyph_atlas_page_t *page;
+
+    page = _cairo_malloc (sizeof (cairo_image_glyph_atlas_page_t) +
+			  ATLAS_STRIDE * ATLAS_HEIGHT);
+    if (unlikely (page == NULL))
+	return NULL;
+
+    page->atlas = atlas;
+    page->data = (uint8_t *) (page + 1);
+    page->live = 0;
+    page->used = 0;
+    page->num_shelves = 0;
+    memset (page->open, 0, sizeof (page->open));
+
+    cairo_list_add (&page->link, &atlas->pages);
+    atlas->num_pages++;
+
+    return page;
+}
+
+static cairo_image_glyph_shelf_t *
+_cairo_image_glyph_atlas_page_get_shelf (cairo_image_glyph_atlas_page_t *page,
+					 int bytes, int height)
+{
+    cairo_image_glyph_shelf_t *shelf;
+    int class = (height - 1) / SHELF_QUANTUM;
+    int i;
+
+    height = (class + 1) * SHELF_QUANTUM;
+
+    shelf = page->open[class];
+    if (shelf != NULL && shelf->x + bytes <= ATLAS_STRIDE)
+	return shelf;
+
+    if (page->used + height <= ATLAS_HEIGHT) {
+	shelf = &page->shelves[page->num_shelves++];
+	shelf->page = page;
+	shelf->y = page->used;
+	shelf->height = height;
+	shelf->x = 0;
+	shelf->live = 0;
+	page->used += height;
+
+	return page->open[class] = shelf;
+    }
+
+    for (i = 0; i < page->num_shelves; i++) {
+	shelf = &page->shelves[i];
+	if (shelf->live == 0 && shelf->height == height)
+	    return page->open[class] = shelf;
+    }
+
+    return NULL;
+}
+
+/**
+ * _cairo_image_glyph_atlas_store:
+ * @image: the image of a glyph
+ * @shelf_out: return location for the space allocated in the atlas
+ *
+ * Copies @image into the glyph atlas and returns a new surface for
+ * the copy, with the same size, format and device transform as @image.
+ * The space must be released with _cairo_image_glyph_atlas_release()
+ * once the returned surface has been finished.
+ *
+ * Return value: the atlas surface, or %NULL if @image does not suit
+ * the atlas, in which case the glyph should keep @image.
+ **/
+cairo_image_surface_t *
+_cairo_image_glyph_atlas_store (cairo_image_surface_t *image,
+				cairo_image_glyph_shelf_t **shelf_out)
+{
+    cairo_image_glyph_atlas_t *atlas;
+    cairo_image_glyph_atlas_page_t *page;
+    cairo_image_glyph_shelf_t *shelf = NULL;
+    cairo_surface_t *surface;
+    uint8_t *src, *dst;
+    int bytes, row, y;
+
+    if (image->base.status ||
+	image->width <= 0 || image->width > ATLAS_MAX_GLYPH ||
+	image->height <= 0 || image->height > ATLAS_MAX_GLYPH)
+	return NULL;
+
+    atlas = _cairo_image_glyph_atlas_for_format (image->format);
+    if (atlas == NULL)
+	return NULL;
+
+    bytes = _cairo_image_glyph_atlas_bytes (image->format, image->width);
+
+    CAIRO_MUTEX_LOCK (_cairo_image_glyph_atlas_mutex);
+
+    cairo_list_foreach_entry (page, cairo_image_glyph_atlas_page_t,
+			      &atlas->pages, link)
+    {
+	shelf = _cairo_image_glyph_atlas_page_get_shelf (page,
+							 bytes, image->height);
+	if (shelf != NULL)
+	    break;
+    }
+
+    if (shelf == NULL && atlas->num_pages < ATLAS_MAX_PAGES) {
+	page = _cairo_image_glyph_atlas_page_create (atlas);
+	if (page != NULL)
+	    shelf = _cairo_image_glyph_atlas_page_get_shelf (page,
+							     bytes,
+							     image->height);
+    }
+
+    if (shelf == NULL) {
+	CAIRO_MUTEX_UNLOCK (_cairo_image_glyph_atlas_mutex);
+	return NULL;
+    }
+
+    dst = shelf->page->data + shelf->y * ATLAS_STRIDE + shelf->x;
+    shelf->x += bytes;
+    shelf->live++;
+    shelf->page->live++;
+
+    CAIRO_MUTEX_UNLOCK (_cairo_image_glyph_atlas_mutex);
+
+    surface = cairo_image_surface_create_for_data (dst,
+						   image->format,
+						   image->width,
+						   image->height,
+						   ATLAS_STRIDE);
+    if (unlikely (surface->status)) {
+	cairo_surface_destroy (surface);
+	_cairo_image_glyph_atlas_release (shelf);
+	return NULL;
+    }
+
+    row = image->width * PIXMAN_FORMAT_BPP (image->pixman_format);
+    row = (row + 7) / 8;
+    src = image->data;
+    for (y = 0; y < image->height; y++) {
+	memcpy (dst, src, row);
+	src += image->stride;
+	dst += ATLAS_STRIDE;
+    }
+
+    surface->is_clear = image->base.is_clear;
+    surface->device_transform = image->base.device_transform;
+    surface->device_transform_inverse = image->base.device_transform_inverse;
+
+    *shelf_out = shelf;
+    return (cairo_image_surface_t *) surface;
+}
+
+void
+_cairo_image_glyph_atlas_release (cairo_image_glyph_shelf_t *shelf)
+{
+    cairo_image_glyph_atlas_page_t *page = shelf->page;
+
+    CAIRO_MUTEX_LOCK (_cairo_image_glyph_atlas_mutex);
+
+    if (--shelf->live == 0) {
+	shelf->x = 0;
+
+	/* return the empty shelves at the top of the page */
+	while (page->num_shelves) {
+	    int class;
+
+	    shelf = &page->shelves[page->num_shelves - 1];
+	    if (shelf->live)
+		break;
+
+	    class = shelf->height / SHELF_QUANTUM - 1;
+	    if (page->open[class] == shelf)
+		page->open[class] = NULL;
+
+	    page->used -= shelf->height;
+	    page->num_shelves--;
+	}
+    }
+
+    /* keep one page of each format around, however few glyphs there are */
+    if (--page->live == 0 && page->atlas->num_pages > 1) {
+	cairo_list_del (&page->link);
+	page->atlas->num_pages--;
+	free (page);
+    }
+
+    CAIRO_MUTEX_UNLOCK (_cairo_image_glyph_atlas_mutex);
+}
+
+void
+_cairo_image_glyph_atlas_reset_static_data (void)
+{
+    int n;
+
+    CAIRO_MUTEX_LOCK (_cairo_image_glyph_atlas_mutex);
+
+    for (n = 0; n < NUM_ATLASES; n++) {
+	cairo_image_glyph_atlas_t *atlas = &_cairo_image_glyph_atlases[n];
+
+	while (! cairo_list_is_empty (&atlas->pages)) {
+	    cairo_image_glyph_atlas_page_t *page =
+		cairo_list_first_entry (&atlas->pages,
+					cairo_image_glyph_atlas_page_t,
+					link);
+
+	    cairo_list_del (&page->link);
+	    free (page);
+	}
+	atlas->num_pages = 0;
+    }
+
+    CAIRO_MUTEX_UNLOCK (_cairo_image_glyph_atlas_mutex);
+}
@@ -330,6 +330,7 @@ row (struct mono_scan_converter *c, unsigned int mask)
     struct edge *edge = c->head.next;
     int xstart = INT_MIN, prev_x = INT_MIN;
     int winding = 0;
+    int is_vertical = 1;
 
     c->num_spans = 0;
     while (&c->tail != edge) {
@@ -337,6 +338,7 @@ row (struct mono_scan_converter *c, unsigned int mask)
 	int xend = I(edge->x.quo);
 
 	if (--edge->height_left) {
+	    is_vertical &= edge->vertical;
 	    if (!edge->vertical) {
 		edge->x.quo += edge->dxdy.quo;
 		edge->x.rem += edge->dxdy.rem;
@@ -375,6 +377,9 @@ row (struct mono_scan_converter *c, unsigned int mask)
 
 	edge = next;
     }
+
+    /* Once the last sloped edge ends, rows can be repeated again. */
+    c->is_vertical = is_vertical;
 }
 
 inline static void dec (struct edge *e, int h)
@@ -515,10 +520,6 @@ mono_scan_converter_render(struct mono_scan_converter *c,
 	    if (unlikely (status))
 		return status;
 	}
-
-	/* XXX recompute after dropping edges? */
-	if (c->head.next == &c->tail)
-	    c->is_vertical = 1;
     }
 
     return CAIRO_STATUS_SUCCESS;
@@ -38,7 +38,10 @@
 
 CAIRO_MUTEX_DECLARE (_cairo_pattern_solid_surface_cache_lock)
 
+CAIRO_MUTEX_DECLARE (_cairo_clip_mask_mutex)
+
 CAIRO_MUTEX_DECLARE (_cairo_image_solid_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_image_glyph_atlas_mutex)
 
 CAIRO_MUTEX_DECLARE (_cairo_toy_font_face_mutex)
 CAIRO_MUTEX_DECLARE (_cairo_intern_string_mutex)
@@ -49,6 +52,8 @@ CAIRO_MUTEX_DECLARE (_cairo_glyph_cache_mutex)
 
 #if CAIRO_HAS_FT_FONT
 CAIRO_MUTEX_DECLARE (_cairo_ft_unscaled_font_map_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_ft_pooled_face_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_ft_resolved_pattern_mutex)
 #endif
 
 #if CAIRO_HAS_WIN32_FONT
@@ -0,0 +1,615 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-array-private.h"
+#include "cairo-combsort-inline.h"
+#include "cairo-error-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-path-private.h"
+
+/* Boolean operations on paths.
+ *
+ * Each operand is flattened into a polygon and reduced under its own fill
+ * rule, so that its winding number is 1 inside and 0 outside. The
+ * operation is then a matter of combining the reduced polygons: union and
+ * exclusive-or merge the edges and reduce them again under the non-zero
+ * and even-odd rules respectively, while intersection and difference go
+ * through the sweep in _cairo_polygon_intersect().
+ *
+ * Either way the result is a set of spans, each bounded by a left edge
+ * (dir +1) and a right edge (dir -1). Taken upwards along the left edges
+ * and downwards along the right, these form the sides of the outline;
+ * what remains are the horizontal stretches where the spans ending at
+ * some y differ from those beginning there. Oriented so, the outline runs
+ * clockwise around the interior, each vertex is entered as often as it
+ * is left and the segments chain up into closed loops.
+ */
+
+#define CAIRO_TOLERANCE_MINIMUM	_cairo_fixed_to_double(1)
+
+typedef struct _cairo_combine_segment {
+    cairo_point_t p1, p2;
+    cairo_bool_t used;
+} cairo_combine_segment_t;
+
+typedef struct _cairo_combine_span {
+    cairo_fixed_t x;
+    int above, below;
+} cairo_combine_span_t;
+
+static cairo_status_t
+_cairo_path_to_reduced_polygon (const cairo_path_t *path,
+				cairo_fill_rule_t fill_rule,
+				double tolerance,
+				cairo_polygon_t *polygon)
+{
+    cairo_path_fixed_t fixed;
+    cairo_status_t status;
+
+    _cairo_polygon_init (polygon, NULL, 0);
+
+    status = _cairo_path_fixed_init_from_path (&fixed, path);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_path_fixed_fill_to_polygon (&fixed, tolerance, polygon);
+    _cairo_path_fixed_fini (&fixed);
+
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_polygon_reduce (polygon, fill_rule);
+
+    return status;
+}
+
+/* Replace a reduced polygon by its complement within @box */
+static cairo_status_t
+_cairo_polygon_complement (cairo_polygon_t *polygon,
+			   const cairo_box_t *box)
+{
+    cairo_line_t line;
+    int n;
+
+    for (n = 0; n < polygon->num_edges; n++)
+	polygon->edges[n].dir = -polygon->edges[n].dir;
+
+    line.p1.x = line.p2.x = box->p1.x;
+    line.p1.y = box->p1.y;
+    line.p2.y = box->p2.y;
+    _cairo_polygon_add_line (polygon, &line, box->p1.y, box->p2.y, 1);
+
+    line.p1.x = line.p2.x = box->p2.x;
+    return _cairo_polygon_add_line (polygon, &line, box->p1.y, box->p2.y, -1);
+}
+
+static cairo_status_t
+_cairo_polygon_combine (cairo_polygon_t *a,
+			cairo_polygon_t *b,
+			cairo_path_combine_op_t op)
+{
+    cairo_fill_rule_t fill_rule = CAIRO_FILL_RULE_WINDING;
+    cairo_status_t status;
+    int n;
+
+    switch (op) {
+    case CAIRO_PATH_COMBINE_XOR:
+	fill_rule = CAIRO_FILL_RULE_EVEN_ODD;
+	/* fall through */
+    case CAIRO_PATH_COMBINE_UNION:
+	for (n = 0; n < b->num_edges; n++) {
+	    const cairo_edge_t *edge = &b->edges[n];
+
+	    status = _cairo_polygon_add_line (a, &edge->line,
+					      edge->top, edge->bottom,
+					      edge->dir);
+	    if (unlikely (status))
+		return status;
+	}
+	return _cairo_polygon_reduce (a, fill_rule);
+
+    case CAIRO_PATH_COMBINE_DIFFERENCE:
+	if (a->num_edges == 0 || b->num_edges == 0)
+	    return CAIRO_STATUS_SUCCESS;
+
+	status = _cairo_polygon_complement (b, &a->extents);
+	if (unlikely (status))
+	    return status;
+	/* fall through */
+    case CAIRO_PATH_COMBINE_INTERSECT:
+	return _cairo_polygon_intersect (a, CAIRO_FILL_RULE_WINDING,
+					 b, CAIRO_FILL_RULE_WINDING);
+
+    default:
+	return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+    }
+}
+
+static inline int
+_cairo_combine_segment_compare (const cairo_combine_segment_t *a,
+				const cairo_combine_segment_t *b)
+{
+    if (a->p1.y != b->p1.y)
+	return a->p1.y < b->p1.y ? -1 : 1;
+    if (a->p1.x != b->p1.x)
+	return a->p1.x < b->p1.x ? -1 : 1;
+    return 0;
+}
+
+static inline int
+_cairo_combine_span_compare (const cairo_combine_span_t *a,
+			     const cairo_combine_span_t *b)
+{
+    return a->x < b->x ? -1 : a->x > b->x;
+}
+
+static int
+_cairo_edge_compare_top (const cairo_edge_t *a,
+			 const cairo_edge_t *b)
+{
+    return a->top < b->top ? -1 : a->top > b->top;
+}
+
+static int
+_cairo_edge_compare_bottom (const cairo_edge_t *a,
+			    const cairo_edge_t *b)
+{
+    return a->bottom < b->bottom ? -1 : a->bottom > b->bottom;
+}
+
+#define SEGMENT_CMP(a, b) _cairo_combine_segment_compare (&(a), &(b))
+CAIRO_COMBSORT_DECLARE (_cairo_combine_segment_sort,
+			cairo_combine_segment_t,
+			SEGMENT_CMP)
+
+#define SPAN_CMP(a, b) _cairo_combine_span_compare (&(a), &(b))
+CAIRO_COMBSORT_DECLARE (_cairo_combine_span_sort,
+			cairo_combine_span_t,
+			SPAN_CMP)
+
+CAIRO_COMBSORT_DECLARE (_cairo_edge_sort_by_top,
+			const cairo_edge_t *,
+			_cairo_edge_compare_top)
+
+CAIRO_COMBSORT_DECLARE (_cairo_edge_sort_by_bottom,
+			const cairo_edge_t *,
+			_cairo_edge_compare_bottom)
+
+static inline cairo_fixed_t
+_line_x_for_y (const cairo_line_t *line, cairo_fixed_t y)
+{
+    return _cairo_edge_compute_intersection_x_for_y (&line->p1, &line->p2, y);
+}
+
+static cairo_status_t
+_add_segment (cairo_array_t *segments,
+	      cairo_fixed_t x1, cairo_fixed_t y1,
+	      cairo_fixed_t x2, cairo_fixed_t y2)
+{
+    cairo_combine_segment_t s;
+
+    if (x1 == x2 && y1 == y2)
+	return CAIRO_STATUS_SUCCESS;
+
+    s.p1.x = x1;
+    s.p1.y = y1;
+    s.p2.x = x2;
+    s.p2.y = y2;
+    s.used = FALSE;
+
+    return _cairo_array_append (segments, &s);
+}
+
+/* Emit the horizontal stretches of outline at @y, where the spans of the
+ * polygon ending there (above) meet those starting there (below). The
+ * top of a span runs left to right and its bottom right to left, so where
+ * the two disagree what remains is their difference, counted with
+ * multiplicity: rounding may leave neighbouring spans overlapping by a
+ * fraction of a unit, and the outline must still balance there.
+ */
+static cairo_status_t
+_add_horizontal_segments (cairo_array_t *segments,
+			  cairo_combine_span_t *spans,
+			  int num_spans,
+			  cairo_fixed_t y)
+{
+    int n, net, start_net = 0;
+    cairo_fixed_t start_x = 0;
+    cairo_status_t status;
+
+    _cairo_combine_span_sort (spans, num_spans);
+
+    net = 0;
+    n = 0;
+    while (n < num_spans) {
+	cairo_fixed_t x = spans[n].x;
+
+	do {
+	    net += spans[n].below - spans[n].above;
+	} while (++n < num_spans && spans[n].x == x);
+
+	if (net == start_net)
+	    continue;
+
+	for (; start_net > 0; start_net--) {
+	    status = _add_segment (segments, start_x, y, x, y);
+	    if (unlikely (status))
+		return status;
+	}
+	for (; start_net < 0; start_net++) {
+	    status = _add_segment (segments, x, y, start_x, y);
+	    if (unlikely (status))
+		return status;
+	}
+
+	start_net = net;
+	start_x = x;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_polygon_to_segments (const cairo_polygon_t *polygon,
+			    cairo_array_t *segments)
+{
+    const cairo_edge_t **tops, **bottoms;
+    cairo_combine_span_t *spans;
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+    int num_edges = polygon->num_edges;
+    int i, t, b;
+
+    if (num_edges == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    tops = _cairo_malloc_ab (2 * num_edges, sizeof (cairo_edge_t *));
+    if (unlikely (tops == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    bottoms = tops + num_edges;
+
+    spans = _cairo_malloc_ab (2 * num_edges, sizeof (cairo_combine_span_t));
+    if (unlikely (spans == NULL)) {
+	free (tops);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    for (i = 0; i < num_edges; i++) {
+	const cairo_edge_t *edge = &polygon->edges[i];
+	cairo_fixed_t top = _line_x_for_y (&edge->line, edge->top);
+	cairo_fixed_t bottom = _line_x_for_y (&edge->line, edge->bottom);
+
+	/* left sides climb, right sides descend */
+	if (edge->dir > 0)
+	    status = _add_segment (segments, bottom, edge->bottom, top, edge->top);
+	else
+	    status = _add_segment (segments, top, edge->top, bottom, edge->bottom);
+	if (unlikely (status))
+	    goto BAIL;
+
+	tops[i] = bottoms[i] = edge;
+    }
+
+    _cairo_edge_sort_by_top (tops, num_edges);
+    _cairo_edge_sort_by_bottom (bottoms, num_edges);
+
+    /* Walk the distinct y at which any edge begins or ends */
+    t = b = 0;
+    while (t < num_edges || b < num_edges) {
+	cairo_fixed_t y;
+	int num_spans = 0;
+
+	if (b == num_edges ||
+	    (t < num_edges && tops[t]->top < bottoms[b]->bottom))
+	    y = tops[t]->top;
+	else
+	    y = bottoms[b]->bottom;
+
+	for (; t < num_edges && tops[t]->top == y; t++) {
+	    spans[num_spans].x = _line_x_for_y (&tops[t]->line, y);
+	    spans[num_spans].above = 0;
+	    spans[num_spans].below = tops[t]->dir;
+	    num_spans++;
+	}
+
+	for (; b < num_edges && bottoms[b]->bottom == y; b++) {
+	    spans[num_spans].x = _line_x_for_y (&bottoms[b]->line, y);
+	    spans[num_spans].above = bottoms[b]->dir;
+	    spans[num_spans].below = 0;
+	    num_spans++;
+	}
+
+	status = _add_horizontal_segments (segments, spans, num_spans, y);
+	if (unlikely (status))
+	    break;
+    }
+
+BAIL:
+    free (spans);
+    free (tops);
+
+    return status;
+}
+
+static cairo_bool_t
+_points_colinear (const cairo_point_t *a,
+		  const cairo_point_t *b,
+		  const cairo_point_t *c)
+{
+    cairo_int64_t ab, bc;
+
+    ab = _cairo_int32x32_64_mul (b->x - a->x, c->y - b->y);
+    bc = _cairo_int32x32_64_mul (b->y - a->y, c->x - b->x);
+
+    return _cairo_int64_eq (ab, bc);
+}
+
+/* Chain the segments into closed loops, appending the vertices of each
+ * to @points and its length to @lengths. Vertices lying on the straight
+ * line between their neighbours are dropped.
+ */
+static cairo_status_t
+_cairo_segments_to_contours (cairo_combine_segment_t *segments,
+			     int num_segments,
+			     cairo_array_t *points,
+			     cairo_array_t *lengths)
+{
+    cairo_status_t status;
+    int n;
+
+    if (num_segments == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    _cairo_combine_segment_sort (segments, num_segments);
+
+    for (n = 0; n < num_segments; n++) {
+	cairo_combine_segment_t *s = &segments[n];
+	cairo_point_t *base;
+	int first, count;
+
+	if (s->used)
+	    continue;
+
+	first = _cairo_array_num_elements (points);
+	count = 0;
+
+	do {
+	    cairo_combine_segment_t key;
+	    int lo, hi;
+
+	    s->used = TRUE;
+
+	    base = count >= 2 ? _cairo_array_index (points, first) : NULL;
+	    if (base != NULL &&
+		_points_colinear (&base[count-2], &base[count-1], &s->p2))
+	    {
+		base[count-1] = s->p2;
+	    }
+	    else
+	    {
+		status = _cairo_array_append (points, &s->p2);
+		if (unlikely (status))
+		    return status;
+		count++;
+	    }
+
+	    if (s->p2.x == segments[n].p1.x && s->p2.y == segments[n].p1.y)
+		break;
+
+	    /* find an unused segment leaving our end point */
+	    key.p1 = s->p2;
+	    lo = 0, hi = num_segments;
+	    while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (_cairo_combine_segment_compare (&segments[mid], &key) < 0)
+		    lo = mid + 1;
+		else
+		    hi = mid;
+	    }
+
+	    s = NULL;
+	    while (lo < num_segments &&
+		   _cairo_combine_segment_compare (&segments[lo], &key) == 0)
+	    {
+		if (! segments[lo].used) {
+		    s = &segments[lo];
+		    break;
+		}
+		lo++;
+	    }
+	} while (s != NULL);
+
+	/* the loop closes back onto its first vertex, the start of
+	 * segments[n]; drop it or the last if they merely continue a line */
+	base = _cairo_array_index (points, first);
+	while (count >= 3 &&
+	       _points_colinear (&base[count-2], &base[count-1], &base[0]))
+	{
+	    count--;
+	}
+	while (count >= 3 &&
+	       _points_colinear (&base[count-1], &base[0], &base[1]))
+	{
+	    memmove (base, base + 1, (count - 1) * sizeof (cairo_point_t));
+	    count--;
+	}
+
+	if (count < 3) {
+	    _cairo_array_truncate (points, first);
+	    continue;
+	}
+
+	_cairo_array_truncate (points, first + count);
+	status = _cairo_array_append (lengths, &count);
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_path_t *
+_cairo_path_create_from_contours (cairo_array_t *points,
+				  cairo_array_t *lengths)
+{
+    const cairo_point_t *p;
+    const int *length;
+    cairo_path_data_t *data;
+    cairo_path_t *path;
+    int num_contours, n, i;
+
+    path = malloc (sizeof (cairo_path_t));
+    if (unlikely (path == NULL))
+	return _cairo_path_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+
+    num_contours = _cairo_array_num_elements (lengths);
+    length = _cairo_array_index (lengths, 0);
+
+    /* a move-to or line-to per vertex, and a close-path per contour */
+    path->num_data = 2 * _cairo_array_num_elements (points) + num_contours;
+    path->data = NULL;
+    path->status = CAIRO_STATUS_SUCCESS;
+    if (path->num_data == 0)
+	return path;
+
+    path->data = _cairo_malloc_ab (path->num_data, sizeof (cairo_path_data_t));
+    if (unlikely (path->data == NULL)) {
+	free (path);
+	return _cairo_path_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    data = path->data;
+    p = _cairo_array_index (points, 0);
+    for (n = 0; n < num_contours; n++) {
+	for (i = 0; i < length[n]; i++) {
+	    data[0].header.type = i ? CAIRO_PATH_LINE_TO : CAIRO_PATH_MOVE_TO;
+	    data[0].header.length = 2;
+	    data[1].point.x = _cairo_fixed_to_double (p->x);
+	    data[1].point.y = _cairo_fixed_to_double (p->y);
+	    data += 2;
+	    p++;
+	}
+
+	data[0].header.type = CAIRO_PATH_CLOSE_PATH;
+	data[0].header.length = 1;
+	data++;
+    }
+    assert (data - path->data == path->num_data);
+
+    return path;
+}
+
+/**
+ * cairo_path_combine:
+ * @a: the first operand
+ * @fill_rule_a: the fill rule with which to interpret @a
+ * @b: the second operand
+ * @fill_rule_b: the fill rule with which to interpret @b
+ * @op: the boolean operation to apply
+ * @tolerance: the tolerance used when flattening curves, as for
+ * cairo_set_tolerance()
+ *
+ * Computes the outline of the area covered by @op applied to the areas
+ * that would be filled by @a and @b, each under its own fill rule. The
+ * resulting path consists of straight, closed, non-overlapping contours
+ * running clockwise around the filled area (with the y axis pointing
+ * down), and so may be filled with either fill rule. Any curves in the
+ * operands are flattened according to @tolerance.
+ *
+ * This allows overlapping shapes to be merged once in advance, rather
+ * than overdrawing the shared area every time they are filled.
+ *
+ * The coordinates of both operands are taken as they are, independent of
+ * any transformation, and are computed with the precision cairo uses for
+ * device space: 1/256 of a unit, over a range of about ±8 million units.
+ * Scale the paths first to retain finer detail.
+ *
+ * Return value: the combined path. The caller owns the returned object
+ * and should call cairo_path_destroy() when finished with it. If either
+ * operand is in an error state, the returned path carries the same
+ * status; malformed path data or an unknown @op result in
+ * %CAIRO_STATUS_INVALID_PATH_DATA. If there is insufficient memory, a
+ * pointer to a special static nil #cairo_path_t with status
+ * %CAIRO_STATUS_NO_MEMORY will be returned instead.
+ *
+ * Since: 1.16
+ **/
+cairo_path_t *
+cairo_path_combine (const cairo_path_t *a,
+		    cairo_fill_rule_t fill_rule_a,
+		    const cairo_path_t *b,
+		    cairo_fill_rule_t fill_rule_b,
+		    cairo_path_combine_op_t op,
+		    double tolerance)
+{
+    cairo_polygon_t polygon_a, polygon_b;
+    cairo_array_t segments, points, lengths;
+    cairo_path_t *path;
+    cairo_status_t status;
+
+    if (a == NULL || b == NULL)
+	return _cairo_path_create_in_error (_cairo_error (CAIRO_STATUS_NULL_POINTER));
+
+    if (tolerance < CAIRO_TOLERANCE_MINIMUM)
+	tolerance = CAIRO_TOLERANCE_MINIMUM;
+
+    status = _cairo_path_to_reduced_polygon (a, fill_rule_a, tolerance,
+					     &polygon_a);
+    if (unlikely (status)) {
+	_cairo_polygon_fini (&polygon_a);
+	return _cairo_path_create_in_error (status);
+    }
+
+    status = _cairo_path_to_reduced_polygon (b, fill_rule_b, tolerance,
+					     &polygon_b);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_polygon_combine (&polygon_a, &polygon_b, op);
+    _cairo_polygon_fini (&polygon_b);
+
+    _cairo_array_init (&segments, sizeof (cairo_combine_segment_t));
+    _cairo_array_init (&points, sizeof (cairo_point_t));
+    _cairo_array_init (&lengths, sizeof (int));
+
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_polygon_to_segments (&polygon_a, &segments);
+    _cairo_polygon_fini (&polygon_a);
+
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_segments_to_contours (_cairo_array_index (&segments, 0),
+					      _cairo_array_num_elements (&segments),
+					      &points, &lengths);
+    _cairo_array_fini (&segments);
+
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	path = _cairo_path_create_from_contours (&points, &lengths);
+    else
+	path = _cairo_path_create_in_error (status);
+
+    _cairo_array_fini (&points);
+    _cairo_array_fini (&lengths);
+
+    return path;
+}
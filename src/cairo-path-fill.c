@@ -144,12 +144,24 @@ _cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
     filler.current_point.y = 0;
     filler.last_move_to = filler.current_point;
 
-    status = _cairo_path_fixed_interpret (path,
-					  _cairo_filler_move_to,
-					  _cairo_filler_line_to,
-					  _cairo_filler_curve_to,
-					  _cairo_filler_close,
-					  &filler);
+    /* A closed subpath contributes nothing to the winding outside of its
+     * own extents, so those lying beyond the limits can be dropped whole.
+     */
+    if (filler.has_limits) {
+	status = _cairo_path_fixed_interpret_culled (path, &filler.limit,
+						     _cairo_filler_move_to,
+						     _cairo_filler_line_to,
+						     _cairo_filler_curve_to,
+						     _cairo_filler_close,
+						     &filler);
+    } else {
+	status = _cairo_path_fixed_interpret (path,
+					      _cairo_filler_move_to,
+					      _cairo_filler_line_to,
+					      _cairo_filler_curve_to,
+					      _cairo_filler_close,
+					      &filler);
+    }
     if (unlikely (status))
 	return status;
 
@@ -73,6 +73,8 @@ typedef char cairo_path_op_t;
     while ((pos__ = cairo_path_buf_next (pos__)) !=  cairo_path_head (path__))
 
 
+typedef struct _cairo_path_in_fill_index cairo_path_in_fill_index_t;
+
 typedef struct _cairo_path_buf {
     cairo_list_t link;
     unsigned int num_ops;
@@ -112,9 +114,15 @@ struct _cairo_path_fixed {
 
     cairo_box_t extents;
 
+    /* lazily built to speed up repeated hit-testing, see cairo-path-in-fill.c */
+    cairo_path_in_fill_index_t *in_fill_index;
+
     cairo_path_buf_fixed_t  buf;
 };
 
+cairo_private void
+_cairo_path_in_fill_index_destroy (cairo_path_in_fill_index_t *index);
+
 cairo_private void
 _cairo_path_fixed_translate (cairo_path_fixed_t *path,
 			     cairo_fixed_t offx,
@@ -69,6 +69,16 @@ _cairo_path_buf_add_points (cairo_path_buf_t       *buf,
 			    const cairo_point_t    *points,
 			    int		            num_points);
 
+/* Any change to the geometry invalidates the hit-testing index */
+static inline void
+_cairo_path_fixed_drop_index (cairo_path_fixed_t *path)
+{
+    if (unlikely (path->in_fill_index != NULL)) {
+	_cairo_path_in_fill_index_destroy (path->in_fill_index);
+	path->in_fill_index = NULL;
+    }
+}
+
 void
 _cairo_path_fixed_init (cairo_path_fixed_t *path)
 {
@@ -98,6 +108,8 @@ _cairo_path_fixed_init (cairo_path_fixed_t *path)
 
     path->extents.p1.x = path->extents.p1.y = 0;
     path->extents.p2.x = path->extents.p2.y = 0;
+
+    path->in_fill_index = NULL;
 }
 
 cairo_status_t
@@ -130,6 +142,8 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
 
     path->extents = other->extents;
 
+    path->in_fill_index = NULL;
+
     path->buf.base.num_ops = other->buf.base.num_ops;
     path->buf.base.num_points = other->buf.base.num_points;
     memcpy (path->buf.op, other->buf.base.op,
@@ -340,6 +354,9 @@ _cairo_path_fixed_fini (cairo_path_fixed_t *path)
 {
     cairo_path_buf_t *buf;
 
+    if (path->in_fill_index != NULL)
+	_cairo_path_in_fill_index_destroy (path->in_fill_index);
+
     buf = cairo_path_buf_next (cairo_path_head (path));
     while (buf != cairo_path_head (path)) {
 	cairo_path_buf_t *this = buf;
@@ -391,6 +408,8 @@ _cairo_path_fixed_drop_line_to (cairo_path_fixed_t *path)
 
     assert (_cairo_path_fixed_last_op (path) == CAIRO_PATH_OP_LINE_TO);
 
+    _cairo_path_fixed_drop_index (path);
+
     buf = cairo_path_tail (path);
     buf->num_points--;
     buf->num_ops--;
@@ -697,6 +716,8 @@ _cairo_path_fixed_add (cairo_path_fixed_t   *path,
 {
     cairo_path_buf_t *buf = cairo_path_tail (path);
 
+    _cairo_path_fixed_drop_index (path);
+
     if (buf->num_ops + 1 > buf->size_ops ||
 	buf->num_points + num_points > buf->size_points)
     {
@@ -853,6 +874,177 @@ _cairo_path_fixed_interpret (const cairo_path_fixed_t		*path,
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* Does the control polygon of the subpath beginning with the MOVE_TO at
+ * @op (whose point is @points) come anywhere near @bounds? The hull of the
+ * control points contains the curves, so this is conservative.
+ */
+static cairo_bool_t
+_cairo_path_fixed_subpath_intersects (const cairo_path_fixed_t *path,
+				      const cairo_path_buf_t *buf,
+				      unsigned int op,
+				      const cairo_point_t *points,
+				      const cairo_box_t *bounds)
+{
+    cairo_box_t box;
+
+    box.p1 = box.p2 = *points++;
+    op++;
+    do {
+	for (; op < buf->num_ops; op++) {
+	    int n;
+
+	    switch (buf->op[op]) {
+	    case CAIRO_PATH_OP_MOVE_TO:
+		goto done;
+	    case CAIRO_PATH_OP_LINE_TO:
+		n = 1;
+		break;
+	    case CAIRO_PATH_OP_CURVE_TO:
+		n = 3;
+		break;
+	    default:
+		ASSERT_NOT_REACHED;
+	    case CAIRO_PATH_OP_CLOSE_PATH:
+		n = 0;
+		break;
+	    }
+
+	    while (n--)
+		_cairo_box_add_point (&box, points++);
+
+	    /* Once overlapping, it stays that way */
+	    if (box.p2.x >= bounds->p1.x && box.p1.x <= bounds->p2.x &&
+		box.p2.y >= bounds->p1.y && box.p1.y <= bounds->p2.y)
+		return TRUE;
+	}
+
+	buf = cairo_path_buf_next (buf);
+	points = buf->points;
+	op = 0;
+    } while (buf != cairo_path_head (path));
+
+done:
+    return
+	box.p2.x >= bounds->p1.x && box.p1.x <= bounds->p2.x &&
+	box.p2.y >= bounds->p1.y && box.p1.y <= bounds->p2.y;
+}
+
+/**
+ * _cairo_path_fixed_interpret_culled:
+ *
+ * As _cairo_path_fixed_interpret(), except that whole subpaths lying
+ * outside @bounds are dropped before any of their segments reach the
+ * callbacks. This is only valid for consumers for which such a subpath
+ * cannot affect the output within @bounds, i.e. fills and strokes where
+ * @bounds has been extended by the stroke's reach.
+ **/
+cairo_status_t
+_cairo_path_fixed_interpret_culled (const cairo_path_fixed_t		*path,
+				    const cairo_box_t			*bounds,
+				    cairo_path_fixed_move_to_func_t	*move_to,
+				    cairo_path_fixed_line_to_func_t	*line_to,
+				    cairo_path_fixed_curve_to_func_t	*curve_to,
+				    cairo_path_fixed_close_path_func_t	*close_path,
+				    void				*closure)
+{
+    const cairo_path_buf_t *buf;
+    cairo_bool_t culled = FALSE;
+    cairo_status_t status;
+
+    if (_cairo_box_contains_point (bounds, &path->extents.p1) &&
+	_cairo_box_contains_point (bounds, &path->extents.p2))
+    {
+	return _cairo_path_fixed_interpret (path,
+					    move_to, line_to,
+					    curve_to, close_path,
+					    closure);
+    }
+
+    cairo_path_foreach_buf_start (buf, path) {
+	const cairo_point_t *points = buf->points;
+	unsigned int i;
+
+	for (i = 0; i < buf->num_ops; i++) {
+	    status = CAIRO_STATUS_SUCCESS;
+	    switch (buf->op[i]) {
+	    case CAIRO_PATH_OP_MOVE_TO:
+		culled = ! _cairo_path_fixed_subpath_intersects (path, buf, i,
+								 points,
+								 bounds);
+		if (! culled)
+		    status = (*move_to) (closure, &points[0]);
+		points += 1;
+		break;
+	    case CAIRO_PATH_OP_LINE_TO:
+		if (! culled)
+		    status = (*line_to) (closure, &points[0]);
+		points += 1;
+		break;
+	    case CAIRO_PATH_OP_CURVE_TO:
+		if (! culled)
+		    status = (*curve_to) (closure, &points[0], &points[1], &points[2]);
+		points += 3;
+		break;
+	    default:
+		ASSERT_NOT_REACHED;
+	    case CAIRO_PATH_OP_CLOSE_PATH:
+		if (! culled)
+		    status = (*close_path) (closure);
+		break;
+	    }
+
+	    if (unlikely (status))
+		return status;
+	}
+    } cairo_path_foreach_buf_end (buf, path);
+
+    if (path->needs_move_to && path->has_current_point)
+	return (*move_to) (closure, &path->current_point);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Counts the subpaths _cairo_path_fixed_interpret_culled() would drop */
+unsigned int
+_cairo_path_fixed_count_culled (const cairo_path_fixed_t *path,
+				const cairo_box_t *bounds)
+{
+    const cairo_path_buf_t *buf;
+    unsigned int num_culled = 0;
+
+    if (_cairo_box_contains_point (bounds, &path->extents.p1) &&
+	_cairo_box_contains_point (bounds, &path->extents.p2))
+	return 0;
+
+    cairo_path_foreach_buf_start (buf, path) {
+	const cairo_point_t *points = buf->points;
+	unsigned int i;
+
+	for (i = 0; i < buf->num_ops; i++) {
+	    switch (buf->op[i]) {
+	    case CAIRO_PATH_OP_MOVE_TO:
+		if (! _cairo_path_fixed_subpath_intersects (path, buf, i,
+							    points, bounds))
+		    num_culled++;
+		points += 1;
+		break;
+	    case CAIRO_PATH_OP_LINE_TO:
+		points += 1;
+		break;
+	    case CAIRO_PATH_OP_CURVE_TO:
+		points += 3;
+		break;
+	    default:
+		ASSERT_NOT_REACHED;
+	    case CAIRO_PATH_OP_CLOSE_PATH:
+		break;
+	    }
+	}
+    } cairo_path_foreach_buf_end (buf, path);
+
+    return num_culled;
+}
+
 typedef struct _cairo_path_fixed_append_closure {
     cairo_point_t	    offset;
     cairo_path_fixed_t	    *path;
@@ -940,6 +1132,8 @@ _cairo_path_fixed_offset_and_scale (cairo_path_fixed_t *path,
 	return;
     }
 
+    _cairo_path_fixed_drop_index (path);
+
     path->last_move_point.x = _cairo_fixed_mul (scalex, path->last_move_point.x) + offx;
     path->last_move_point.y = _cairo_fixed_mul (scaley, path->last_move_point.y) + offy;
     path->current_point.x   = _cairo_fixed_mul (scalex, path->current_point.x) + offx;
@@ -994,6 +1188,8 @@ _cairo_path_fixed_translate (cairo_path_fixed_t *path,
     if (offx == 0 && offy == 0)
 	return;
 
+    _cairo_path_fixed_drop_index (path);
+
     path->last_move_point.x += offx;
     path->last_move_point.y += offy;
     path->current_point.x += offx;
@@ -1063,6 +1259,8 @@ _cairo_path_fixed_transform (cairo_path_fixed_t	*path,
 	return;
     }
 
+    _cairo_path_fixed_drop_index (path);
+
     _cairo_path_fixed_transform_point (&path->last_move_point, matrix);
     _cairo_path_fixed_transform_point (&path->current_point, matrix);
 
@@ -1459,6 +1657,239 @@ _cairo_path_fixed_is_rectangle (const cairo_path_fixed_t *path,
     return FALSE;
 }
 
+typedef struct _cairo_ellipse_fit {
+    double tolerance;
+    cairo_ellipse_double_t ellipse;
+
+    double sum_x, sum_y;
+    double sum_xx, sum_xy, sum_yy;
+
+    double sweep;
+    int num_curves;
+} cairo_ellipse_fit_t;
+
+/* Walk the curves of a path consisting of a single closed subpath built
+ * solely from curve-to segments (plus the degenerate line-to that
+ * cairo_arc() may leave behind), as is generated by a full circle.
+ */
+static cairo_bool_t
+_ellipse_fit_foreach_curve (const cairo_path_fixed_t *path,
+			    cairo_bool_t (*func) (cairo_ellipse_fit_t *fit,
+						  const cairo_point_t *p0,
+						  const cairo_point_t *p),
+			    cairo_ellipse_fit_t *fit)
+{
+    const cairo_path_buf_t *buf;
+    const cairo_point_t *start = NULL, *current = NULL;
+    enum { START, CURVES, CLOSED, DONE } state = START;
+
+    cairo_path_foreach_buf_start (buf, path) {
+	const cairo_point_t *points = buf->points;
+	unsigned int i;
+
+	for (i = 0; i < buf->num_ops; i++) {
+	    switch (buf->op[i]) {
+	    case CAIRO_PATH_OP_MOVE_TO:
+		if (state == START) {
+		    start = current = points;
+		    state = CURVES;
+		} else if (state == CLOSED) {
+		    state = DONE;
+		} else {
+		    return FALSE;
+		}
+		points++;
+		break;
+
+	    case CAIRO_PATH_OP_LINE_TO:
+		if (state != CURVES ||
+		    points->x != current->x || points->y != current->y)
+		{
+		    return FALSE;
+		}
+		points++;
+		break;
+
+	    case CAIRO_PATH_OP_CURVE_TO:
+		if (state != CURVES)
+		    return FALSE;
+		if (! func (fit, current, points))
+		    return FALSE;
+		current = &points[2];
+		points += 3;
+		break;
+
+	    case CAIRO_PATH_OP_CLOSE_PATH:
+		if (state != CURVES)
+		    return FALSE;
+		state = CLOSED;
+		break;
+	    }
+	}
+    } cairo_path_foreach_buf_end (buf, path);
+
+    if (start == NULL)
+	return FALSE;
+
+    /* the implicit (or explicit) closing line must be negligible */
+    return hypot (_cairo_fixed_to_double (current->x - start->x),
+		  _cairo_fixed_to_double (current->y - start->y)) <= fit->tolerance;
+}
+
+static cairo_bool_t
+_ellipse_fit_add_center (cairo_ellipse_fit_t *fit,
+			 const cairo_point_t *p0,
+			 const cairo_point_t *p)
+{
+    fit->sum_x += _cairo_fixed_to_double (p[2].x);
+    fit->sum_y += _cairo_fixed_to_double (p[2].y);
+    fit->num_curves++;
+    return TRUE;
+}
+
+static cairo_bool_t
+_ellipse_fit_add_radii (cairo_ellipse_fit_t *fit,
+			const cairo_point_t *p0,
+			const cairo_point_t *p)
+{
+    double dx, dy;
+
+    dx = _cairo_fixed_to_double (p[2].x) - fit->ellipse.center.x;
+    dy = _cairo_fixed_to_double (p[2].y) - fit->ellipse.center.y;
+    dx *= dx;
+    dy *= dy;
+
+    fit->sum_x += dx;
+    fit->sum_y += dy;
+    fit->sum_xx += dx * dx;
+    fit->sum_xy += dx * dy;
+    fit->sum_yy += dy * dy;
+    return TRUE;
+}
+
+static cairo_bool_t
+_ellipse_fit_control_point (const cairo_ellipse_fit_t *fit,
+			    const cairo_point_t *p,
+			    double u, double v)
+{
+    const cairo_ellipse_double_t *e = &fit->ellipse;
+
+    return hypot (_cairo_fixed_to_double (p->x) - (e->center.x + e->rx * u),
+		  _cairo_fixed_to_double (p->y) - (e->center.y + e->ry * v)) <= fit->tolerance;
+}
+
+/* Check that the curve is the Bézier approximation that
+ * _cairo_arc_segment() would produce for the corresponding elliptical
+ * arc, and that the approximation itself lies within tolerance. */
+static cairo_bool_t
+_ellipse_fit_check_curve (cairo_ellipse_fit_t *fit,
+			  const cairo_point_t *p0,
+			  const cairo_point_t *p)
+{
+    const cairo_ellipse_double_t *e = &fit->ellipse;
+    double u0, v0, u3, v3;
+    double angle_A, angle_B, angle, h, s;
+
+    u0 = (_cairo_fixed_to_double (p0->x) - e->center.x) / e->rx;
+    v0 = (_cairo_fixed_to_double (p0->y) - e->center.y) / e->ry;
+    u3 = (_cairo_fixed_to_double (p[2].x) - e->center.x) / e->rx;
+    v3 = (_cairo_fixed_to_double (p[2].y) - e->center.y) / e->ry;
+
+    if (fabs (hypot (u3, v3) - 1.) * MAX (e->rx, e->ry) > fit->tolerance)
+	return FALSE;
+
+    angle_A = atan2 (v0, u0);
+    angle_B = atan2 (v3, u3);
+    angle = angle_B - angle_A;
+    if (angle > M_PI)
+	angle -= 2 * M_PI;
+    else if (angle <= -M_PI)
+	angle += 2 * M_PI;
+
+    /* all segments must turn the same way */
+    if (angle == 0. || (fit->sweep != 0. && (angle < 0) != (fit->sweep < 0)))
+	return FALSE;
+    fit->sweep += angle;
+
+    /* spline deviation, see _arc_error_normalized() */
+    s = sin (angle / 4);
+    if (2.0/27.0 * pow (s, 6) / (1 - s * s) * MAX (e->rx, e->ry) > fit->tolerance)
+	return FALSE;
+
+    h = 4.0/3.0 * tan (angle / 4);
+    return
+	_ellipse_fit_control_point (fit, &p[0],
+				    cos (angle_A) - h * sin (angle_A),
+				    sin (angle_A) + h * cos (angle_A)) &&
+	_ellipse_fit_control_point (fit, &p[1],
+				    cos (angle_B) + h * sin (angle_B),
+				    sin (angle_B) - h * cos (angle_B));
+}
+
+/*
+ * Check whether the given path is a single closed subpath of curves
+ * approximating an axis-aligned ellipse to within @tolerance, as
+ * produced for instance by
+ * <informalexample><programlisting>
+ *   cairo_arc (cr, xc, yc, radius, 0, 2 * M_PI);
+ * </programlisting></informalexample>
+ * under a transformation consisting only of scales, translations and
+ * (for circles) rotations. Such a path may be rasterized as the exact
+ * ellipse rather than via its flattened polygon.
+ */
+cairo_bool_t
+_cairo_path_fixed_is_ellipse (const cairo_path_fixed_t *path,
+			      double			tolerance,
+			      cairo_ellipse_double_t   *ellipse)
+{
+    cairo_ellipse_fit_t fit;
+    double det, a, b;
+
+    if (! path->has_curve_to)
+	return FALSE;
+
+    memset (&fit, 0, sizeof (fit));
+    fit.tolerance = tolerance;
+
+    /* The on-curve points of a full arc are evenly spaced around the
+     * circle, so in the absence of any other transformation the center
+     * is simply their mean. */
+    if (! _ellipse_fit_foreach_curve (path, _ellipse_fit_add_center, &fit))
+	return FALSE;
+    if (fit.num_curves < 2)
+	return FALSE;
+
+    fit.ellipse.center.x = fit.sum_x / fit.num_curves;
+    fit.ellipse.center.y = fit.sum_y / fit.num_curves;
+
+    /* Least-squares fit of x²/a + y²/b = 1 for the radii */
+    fit.sum_x = fit.sum_y = 0;
+    _ellipse_fit_foreach_curve (path, _ellipse_fit_add_radii, &fit);
+
+    det = fit.sum_xx * fit.sum_yy - fit.sum_xy * fit.sum_xy;
+    if (det <= 0.)
+	return FALSE;
+
+    a = (fit.sum_x * fit.sum_yy - fit.sum_y * fit.sum_xy) / det;
+    b = (fit.sum_y * fit.sum_xx - fit.sum_x * fit.sum_xy) / det;
+    if (a <= 0. || b <= 0.)
+	return FALSE;
+
+    fit.ellipse.rx = 1. / sqrt (a);
+    fit.ellipse.ry = 1. / sqrt (b);
+
+    if (! _ellipse_fit_foreach_curve (path, _ellipse_fit_check_curve, &fit))
+	return FALSE;
+
+    /* exactly one revolution, as a doubly-wound ellipse is empty under
+     * the even-odd rule */
+    if (fabs (fabs (fit.sweep) - 2 * M_PI) > M_PI)
+	return FALSE;
+
+    *ellipse = fit.ellipse;
+    return TRUE;
+}
+
 void
 _cairo_path_fixed_iter_init (cairo_path_fixed_iter_t *iter,
 			     const cairo_path_fixed_t *path)
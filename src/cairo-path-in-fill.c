@@ -34,6 +34,9 @@
  */
 
 #include "cairoint.h"
+#include "cairo-array-private.h"
+#include "cairo-error-private.h"
+#include "cairo-list-inline.h"
 #include "cairo-path-fixed-private.h"
 
 typedef struct cairo_in_fill {
@@ -221,7 +224,7 @@ _cairo_in_fill_curve_to (void *closure,
 			      in_fill,
 			      &in_fill->current_point, b, c, d))
     {
-	return CAIRO_STATUS_SUCCESS;
+	return _cairo_in_fill_line_to (in_fill, d);
     }
 
     return _cairo_spline_decompose (&spline, in_fill->tolerance);
@@ -243,6 +246,24 @@ _cairo_in_fill_close_path (void *closure)
     return CAIRO_STATUS_SUCCESS;
 }
 
+static cairo_bool_t
+_cairo_in_fill_is_inside (const cairo_in_fill_t *in_fill,
+			  cairo_fill_rule_t fill_rule)
+{
+    if (in_fill->on_edge)
+	return TRUE;
+
+    switch (fill_rule) {
+    case CAIRO_FILL_RULE_EVEN_ODD:
+	return in_fill->winding & 1;
+    case CAIRO_FILL_RULE_WINDING:
+	return in_fill->winding != 0;
+    default:
+	ASSERT_NOT_REACHED;
+	return FALSE;
+    }
+}
+
 cairo_bool_t
 _cairo_path_fixed_in_fill (const cairo_path_fixed_t	*path,
 			   cairo_fill_rule_t	 fill_rule,
@@ -269,21 +290,369 @@ _cairo_path_fixed_in_fill (const cairo_path_fixed_t	*path,
 
     _cairo_in_fill_close_path (&in_fill);
 
-    if (in_fill.on_edge) {
-	is_inside = TRUE;
-    } else switch (fill_rule) {
-    case CAIRO_FILL_RULE_EVEN_ODD:
-	is_inside = in_fill.winding & 1;
-	break;
-    case CAIRO_FILL_RULE_WINDING:
-	is_inside = in_fill.winding != 0;
-	break;
-    default:
-	ASSERT_NOT_REACHED;
-	is_inside = FALSE;
-	break;
+    is_inside = _cairo_in_fill_is_inside (&in_fill, fill_rule);
+
+    _cairo_in_fill_fini (&in_fill);
+
+    return is_inside;
+}
+
+/* Hit-testing index.
+ *
+ * Interactive applications tend to test the same path over and over again
+ * as the pointer moves, each time walking and flattening every segment.
+ * Instead, on the second query against an unchanged path the flattened
+ * edges are kept and bucketed into horizontal bands, so that a query need
+ * only consider the edges crossing its own band. An edge that does not
+ * span the query's y can neither contribute to the winding nor touch the
+ * point, so the result is identical to the full walk.
+ *
+ * The index hangs off the path and is discarded by any modification of it.
+ */
+
+#define IN_FILL_INDEX_MAX_BANDS 1024
+
+struct _cairo_path_in_fill_index {
+    double tolerance;
+    cairo_bool_t is_built;
+
+    cairo_fixed_t top, bottom;
+    double band_scale;
+    int num_bands;
+    int *bands; /* num_bands + 1 offsets into entries */
+    int *entries;
+
+    cairo_array_t storage;
+    int num_edges;
+    const cairo_line_t *edges;
+};
+
+typedef struct cairo_in_fill_collector {
+    double tolerance;
+    cairo_array_t *edges;
+
+    cairo_bool_t has_current_point;
+    cairo_point_t current_point;
+    cairo_point_t first_point;
+} cairo_in_fill_collector_t;
+
+static cairo_status_t
+_cairo_in_fill_collector_add_edge (cairo_in_fill_collector_t *collector,
+				   const cairo_point_t *p1,
+				   const cairo_point_t *p2)
+{
+    cairo_line_t line;
+
+    line.p1 = *p1;
+    line.p2 = *p2;
+    return _cairo_array_append (collector->edges, &line);
+}
+
+static cairo_status_t
+_cairo_in_fill_collector_line_to (void *closure,
+				  const cairo_point_t *point)
+{
+    cairo_in_fill_collector_t *collector = closure;
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+
+    if (collector->has_current_point) {
+	status = _cairo_in_fill_collector_add_edge (collector,
+						    &collector->current_point,
+						    point);
+    }
+
+    collector->current_point = *point;
+    collector->has_current_point = TRUE;
+
+    return status;
+}
+
+static cairo_status_t
+_cairo_in_fill_collector_close_path (void *closure)
+{
+    cairo_in_fill_collector_t *collector = closure;
+
+    if (! collector->has_current_point)
+	return CAIRO_STATUS_SUCCESS;
+
+    collector->has_current_point = FALSE;
+    return _cairo_in_fill_collector_add_edge (collector,
+					      &collector->current_point,
+					      &collector->first_point);
+}
+
+static cairo_status_t
+_cairo_in_fill_collector_move_to (void *closure,
+				  const cairo_point_t *point)
+{
+    cairo_in_fill_collector_t *collector = closure;
+    cairo_status_t status;
+
+    /* implicit close path */
+    status = _cairo_in_fill_collector_close_path (collector);
+    if (unlikely (status))
+	return status;
+
+    collector->first_point = *point;
+    collector->current_point = *point;
+    collector->has_current_point = TRUE;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_in_fill_collector_curve_to (void *closure,
+				   const cairo_point_t *b,
+				   const cairo_point_t *c,
+				   const cairo_point_t *d)
+{
+    cairo_in_fill_collector_t *collector = closure;
+    cairo_spline_t spline;
+
+    if (! _cairo_spline_init (&spline,
+			      (cairo_spline_add_point_func_t)_cairo_in_fill_collector_line_to,
+			      collector,
+			      &collector->current_point, b, c, d))
+    {
+	return _cairo_in_fill_collector_line_to (collector, d);
+    }
+
+    return _cairo_spline_decompose (&spline, collector->tolerance);
+}
+
+static inline int
+_cairo_path_in_fill_index_band (const cairo_path_in_fill_index_t *index,
+				cairo_fixed_t y)
+{
+    int band;
+
+    band = ((double) y - index->top) * index->band_scale;
+    if (band >= index->num_bands)
+	band = index->num_bands - 1;
+
+    return band;
+}
+
+/* Sizes the bands, leaving in bands[] the end of each band's run of
+ * entries, and returns the total number of entries required.
+ */
+static int
+_cairo_path_in_fill_index_count (cairo_path_in_fill_index_t *index)
+{
+    int i, count, total;
+
+    memset (index->bands, 0, (index->num_bands + 1) * sizeof (int));
+    for (i = 0; i < index->num_edges; i++) {
+	const cairo_line_t *e = &index->edges[i];
+
+	index->bands[_cairo_path_in_fill_index_band (index, MIN (e->p1.y, e->p2.y))]++;
+	index->bands[_cairo_path_in_fill_index_band (index, MAX (e->p1.y, e->p2.y)) + 1]--;
+    }
+
+    count = total = 0;
+    for (i = 0; i < index->num_bands; i++) {
+	count += index->bands[i];
+	total += count;
+	index->bands[i] = total;
+    }
+    index->bands[i] = total;
+
+    return total;
+}
+
+static void
+_cairo_path_in_fill_index_reset (cairo_path_in_fill_index_t *index)
+{
+    free (index->bands);
+    free (index->entries);
+    _cairo_array_truncate (&index->storage, 0);
+
+    index->is_built = FALSE;
+    index->num_bands = 0;
+    index->bands = NULL;
+    index->entries = NULL;
+    index->num_edges = 0;
+    index->edges = NULL;
+}
+
+static cairo_status_t
+_cairo_path_in_fill_index_build (cairo_path_in_fill_index_t *index,
+				 const cairo_path_fixed_t *path)
+{
+    cairo_in_fill_collector_t collector;
+    cairo_status_t status;
+    int i, total;
+
+    collector.tolerance = index->tolerance;
+    collector.edges = &index->storage;
+    collector.has_current_point = FALSE;
+
+    status = _cairo_path_fixed_interpret (path,
+					  _cairo_in_fill_collector_move_to,
+					  _cairo_in_fill_collector_line_to,
+					  _cairo_in_fill_collector_curve_to,
+					  _cairo_in_fill_collector_close_path,
+					  &collector);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_in_fill_collector_close_path (&collector);
+    if (unlikely (status)) {
+	_cairo_path_in_fill_index_reset (index);
+	return status;
+    }
+
+    index->num_edges = _cairo_array_num_elements (&index->storage);
+    index->edges = _cairo_array_index (&index->storage, 0);
+    if (index->num_edges == 0) {
+	index->is_built = TRUE;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    index->top = index->bottom = index->edges[0].p1.y;
+    for (i = 0; i < index->num_edges; i++) {
+	const cairo_line_t *e = &index->edges[i];
+
+	if (e->p1.y < index->top)
+	    index->top = e->p1.y;
+	if (e->p1.y > index->bottom)
+	    index->bottom = e->p1.y;
+	if (e->p2.y < index->top)
+	    index->top = e->p2.y;
+	if (e->p2.y > index->bottom)
+	    index->bottom = e->p2.y;
+    }
+
+    index->num_bands = index->num_edges / 4 + 1;
+    if (index->num_bands > IN_FILL_INDEX_MAX_BANDS)
+	index->num_bands = IN_FILL_INDEX_MAX_BANDS;
+
+    index->bands = _cairo_malloc_ab (index->num_bands + 1, sizeof (int));
+    if (unlikely (index->bands == NULL))
+	goto BAIL;
+
+    /* Tall edges are repeated in every band they cross, so trade query
+     * speed for space if the bands become too fine.
+     */
+    do {
+	index->band_scale =
+	    index->num_bands / ((double) index->bottom - index->top + 1);
+	total = _cairo_path_in_fill_index_count (index);
+	if (total <= 8 * index->num_edges)
+	    break;
+
+	index->num_bands /= 2;
+    } while (index->num_bands > 1);
+
+    index->entries = _cairo_malloc_ab (total, sizeof (int));
+    if (unlikely (index->entries == NULL))
+	goto BAIL;
+
+    for (i = 0; i < index->num_edges; i++) {
+	const cairo_line_t *e = &index->edges[i];
+	int b0, b1;
+
+	b0 = _cairo_path_in_fill_index_band (index, MIN (e->p1.y, e->p2.y));
+	b1 = _cairo_path_in_fill_index_band (index, MAX (e->p1.y, e->p2.y));
+	do
+	    index->entries[--index->bands[b0]] = i;
+	while (++b0 <= b1);
+    }
+
+    index->is_built = TRUE;
+    return CAIRO_STATUS_SUCCESS;
+
+BAIL:
+    _cairo_path_in_fill_index_reset (index);
+    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+}
+
+void
+_cairo_path_in_fill_index_destroy (cairo_path_in_fill_index_t *index)
+{
+    _cairo_path_in_fill_index_reset (index);
+    _cairo_array_fini (&index->storage);
+    free (index);
+}
+
+static cairo_path_in_fill_index_t *
+_cairo_path_fixed_get_in_fill_index (cairo_path_fixed_t *path,
+				     double tolerance)
+{
+    cairo_path_in_fill_index_t *index = path->in_fill_index;
+
+    /* Small paths are quicker to walk than to index */
+    if (! path->has_curve_to &&
+	cairo_path_buf_next (cairo_path_head (path)) == cairo_path_head (path))
+    {
+	return NULL;
+    }
+
+    /* Only build the index once the path has been queried before */
+    if (index == NULL) {
+	index = calloc (1, sizeof (cairo_path_in_fill_index_t));
+	if (likely (index != NULL)) {
+	    _cairo_array_init (&index->storage, sizeof (cairo_line_t));
+	    index->tolerance = tolerance;
+	    path->in_fill_index = index;
+	}
+	return NULL;
+    }
+
+    if (index->tolerance != tolerance) {
+	_cairo_path_in_fill_index_reset (index);
+	index->tolerance = tolerance;
+	return NULL;
     }
 
+    if (! index->is_built &&
+	unlikely (_cairo_path_in_fill_index_build (index, path)))
+    {
+	return NULL;
+    }
+
+    return index;
+}
+
+/**
+ * _cairo_path_fixed_in_fill_indexed:
+ *
+ * Equivalent to _cairo_path_fixed_in_fill(), but for a path that is
+ * repeatedly queried, builds and reuses an index of its edges so that
+ * each test only visits the edges near the point.
+ **/
+cairo_bool_t
+_cairo_path_fixed_in_fill_indexed (cairo_path_fixed_t	*path,
+				   cairo_fill_rule_t	 fill_rule,
+				   double		 tolerance,
+				   double		 x,
+				   double		 y)
+{
+    cairo_path_in_fill_index_t *index;
+    cairo_in_fill_t in_fill;
+    cairo_bool_t is_inside;
+    int band, i;
+
+    if (_cairo_path_fixed_fill_is_empty (path))
+	return FALSE;
+
+    index = _cairo_path_fixed_get_in_fill_index (path, tolerance);
+    if (index == NULL)
+	return _cairo_path_fixed_in_fill (path, fill_rule, tolerance, x, y);
+
+    _cairo_in_fill_init (&in_fill, tolerance, x, y);
+
+    if (index->num_edges &&
+	in_fill.y >= index->top && in_fill.y <= index->bottom)
+    {
+	band = _cairo_path_in_fill_index_band (index, in_fill.y);
+	for (i = index->bands[band]; i < index->bands[band + 1]; i++) {
+	    const cairo_line_t *e = &index->edges[index->entries[i]];
+
+	    _cairo_in_fill_add_edge (&in_fill, &e->p1, &e->p2);
+	}
+    }
+
+    is_inside = _cairo_in_fill_is_inside (&in_fill, fill_rule);
+
     _cairo_in_fill_fini (&in_fill);
 
     return is_inside;
@@ -47,6 +47,9 @@ cairo_private cairo_path_t *
 _cairo_path_create_flat (cairo_path_fixed_t *path,
 			 cairo_t	    *cr);
 
+cairo_private cairo_path_t *
+_cairo_path_create_untransformed (cairo_path_fixed_t *path);
+
 cairo_private cairo_path_t *
 _cairo_path_create_in_error (cairo_status_t status);
 
@@ -54,4 +57,8 @@ cairo_private cairo_status_t
 _cairo_path_append_to_context (const cairo_path_t	*path,
 			       cairo_t			*cr);
 
+cairo_private cairo_status_t
+_cairo_path_fixed_init_from_path (cairo_path_fixed_t *fixed,
+				  const cairo_path_t *path);
+
 #endif /* CAIRO_PATH_DATA_PRIVATE_H */
@@ -0,0 +1,261 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-contour-inline.h"
+#include "cairo-contour-private.h"
+#include "cairo-error-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-path-private.h"
+
+/* Path simplification.
+ *
+ * The path is copied segment by segment, gathering each run of
+ * consecutive lines into a contour. The run is simplified by
+ * _cairo_contour_simplify() before its lines are emitted, which keeps
+ * the points at either end, so runs are broken (and the shape anchored)
+ * at every move-to, close-path and preserved curve.
+ */
+
+typedef struct _cairo_path_simplifier {
+    cairo_path_fixed_t *path;
+    double tolerance;
+
+    cairo_point_t start;
+    cairo_contour_t run;
+} cairo_path_simplifier_t;
+
+static cairo_status_t
+_cairo_path_simplifier_restart (cairo_path_simplifier_t *simplifier,
+				const cairo_point_t *point)
+{
+    _cairo_contour_reset (&simplifier->run);
+    return _cairo_contour_add_point (&simplifier->run, point);
+}
+
+/* Replace the pending run of lines by its simplification */
+static cairo_status_t
+_cairo_path_simplifier_flush (cairo_path_simplifier_t *simplifier)
+{
+    cairo_contour_t *run = &simplifier->run;
+    const cairo_contour_chain_t *chain;
+    cairo_point_t last;
+    cairo_status_t status;
+    int i;
+
+    if (run->chain.num_points < 2)
+	return CAIRO_STATUS_SUCCESS;
+
+    _cairo_contour_simplify (run, simplifier->tolerance);
+
+    /* the first point is already in place as the current point */
+    i = 1;
+    for (chain = &run->chain; chain; chain = chain->next) {
+	for (; i < chain->num_points; i++) {
+	    status = _cairo_path_fixed_line_to (simplifier->path,
+						chain->points[i].x,
+						chain->points[i].y);
+	    if (unlikely (status))
+		return status;
+	}
+	i = 0;
+    }
+
+    last = *_cairo_contour_last_point (run);
+    return _cairo_path_simplifier_restart (simplifier, &last);
+}
+
+static cairo_status_t
+_cairo_path_simplifier_move_to (void *closure,
+				const cairo_point_t *point)
+{
+    cairo_path_simplifier_t *simplifier = closure;
+    cairo_status_t status;
+
+    status = _cairo_path_simplifier_flush (simplifier);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_path_fixed_move_to (simplifier->path, point->x, point->y);
+    if (unlikely (status))
+	return status;
+
+    simplifier->start = *point;
+    return _cairo_path_simplifier_restart (simplifier, point);
+}
+
+static cairo_status_t
+_cairo_path_simplifier_line_to (void *closure,
+				const cairo_point_t *point)
+{
+    cairo_path_simplifier_t *simplifier = closure;
+    const cairo_point_t *last;
+
+    last = _cairo_contour_last_point (&simplifier->run);
+    if (last->x == point->x && last->y == point->y)
+	return CAIRO_STATUS_SUCCESS;
+
+    return _cairo_contour_add_point (&simplifier->run, point);
+}
+
+static cairo_status_t
+_cairo_path_simplifier_curve_to (void *closure,
+				 const cairo_point_t *p1,
+				 const cairo_point_t *p2,
+				 const cairo_point_t *p3)
+{
+    cairo_path_simplifier_t *simplifier = closure;
+    cairo_status_t status;
+
+    status = _cairo_path_simplifier_flush (simplifier);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_path_fixed_curve_to (simplifier->path,
+					 p1->x, p1->y,
+					 p2->x, p2->y,
+					 p3->x, p3->y);
+    if (unlikely (status))
+	return status;
+
+    return _cairo_path_simplifier_restart (simplifier, p3);
+}
+
+static cairo_status_t
+_cairo_path_simplifier_close_path (void *closure)
+{
+    cairo_path_simplifier_t *simplifier = closure;
+    cairo_status_t status;
+
+    status = _cairo_path_simplifier_flush (simplifier);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_path_fixed_close_path (simplifier->path);
+    if (unlikely (status))
+	return status;
+
+    return _cairo_path_simplifier_restart (simplifier, &simplifier->start);
+}
+
+/**
+ * cairo_path_simplify:
+ * @path: the path to simplify
+ * @tolerance: the approximate distance from the simplified outline
+ * within which points may be removed
+ * @preserve_curves: whether to keep the curves of @path as they are,
+ * rather than flatten them
+ *
+ * Computes a simplified copy of @path with fewer points, removing those
+ * that lie within @tolerance of the straight line between their
+ * remaining neighbours (in the manner of the Douglas-Peucker algorithm),
+ * or of the point before. As both may apply, the result can stray a
+ * little further than @tolerance from a dense path. This is
+ * meant for dense polylines, such as recorded tracks or traced outlines,
+ * whose detail is much finer than will be visible once drawn: the
+ * simplified path is cheaper to fill or stroke and smaller to store.
+ *
+ * The start and end point of each sub-path is kept, as are the points on
+ * either side of any curve. If @preserve_curves is %FALSE, curves are
+ * first flattened into lines using @tolerance, as for
+ * cairo_copy_path_flat(), and simplified along with the rest of the
+ * path; otherwise they are copied unchanged.
+ *
+ * The coordinates of @path are taken as they are, independent of any
+ * transformation, and are computed with the precision cairo uses for
+ * device space: 1/256 of a unit, over a range of about ±8 million units.
+ *
+ * Return value: the simplified path. The caller owns the returned object
+ * and should call cairo_path_destroy() when finished with it. If @path is
+ * in an error state, the returned path carries the same status;
+ * malformed path data results in %CAIRO_STATUS_INVALID_PATH_DATA. If
+ * there is insufficient memory, a pointer to a special static nil
+ * #cairo_path_t with status %CAIRO_STATUS_NO_MEMORY will be returned
+ * instead.
+ *
+ * Since: 1.16
+ **/
+cairo_path_t *
+cairo_path_simplify (const cairo_path_t *path,
+		     double tolerance,
+		     cairo_bool_t preserve_curves)
+{
+    cairo_path_simplifier_t simplifier;
+    cairo_path_fixed_t fixed, simplified;
+    cairo_path_t *result;
+    cairo_status_t status;
+
+    if (path == NULL)
+	return _cairo_path_create_in_error (_cairo_error (CAIRO_STATUS_NULL_POINTER));
+
+    if (! (tolerance > 0.)) /* also catch NaN */
+	tolerance = 0.;
+
+    status = _cairo_path_fixed_init_from_path (&fixed, path);
+    if (unlikely (status)) {
+	_cairo_path_fixed_fini (&fixed);
+	return _cairo_path_create_in_error (status);
+    }
+
+    _cairo_path_fixed_init (&simplified);
+    simplifier.path = &simplified;
+    simplifier.tolerance = tolerance;
+    simplifier.start.x = simplifier.start.y = 0;
+    _cairo_contour_init (&simplifier.run, 0);
+
+    if (preserve_curves) {
+	status = _cairo_path_fixed_interpret (&fixed,
+					      _cairo_path_simplifier_move_to,
+					      _cairo_path_simplifier_line_to,
+					      _cairo_path_simplifier_curve_to,
+					      _cairo_path_simplifier_close_path,
+					      &simplifier);
+    } else {
+	status = _cairo_path_fixed_interpret_flat (&fixed,
+						   _cairo_path_simplifier_move_to,
+						   _cairo_path_simplifier_line_to,
+						   _cairo_path_simplifier_close_path,
+						   &simplifier,
+						   MAX (tolerance, CAIRO_FIXED_ERROR_DOUBLE));
+    }
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_path_simplifier_flush (&simplifier);
+
+    _cairo_contour_fini (&simplifier.run);
+    _cairo_path_fixed_fini (&fixed);
+
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	result = _cairo_path_create_untransformed (&simplified);
+    else
+	result = _cairo_path_create_in_error (status);
+    _cairo_path_fixed_fini (&simplified);
+
+    return result;
+}
@@ -67,6 +67,13 @@ typedef struct _cairo_rectilinear_stroker {
 
     cairo_stroker_dash_t dash;
 
+    /* Only miter joins reproduce the square corner of a right angle,
+     * other joins are fine as long as the path never turns a corner,
+     * and all but round joins when the path doubles back on itself. */
+    cairo_bool_t square_joins;
+    int first_orientation, last_orientation; /* HORIZONTAL, 0 or -1 */
+    cairo_bool_t first_forwards, last_forwards;
+
     cairo_bool_t has_bounds;
     cairo_box_t bounds;
 
@@ -99,25 +106,18 @@ _cairo_rectilinear_stroker_init (cairo_rectilinear_stroker_t	*stroker,
 				 cairo_boxes_t			*boxes)
 {
     /* This special-case rectilinear stroker only supports
-     * miter-joined lines (not curves) and a translation-only matrix
-     * (though it could probably be extended to support a matrix with
-     * uniform, integer scaling).
+     * butt- or square-capped lines (not curves) and a scale-only matrix.
      *
      * It also only supports horizontal and vertical line_to
      * elements. But we don't catch that here, but instead return
      * UNSUPPORTED from _cairo_rectilinear_stroker_line_to if any
      * non-rectilinear line_to is encountered.
+     *
+     * Only miter joins fill the corner of a right angle with a square;
+     * any other join is accepted here, but we return UNSUPPORTED
+     * should the stroke actually turn a corner, or double back on
+     * itself with a round join.
      */
-    if (stroke_style->line_join	!= CAIRO_LINE_JOIN_MITER)
-	return FALSE;
-
-    /* If the miter limit turns right angles into bevels, then we
-     * can't use this optimization. Remember, the ratio is
-     * 1/sin(ɸ/2). So the cutoff is 1/sin(π/4.0) or ⎷2,
-     * which we round for safety. */
-    if (stroke_style->miter_limit < M_SQRT2)
-	return FALSE;
-
     if (! (stroke_style->line_cap == CAIRO_LINE_CAP_BUTT ||
 	   stroke_style->line_cap == CAIRO_LINE_CAP_SQUARE))
     {
@@ -131,6 +131,15 @@ _cairo_rectilinear_stroker_init (cairo_rectilinear_stroker_t	*stroker,
     stroker->ctm = ctm;
     stroker->antialias = antialias;
 
+    /* If the miter limit turns right angles into bevels, then the
+     * corners are no longer square. Remember, the ratio is
+     * 1/sin(ɸ/2). So the cutoff is 1/sin(π/4.0) or ⎷2,
+     * which we round for safety. */
+    stroker->square_joins =
+	stroke_style->line_join == CAIRO_LINE_JOIN_MITER &&
+	stroke_style->miter_limit >= M_SQRT2;
+    stroker->first_orientation = stroker->last_orientation = -1;
+
     stroker->half_line_x =
 	_cairo_fixed_from_double (fabs(ctm->xx) * stroke_style->line_width / 2.0);
     stroker->half_line_y =
@@ -422,6 +431,46 @@ _cairo_rectilinear_stroker_emit_segments_dashed (cairo_rectilinear_stroker_t *st
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* Is the stroke drawn through the current point, so that turning a
+ * corner there would require a join?
+ */
+static cairo_bool_t
+_cairo_rectilinear_stroker_is_on (const cairo_rectilinear_stroker_t *stroker)
+{
+    if (! stroker->dash.dashed || stroker->dash.dash_on)
+	return TRUE;
+
+    /* or the last dash ran right up to the corner */
+    return stroker->num_segments &&
+	stroker->segments[stroker->num_segments - 1].flags & JOIN;
+}
+
+/* Can the join from the last segment onto one of the given orientation
+ * and direction be represented by boxes? Where the stroke is drawn, a
+ * right angle cannot unless the join is a square miter, and neither can
+ * a reversal with a round join: the boxes end flush with the turning
+ * point, as does a bevel (or a miter, which falls back to a bevel when
+ * doubling back), but a round join adds a half disc beyond it.
+ */
+static cairo_bool_t
+_cairo_rectilinear_stroker_can_join (const cairo_rectilinear_stroker_t *stroker,
+				     int orientation,
+				     cairo_bool_t forwards)
+{
+    if (stroker->square_joins || stroker->last_orientation < 0)
+	return TRUE;
+
+    if (stroker->last_orientation == orientation) {
+	if (stroker->last_forwards == forwards)
+	    return TRUE;
+
+	if (stroker->stroke_style->line_join != CAIRO_LINE_JOIN_ROUND)
+	    return TRUE;
+    }
+
+    return ! _cairo_rectilinear_stroker_is_on (stroker);
+}
+
 static cairo_status_t
 _cairo_rectilinear_stroker_move_to (void		*closure,
 				    const cairo_point_t	*point)
@@ -439,6 +488,7 @@ _cairo_rectilinear_stroker_move_to (void		*closure,
     /* reset the dash pattern for new sub paths */
     _cairo_stroker_dash_start (&stroker->dash);
 
+    stroker->first_orientation = stroker->last_orientation = -1;
     stroker->current_point = *point;
     stroker->first_point = *point;
 
@@ -451,6 +501,7 @@ _cairo_rectilinear_stroker_line_to (void		*closure,
 {
     cairo_rectilinear_stroker_t *stroker = closure;
     cairo_point_t *a = &stroker->current_point;
+    cairo_bool_t forwards;
     cairo_status_t status;
 
     /* We only support horizontal or vertical elements. */
@@ -460,6 +511,17 @@ _cairo_rectilinear_stroker_line_to (void		*closure,
     if (a->x == b->x && a->y == b->y)
 	return CAIRO_STATUS_SUCCESS;
 
+    forwards = a->y == b->y ? a->x < b->x : a->y < b->y;
+    if (! _cairo_rectilinear_stroker_can_join (stroker, a->y == b->y, forwards))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    if (stroker->first_orientation < 0) {
+	stroker->first_orientation = a->y == b->y;
+	stroker->first_forwards = forwards;
+    }
+    stroker->last_orientation = a->y == b->y;
+    stroker->last_forwards = forwards;
+
     status = _cairo_rectilinear_stroker_add_segment (stroker, a, b,
 						     (a->y == b->y) | JOIN);
 
@@ -482,6 +544,7 @@ _cairo_rectilinear_stroker_line_to_dashed (void		*closure,
     cairo_status_t status;
     cairo_line_t segment;
     cairo_bool_t dash_on = FALSE;
+    cairo_bool_t forwards;
     unsigned is_horizontal;
 
     /* We don't draw anything for degenerate paths. */
@@ -491,6 +554,17 @@ _cairo_rectilinear_stroker_line_to_dashed (void		*closure,
     /* We only support horizontal or vertical elements. */
     assert (a->x == b->x || a->y == b->y);
 
+    forwards = a->y == b->y ? a->x < b->x : a->y < b->y;
+    if (! _cairo_rectilinear_stroker_can_join (stroker, a->y == b->y, forwards))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    if (stroker->first_orientation < 0) {
+	stroker->first_orientation = a->y == b->y;
+	stroker->first_forwards = forwards;
+    }
+    stroker->last_orientation = a->y == b->y;
+    stroker->last_forwards = forwards;
+
     fully_in_bounds = TRUE;
     if (stroker->has_bounds &&
 	(! _cairo_box_contains_point (&stroker->bounds, a) ||
@@ -594,6 +668,15 @@ _cairo_rectilinear_stroker_close_path (void *closure)
     if (unlikely (status))
 	return status;
 
+    /* and the join back onto the start of the sub-path */
+    if ((! stroker->dash.dashed || stroker->dash.dash_starts_on) &&
+	! _cairo_rectilinear_stroker_can_join (stroker,
+					       stroker->first_orientation,
+					       stroker->first_forwards))
+    {
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
     stroker->open_sub_path = FALSE;
 
     if (stroker->dash.dashed)
@@ -627,6 +710,7 @@ _cairo_path_fixed_stroke_rectilinear_to_boxes (const cairo_path_fixed_t	*path,
     }
 
     if (! rectilinear_stroker.dash.dashed &&
+	rectilinear_stroker.square_joins &&
 	_cairo_path_fixed_is_stroke_box (path, &box) &&
 	/* if the segments overlap we need to feed them into the tessellator */
 	box.p2.x - box.p1.x > 2* rectilinear_stroker.half_line_x &&
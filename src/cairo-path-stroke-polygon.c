@@ -1337,12 +1337,21 @@ _cairo_path_fixed_stroke_to_polygon (const cairo_path_fixed_t	*path,
     stroker.contour_tolerance = tolerance;
     stroker.polygon = polygon;
 
-    status = _cairo_path_fixed_interpret (path,
-					  move_to,
-					  line_to,
-					  curve_to,
-					  close_path,
-					  &stroker);
+    if (stroker.has_bounds) {
+	status = _cairo_path_fixed_interpret_culled (path, &stroker.bounds,
+						     move_to,
+						     line_to,
+						     curve_to,
+						     close_path,
+						     &stroker);
+    } else {
+	status = _cairo_path_fixed_interpret (path,
+					      move_to,
+					      line_to,
+					      curve_to,
+					      close_path,
+					      &stroker);
+    }
     /* Cap the start and end of the final sub path as needed */
     if (likely (status == CAIRO_STATUS_SUCCESS))
 	add_caps (&stroker);
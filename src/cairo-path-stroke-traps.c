@@ -79,6 +79,7 @@ struct stroker {
     cairo_box_t tight_bounds;
     cairo_box_t line_bounds;
     cairo_box_t join_bounds;
+    cairo_box_t cull_bounds;
 };
 
 static cairo_status_t
@@ -143,6 +144,15 @@ stroker_init (struct stroker		*stroker,
 	_cairo_stroke_style_max_distance_from_path (stroker->style, path,
 						    stroker->ctm, &dx, &dy);
 
+	fdx = _cairo_fixed_from_double (dx);
+	fdy = _cairo_fixed_from_double (dy);
+
+	stroker->cull_bounds = stroker->tight_bounds;
+	stroker->cull_bounds.p1.x -= fdx;
+	stroker->cull_bounds.p2.x += fdx;
+	stroker->cull_bounds.p1.y -= fdy;
+	stroker->cull_bounds.p2.y += fdy;
+
 	_cairo_stroke_style_max_line_distance_from_path (stroker->style, path,
 							 stroker->ctm, &dx, &dy);
 
@@ -830,6 +840,7 @@ line_to_dashed (void *closure, const cairo_point_t *point)
     cairo_slope_t dev_slope;
     cairo_line_t segment;
     cairo_bool_t fully_in_bounds;
+    double t_in, t_out;
 
     stroker->has_initial_sub_path = stroker->dash.dash_starts_on;
 
@@ -855,9 +866,61 @@ line_to_dashed (void *closure, const cairo_point_t *point)
     if (mag <= DBL_EPSILON)
 	return CAIRO_STATUS_SUCCESS;
 
+    /* The stretch of the line, if any, that may touch the bounds */
+    t_in = 0;
+    t_out = mag;
+    if (! fully_in_bounds) {
+	segment.p1 = *p1;
+	segment.p2 = *p2;
+	if (_cairo_box_clip_line_segment (&stroker->join_bounds, &segment,
+					  &t_in, &t_out))
+	{
+	    t_in *= mag;
+	    t_out *= mag;
+	} else {
+	    t_in = t_out = 0;
+	}
+    }
+
     remain = mag;
     segment.p1 = *p1;
     while (remain) {
+	if (! fully_in_bounds &&
+	    (stroker->has_first_face || ! stroker->dash.dash_starts_on))
+	{
+	    double pos = mag - remain, skip = 0;
+
+	    /* Rather than stepping through every dash lying outside the
+	     * bounds, seek straight to the first one that may be visible
+	     * (or to the end of the line), whole periods at a time.
+	     */
+	    if (pos < t_in)
+		skip = t_in - pos;
+	    else if (pos >= t_out)
+		skip = remain;
+	    if (skip > 0)
+		skip = _cairo_stroker_dash_seek (&stroker->dash, skip);
+
+	    if (skip > 0) {
+		if (stroker->has_current_face) {
+		    /* Cap final face from previous segment */
+		    add_trailing_cap (stroker, &stroker->current_face);
+
+		    stroker->has_current_face = FALSE;
+		}
+
+		remain -= skip;
+		if (remain <= 0)
+		    break;
+
+		dx2 = slope_dx * (mag - remain);
+		dy2 = slope_dy * (mag - remain);
+		cairo_matrix_transform_distance (stroker->ctm, &dx2, &dy2);
+		segment.p1.x = _cairo_fixed_from_double (dx2) + p1->x;
+		segment.p1.y = _cairo_fixed_from_double (dy2) + p1->y;
+	    }
+	}
+
 	step_length = MIN (stroker->dash.dash_remain, remain);
 	remain -= step_length;
 	dx2 = slope_dx * (mag - remain);
@@ -1126,7 +1189,21 @@ _cairo_path_fixed_stroke_to_traps (const cairo_path_fixed_t	*path,
     if (unlikely (status))
 	return status;
 
-    if (stroker.dash.dashed)
+    if (stroker.has_bounds && stroker.dash.dashed)
+	status = _cairo_path_fixed_interpret_culled (path, &stroker.cull_bounds,
+						     move_to_dashed,
+						     line_to_dashed,
+						     curve_to_dashed,
+						     close_path_dashed,
+						     &stroker);
+    else if (stroker.has_bounds)
+	status = _cairo_path_fixed_interpret_culled (path, &stroker.cull_bounds,
+						     move_to,
+						     line_to,
+						     curve_to,
+						     close_path,
+						     &stroker);
+    else if (stroker.dash.dashed)
 	status = _cairo_path_fixed_interpret (path,
 					      move_to_dashed,
 					      line_to_dashed,
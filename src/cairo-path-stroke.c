@@ -1096,6 +1096,7 @@ _cairo_stroker_line_to_dashed (void *closure,
     cairo_slope_t dev_slope;
     cairo_line_t segment;
     cairo_bool_t fully_in_bounds;
+    double t_in, t_out;
     cairo_status_t status;
 
     stroker->has_initial_sub_path = stroker->dash.dash_starts_on;
@@ -1122,9 +1123,64 @@ _cairo_stroker_line_to_dashed (void *closure,
 	return CAIRO_STATUS_SUCCESS;
     }
 
+    /* The stretch of the line, if any, that may touch the bounds */
+    t_in = 0;
+    t_out = mag;
+    if (! fully_in_bounds) {
+	segment.p1 = *p1;
+	segment.p2 = *p2;
+	if (_cairo_box_clip_line_segment (&stroker->bounds, &segment,
+					  &t_in, &t_out))
+	{
+	    t_in *= mag;
+	    t_out *= mag;
+	} else {
+	    t_in = t_out = 0;
+	}
+    }
+
     remain = mag;
     segment.p1 = *p1;
     while (remain) {
+	if (! fully_in_bounds &&
+	    (stroker->has_first_face || ! stroker->dash.dash_starts_on))
+	{
+	    double pos = mag - remain, skip = 0;
+
+	    /* Rather than stepping through every dash lying outside the
+	     * bounds, seek straight to the first one that may be visible
+	     * (or to the end of the line), whole periods at a time.
+	     */
+	    if (pos < t_in)
+		skip = t_in - pos;
+	    else if (pos >= t_out)
+		skip = remain;
+	    if (skip > 0)
+		skip = _cairo_stroker_dash_seek (&stroker->dash, skip);
+
+	    if (skip > 0) {
+		if (stroker->has_current_face) {
+		    /* Cap final face from previous segment */
+		    status = _cairo_stroker_add_trailing_cap (stroker,
+							      &stroker->current_face);
+		    if (unlikely (status))
+			return status;
+
+		    stroker->has_current_face = FALSE;
+		}
+
+		remain -= skip;
+		if (remain <= 0)
+		    break;
+
+		dx2 = slope_dx * (mag - remain);
+		dy2 = slope_dy * (mag - remain);
+		cairo_matrix_transform_distance (stroker->ctm, &dx2, &dy2);
+		segment.p1.x = _cairo_fixed_from_double (dx2) + p1->x;
+		segment.p1.y = _cairo_fixed_from_double (dy2) + p1->y;
+	    }
+	}
+
 	step_length = MIN (stroker->dash.dash_remain, remain);
 	remain -= step_length;
 	dx2 = slope_dx * (mag - remain);
@@ -1429,14 +1485,25 @@ _cairo_path_fixed_stroke_dashed_to_polygon (const cairo_path_fixed_t	*path,
     stroker.add_external_edge = _cairo_polygon_add_external_edge,
     stroker.closure = polygon;
 
-    status = _cairo_path_fixed_interpret (path,
-					  _cairo_stroker_move_to,
-					  stroker.dash.dashed ?
-					  _cairo_stroker_line_to_dashed :
-					  _cairo_stroker_line_to,
-					  _cairo_stroker_curve_to,
-					  _cairo_stroker_close_path,
-					  &stroker);
+    if (stroker.has_bounds) {
+	status = _cairo_path_fixed_interpret_culled (path, &stroker.bounds,
+						     _cairo_stroker_move_to,
+						     stroker.dash.dashed ?
+						     _cairo_stroker_line_to_dashed :
+						     _cairo_stroker_line_to,
+						     _cairo_stroker_curve_to,
+						     _cairo_stroker_close_path,
+						     &stroker);
+    } else {
+	status = _cairo_path_fixed_interpret (path,
+					      _cairo_stroker_move_to,
+					      stroker.dash.dashed ?
+					      _cairo_stroker_line_to_dashed :
+					      _cairo_stroker_line_to,
+					      _cairo_stroker_curve_to,
+					      _cairo_stroker_close_path,
+					      &stroker);
+    }
 
     if (unlikely (status))
 	goto BAIL;
@@ -142,6 +142,14 @@ typedef struct cairo_path_populate {
     cairo_t *cr;
 } cpp_t;
 
+static inline void
+_cpp_backend_to_user (cpp_t *cpp, double *x, double *y)
+{
+    /* without a context, the path is copied untransformed */
+    if (cpp->cr != NULL)
+	_cairo_backend_to_user (cpp->cr, x, y);
+}
+
 static cairo_status_t
 _cpp_move_to (void *closure,
 	      const cairo_point_t *point)
@@ -153,7 +161,7 @@ _cpp_move_to (void *closure,
     x = _cairo_fixed_to_double (point->x);
     y = _cairo_fixed_to_double (point->y);
 
-    _cairo_backend_to_user (cpp->cr, &x, &y);
+    _cpp_backend_to_user (cpp, &x, &y);
 
     data->header.type = CAIRO_PATH_MOVE_TO;
     data->header.length = 2;
@@ -178,7 +186,7 @@ _cpp_line_to (void *closure,
     x = _cairo_fixed_to_double (point->x);
     y = _cairo_fixed_to_double (point->y);
 
-    _cairo_backend_to_user (cpp->cr, &x, &y);
+    _cpp_backend_to_user (cpp, &x, &y);
 
     data->header.type = CAIRO_PATH_LINE_TO;
     data->header.length = 2;
@@ -206,15 +214,15 @@ _cpp_curve_to (void			*closure,
 
     x1 = _cairo_fixed_to_double (p1->x);
     y1 = _cairo_fixed_to_double (p1->y);
-    _cairo_backend_to_user (cpp->cr, &x1, &y1);
+    _cpp_backend_to_user (cpp, &x1, &y1);
 
     x2 = _cairo_fixed_to_double (p2->x);
     y2 = _cairo_fixed_to_double (p2->y);
-    _cairo_backend_to_user (cpp->cr, &x2, &y2);
+    _cpp_backend_to_user (cpp, &x2, &y2);
 
     x3 = _cairo_fixed_to_double (p3->x);
     y3 = _cairo_fixed_to_double (p3->y);
-    _cairo_backend_to_user (cpp->cr, &x3, &y3);
+    _cpp_backend_to_user (cpp, &x3, &y3);
 
     data->header.type = CAIRO_PATH_CURVE_TO;
     data->header.length = 4;
@@ -321,7 +329,7 @@ _cairo_path_create_internal (cairo_path_fixed_t *path_fixed,
     }
 
     path->num_data = _cairo_path_count (path, path_fixed,
-					cairo_get_tolerance (cr),
+					flatten ? cairo_get_tolerance (cr) : 0.,
 					flatten);
     if (path->num_data < 0) {
 	free (path);
@@ -417,6 +425,25 @@ _cairo_path_create_flat (cairo_path_fixed_t *path,
     return _cairo_path_create_internal (path, cr, TRUE);
 }
 
+/**
+ * _cairo_path_create_untransformed:
+ * @path: a fixed-point path to be converted and copied
+ *
+ * Creates a #cairo_path_t copy of the given @path with its coordinates
+ * taken as they are, for operations on path data that do not involve
+ * any context.
+ *
+ * Return value: the new copy of the path. If there is insufficient
+ * memory a pointer to a special static nil #cairo_path_t will be
+ * returned instead with status==%CAIRO_STATUS_NO_MEMORY and
+ * data==%NULL.
+ **/
+cairo_path_t *
+_cairo_path_create_untransformed (cairo_path_fixed_t *path)
+{
+    return _cairo_path_create_internal (path, NULL, FALSE);
+}
+
 /**
  * _cairo_path_append_to_context:
  * @path: the path data to be appended
@@ -477,3 +504,79 @@ _cairo_path_append_to_context (const cairo_path_t	*path,
 
     return CAIRO_STATUS_SUCCESS;
 }
+
+/**
+ * _cairo_path_fixed_init_from_path:
+ * @fixed: the fixed-point path to initialize
+ * @path: the path data to be converted
+ *
+ * Initialize @fixed with a copy of @path, with its coordinates taken as
+ * they are. @fixed must be finished by the caller even on failure.
+ *
+ * Return value: the status of @path if it is in error,
+ * %CAIRO_STATUS_INVALID_PATH_DATA if the data in @path is invalid, and
+ * %CAIRO_STATUS_SUCCESS otherwise.
+ **/
+cairo_status_t
+_cairo_path_fixed_init_from_path (cairo_path_fixed_t *fixed,
+				  const cairo_path_t *path)
+{
+    const cairo_path_data_t *p, *end;
+    cairo_status_t status;
+
+    _cairo_path_fixed_init (fixed);
+
+    if (unlikely (path->status))
+	return path->status;
+
+    end = &path->data[path->num_data];
+    for (p = &path->data[0]; p < end; p += p->header.length) {
+	switch (p->header.type) {
+	case CAIRO_PATH_MOVE_TO:
+	    if (unlikely (p->header.length < 2))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    status = _cairo_path_fixed_move_to (fixed,
+						_cairo_fixed_from_double (p[1].point.x),
+						_cairo_fixed_from_double (p[1].point.y));
+	    break;
+
+	case CAIRO_PATH_LINE_TO:
+	    if (unlikely (p->header.length < 2))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    status = _cairo_path_fixed_line_to (fixed,
+						_cairo_fixed_from_double (p[1].point.x),
+						_cairo_fixed_from_double (p[1].point.y));
+	    break;
+
+	case CAIRO_PATH_CURVE_TO:
+	    if (unlikely (p->header.length < 4))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    status = _cairo_path_fixed_curve_to (fixed,
+						 _cairo_fixed_from_double (p[1].point.x),
+						 _cairo_fixed_from_double (p[1].point.y),
+						 _cairo_fixed_from_double (p[2].point.x),
+						 _cairo_fixed_from_double (p[2].point.y),
+						 _cairo_fixed_from_double (p[3].point.x),
+						 _cairo_fixed_from_double (p[3].point.y));
+	    break;
+
+	case CAIRO_PATH_CLOSE_PATH:
+	    if (unlikely (p->header.length < 1))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    status = _cairo_path_fixed_close_path (fixed);
+	    break;
+
+	default:
+	    return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+	}
+
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+/* This fragment implements a stable LSD radix sort over a 32-bit
+ * unsigned key, one byte per pass. The histograms for all four passes
+ * are gathered up front, and any pass in which every element falls into
+ * the same bucket is skipped, so small ranges of keys (such as the rows
+ * of a clip or an event type) cost a single read of the input.
+ *
+ * Being stable, a compound key can be sorted by calling successive
+ * sorts from the least to the most significant field. The caller
+ * provides a scratch array of nmemb elements.
+ */
+#ifndef _HAVE_CAIRO_RADIXSORT_SIGNED_KEY
+#define _HAVE_CAIRO_RADIXSORT_SIGNED_KEY
+/* Map a signed ordinate onto an unsigned key of the same order */
+static inline uint32_t
+_cairo_radixsort_signed_key (int32_t v)
+{
+  return (uint32_t) v ^ 0x80000000;
+}
+#endif
+
+#define CAIRO_RADIXSORT_DECLARE(NAME, TYPE, KEY) \
+static void \
+NAME (TYPE *base, TYPE *tmp, unsigned int nmemb) \
+{ \
+  unsigned int count[4][256]; \
+  TYPE *src = base; \
+  TYPE *dst = tmp; \
+  TYPE *swap; \
+  unsigned int i, n, pass, sum; \
+  uint32_t key; \
+  if (nmemb < 2) \
+      return; \
+  memset (count, 0, sizeof (count)); \
+  for (i = 0; i < nmemb; i++) { \
+      key = KEY (base[i]); \
+      count[0][key & 0xff]++; \
+      count[1][(key >> 8) & 0xff]++; \
+      count[2][(key >> 16) & 0xff]++; \
+      count[3][key >> 24]++; \
+  } \
+  for (pass = 0; pass < 4; pass++) { \
+      unsigned int *c = count[pass]; \
+      unsigned int shift = 8 * pass; \
+      if (c[(KEY (src[0]) >> shift) & 0xff] == nmemb) \
+	  continue; \
+      for (n = sum = 0; n < 256; n++) { \
+	  unsigned int t = c[n]; \
+	  c[n] = sum; \
+	  sum += t; \
+      } \
+      for (i = 0; i < nmemb; i++) { \
+	  key = KEY (src[i]); \
+	  dst[c[(key >> shift) & 0xff]++] = src[i]; \
+      } \
+      swap = src; src = dst; dst = swap; \
+  } \
+  if (src != base) \
+      memcpy (base, src, nmemb * sizeof (TYPE)); \
+}
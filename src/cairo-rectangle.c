@@ -258,6 +258,53 @@ _cairo_box_intersects_line_segment (const cairo_box_t *box, cairo_line_t *line)
     return FALSE;
 }
 
+static cairo_bool_t
+_clip_line_parameter (double p, double q, double *t0, double *t1)
+{
+    double r;
+
+    if (p == 0.)
+	return q >= 0.;
+
+    r = q / p;
+    if (p < 0.) {
+	if (r > *t1)
+	    return FALSE;
+	if (r > *t0)
+	    *t0 = r;
+    } else {
+	if (r < *t0)
+	    return FALSE;
+	if (r < *t1)
+	    *t1 = r;
+    }
+
+    return TRUE;
+}
+
+/* Computes the parametric range [t0, t1] (0 at p1, 1 at p2) of the portion
+ * of the line segment lying within the box, returning FALSE if it misses
+ * the box altogether. (Liang-Barsky)
+ */
+cairo_bool_t
+_cairo_box_clip_line_segment (const cairo_box_t *box,
+			      const cairo_line_t *line,
+			      double *t0, double *t1)
+{
+    double dx, dy;
+
+    dx = _cairo_fixed_to_double (P2x - P1x);
+    dy = _cairo_fixed_to_double (P2y - P1y);
+
+    *t0 = 0.;
+    *t1 = 1.;
+    return
+	_clip_line_parameter (-dx, _cairo_fixed_to_double (P1x - B1x), t0, t1) &&
+	_clip_line_parameter ( dx, _cairo_fixed_to_double (B2x - P1x), t0, t1) &&
+	_clip_line_parameter (-dy, _cairo_fixed_to_double (P1y - B1y), t0, t1) &&
+	_clip_line_parameter ( dy, _cairo_fixed_to_double (B2y - P1y), t0, t1);
+}
+
 static cairo_status_t
 _cairo_box_add_spline_point (void *closure,
 			     const cairo_point_t *point,
@@ -48,6 +48,8 @@
 CAIRO_BEGIN_DECLS
 
 typedef struct _cairo_scaled_glyph_page cairo_scaled_glyph_page_t;
+typedef struct _cairo_scaled_font_glyph_lut cairo_scaled_font_glyph_lut_t;
+typedef struct _cairo_scaled_font_glyph_metrics cairo_scaled_font_glyph_metrics_t;
 
 struct _cairo_scaled_font {
     /* For most cairo objects, the rule for multiple threads is that
@@ -72,7 +74,8 @@ struct _cairo_scaled_font {
      *    count of a scaled font is intimately related with the font
      *    map itself, (and the magic holdovers array).
      *
-     * 2. The cache of glyphs (scaled_font->glyphs)
+     * 2. The cache of glyphs (scaled_font->glyphs, scaled_font->glyph_lut,
+     *				 scaled_font->glyph_metrics)
      * 3. The backend private data (scaled_font->surface_backend,
      *				    scaled_font->surface_private)
      *
@@ -103,6 +106,7 @@ struct _cairo_scaled_font {
     cairo_matrix_t scale;	     /* font space => device space */
     cairo_matrix_t scale_inverse;    /* device space => font space */
     double max_scale;		     /* maximum x/y expansion of scale */
+    int subpixel_phases;	     /* those of options the backend renders */
     cairo_font_extents_t extents;    /* user space */
     cairo_font_extents_t fs_extents; /* font space */
 
@@ -111,6 +115,8 @@ struct _cairo_scaled_font {
 
     cairo_hash_table_t *glyphs;
     cairo_list_t glyph_pages;
+    cairo_scaled_font_glyph_lut_t *glyph_lut; /* codepoint => glyph index */
+    cairo_scaled_font_glyph_metrics_t *glyph_metrics; /* for layout only */
     cairo_bool_t cache_frozen;
     cairo_bool_t global_cache_frozen;
 
@@ -138,7 +144,9 @@ struct _cairo_scaled_glyph {
     int16_t                 y_advance;		/* device-space rounded Y advance */
 
     unsigned int	    has_info;
+    int			    xphase;		/* subpixel phase of surface */
     cairo_image_surface_t   *surface;		/* device-space image */
+    cairo_image_glyph_shelf_t *atlas_shelf;	/* atlas space holding surface */
     cairo_path_fixed_t	    *path;		/* device-space outline */
     cairo_surface_t         *recording_surface;	/* device-space recording-surface */
 
@@ -39,6 +39,7 @@
  */
 
 #include "cairoint.h"
+#include "cairo-combsort-inline.h"
 #include "cairo-error-private.h"
 #include "cairo-image-surface-private.h"
 #include "cairo-list-inline.h"
@@ -200,6 +201,24 @@ struct _cairo_scaled_glyph_page {
 static void
 _cairo_scaled_font_fini_internal (cairo_scaled_font_t *scaled_font);
 
+static void
+_cairo_scaled_glyph_fini_surface (cairo_scaled_glyph_t *scaled_glyph)
+{
+    if (scaled_glyph->surface == NULL)
+	return;
+
+    if (scaled_glyph->atlas_shelf != NULL) {
+	/* The pixels are about to be handed to another glyph, so cut
+	 * off anyone still holding a reference to the surface first. */
+	cairo_surface_finish (&scaled_glyph->surface->base);
+	_cairo_image_glyph_atlas_release (scaled_glyph->atlas_shelf);
+	scaled_glyph->atlas_shelf = NULL;
+    }
+
+    cairo_surface_destroy (&scaled_glyph->surface->base);
+    scaled_glyph->surface = NULL;
+}
+
 static void
 _cairo_scaled_glyph_fini (cairo_scaled_font_t *scaled_font,
 			  cairo_scaled_glyph_t *scaled_glyph)
@@ -214,8 +233,7 @@ _cairo_scaled_glyph_fini (cairo_scaled_font_t *scaled_font,
 
     _cairo_image_scaled_glyph_fini (scaled_font, scaled_glyph);
 
-    if (scaled_glyph->surface != NULL)
-	cairo_surface_destroy (&scaled_glyph->surface->base);
+    _cairo_scaled_glyph_fini_surface (scaled_glyph);
 
     if (scaled_glyph->path != NULL)
 	_cairo_path_fixed_destroy (scaled_glyph->path);
@@ -246,11 +264,14 @@ static const cairo_scaled_font_t _cairo_scaled_font_nil = {
     { 1., 0., 0., 1., 0, 0},	/* scale */
     { 1., 0., 0., 1., 0, 0},	/* scale_inverse */
     1.,				/* max_scale */
+    1,				/* subpixel_phases */
     { 0., 0., 0., 0., 0. },	/* extents */
     { 0., 0., 0., 0., 0. },	/* fs_extents */
     CAIRO_MUTEX_NIL_INITIALIZER,/* mutex */
     NULL,			/* glyphs */
     { NULL, NULL },		/* pages */
+    NULL,			/* glyph_lut */
+    NULL,			/* glyph_metrics */
     FALSE,			/* cache_frozen */
     FALSE,			/* global_cache_frozen */
     { NULL, NULL },		/* privates */
@@ -740,6 +761,8 @@ _cairo_scaled_font_init (cairo_scaled_font_t               *scaled_font,
 
     scaled_font->max_scale = MAX (fabs (scaled_font->scale.xx) + fabs (scaled_font->scale.xy),
 				  fabs (scaled_font->scale.yx) + fabs (scaled_font->scale.yy));
+    /* until the backend says it can render them */
+    scaled_font->subpixel_phases = 1;
     scaled_font->scale_inverse = scaled_font->scale;
     status = cairo_matrix_invert (&scaled_font->scale_inverse);
     if (unlikely (status)) {
@@ -766,6 +789,8 @@ _cairo_scaled_font_init (cairo_scaled_font_t               *scaled_font,
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
     cairo_list_init (&scaled_font->glyph_pages);
+    scaled_font->glyph_lut = NULL;
+    scaled_font->glyph_metrics = NULL;
     scaled_font->cache_frozen = FALSE;
     scaled_font->global_cache_frozen = FALSE;
 
@@ -867,6 +892,9 @@ _cairo_scaled_font_set_metrics (cairo_scaled_font_t	    *scaled_font,
     return CAIRO_STATUS_SUCCESS;
 }
 
+static void
+_cairo_scaled_font_glyph_metrics_destroy (cairo_scaled_font_glyph_metrics_t *cache);
+
 static void
 _cairo_scaled_font_fini_internal (cairo_scaled_font_t *scaled_font)
 {
@@ -876,6 +904,8 @@ _cairo_scaled_font_fini_internal (cairo_scaled_font_t *scaled_font)
 
     _cairo_scaled_font_reset_cache (scaled_font);
     _cairo_hash_table_destroy (scaled_font->glyphs);
+    free (scaled_font->glyph_lut);
+    _cairo_scaled_font_glyph_metrics_destroy (scaled_font->glyph_metrics);
 
     cairo_font_face_destroy (scaled_font->font_face);
     cairo_font_face_destroy (scaled_font->original_font_face);
@@ -1567,7 +1597,7 @@ cairo_scaled_font_glyph_extents (cairo_scaled_font_t   *scaled_font,
     int i;
     double min_x = 0.0, min_y = 0.0, max_x = 0.0, max_y = 0.0;
     cairo_bool_t visible = FALSE;
-    cairo_scaled_glyph_t *scaled_glyph = NULL;
+    cairo_text_extents_t metrics;
 
     extents->x_bearing = 0.0;
     extents->y_bearing = 0.0;
@@ -1599,23 +1629,22 @@ cairo_scaled_font_glyph_extents (cairo_scaled_font_t   *scaled_font,
     for (i = 0; i < num_glyphs; i++) {
 	double			left, top, right, bottom;
 
-	status = _cairo_scaled_glyph_lookup (scaled_font,
-					     glyphs[i].index,
-					     CAIRO_SCALED_GLYPH_INFO_METRICS,
-					     &scaled_glyph);
+	status = _cairo_scaled_glyph_lookup_metrics (scaled_font,
+						     glyphs[i].index,
+						     &metrics, NULL);
 	if (unlikely (status)) {
 	    status = _cairo_scaled_font_set_error (scaled_font, status);
 	    goto UNLOCK;
 	}
 
 	/* "Ink" extents should skip "invisible" glyphs */
-	if (scaled_glyph->metrics.width == 0 || scaled_glyph->metrics.height == 0)
+	if (metrics.width == 0 || metrics.height == 0)
 	    continue;
 
-	left = scaled_glyph->metrics.x_bearing + glyphs[i].x;
-	right = left + scaled_glyph->metrics.width;
-	top = scaled_glyph->metrics.y_bearing + glyphs[i].y;
-	bottom = top + scaled_glyph->metrics.height;
+	left = metrics.x_bearing + glyphs[i].x;
+	right = left + metrics.width;
+	top = metrics.y_bearing + glyphs[i].y;
+	bottom = top + metrics.height;
 
 	if (!visible) {
 	    visible = TRUE;
@@ -1649,9 +1678,9 @@ cairo_scaled_font_glyph_extents (cairo_scaled_font_t   *scaled_font,
 	x0 = glyphs[0].x;
 	y0 = glyphs[0].y;
 
-	/* scaled_glyph contains the glyph for num_glyphs - 1 already. */
-	x1 = glyphs[num_glyphs - 1].x + scaled_glyph->metrics.x_advance;
-	y1 = glyphs[num_glyphs - 1].y + scaled_glyph->metrics.y_advance;
+	/* metrics contains the glyph for num_glyphs - 1 already. */
+	x1 = glyphs[num_glyphs - 1].x + metrics.x_advance;
+	y1 = glyphs[num_glyphs - 1].y + metrics.y_advance;
 
 	extents->x_advance = x1 - x0;
 	extents->y_advance = y1 - y0;
@@ -1672,9 +1701,184 @@ ZERO_EXTENTS:
     extents->x_advance = 0.0;
     extents->y_advance = 0.0;
 }
+
 slim_hidden_def (cairo_scaled_font_glyph_extents);
 
-#define GLYPH_LUT_SIZE 64
+/**
+ * cairo_scaled_font_glyph_extents_array:
+ * @scaled_font: a #cairo_scaled_font_t
+ * @glyph_indices: an array of glyph IDs
+ * @num_glyphs: the number of glyphs in the @glyph_indices array
+ * @extents: an array of @num_glyphs #cairo_text_extents_t in which to
+ * store the extents of each glyph
+ *
+ * Gets the extents of each glyph in an array, as
+ * cairo_scaled_font_glyph_extents() would for that glyph alone, placed
+ * at the origin: the x_bearing, y_bearing, width and height give the
+ * "inked" rectangle of the glyph, and x_advance and y_advance its
+ * advance. Laying out a run of text this way is much cheaper than
+ * asking for the extents of each glyph, or each word, in turn.
+ *
+ * If an error occurs, every element of @extents is set to zero.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, or an error status; the error
+ * is also set on @scaled_font if it comes from the font.
+ *
+ * Since: 1.16
+ **/
+cairo_status_t
+cairo_scaled_font_glyph_extents_array (cairo_scaled_font_t  *scaled_font,
+				       const unsigned long  *glyph_indices,
+				       int		     num_glyphs,
+				       cairo_text_extents_t *extents)
+{
+    struct {
+	unsigned long index;
+	cairo_text_extents_t metrics;
+    } glyph_cache[64];
+    cairo_text_extents_t *metrics;
+    cairo_status_t status;
+    int i;
+
+    if (unlikely (scaled_font->status))
+	return scaled_font->status;
+
+    if (num_glyphs == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (unlikely (num_glyphs < 0))
+	return _cairo_error (CAIRO_STATUS_NEGATIVE_COUNT);
+
+    if (unlikely (glyph_indices == NULL || extents == NULL))
+	return _cairo_error (CAIRO_STATUS_NULL_POINTER);
+
+    /* Start each slot with an index that cannot hash to it, so that it
+     * never matches until filled in. */
+    for (i = 0; i < ARRAY_LENGTH (glyph_cache); i++)
+	glyph_cache[i].index = i + 1;
+
+    _cairo_scaled_font_freeze_cache (scaled_font);
+
+    status = CAIRO_STATUS_SUCCESS;
+    for (i = 0; i < num_glyphs; i++) {
+	unsigned long index = glyph_indices[i];
+	int cache_index = index % ARRAY_LENGTH (glyph_cache);
+
+	if (glyph_cache[cache_index].index != index) {
+	    status = _cairo_scaled_glyph_lookup_metrics (scaled_font, index,
+							 &glyph_cache[cache_index].metrics,
+							 NULL);
+	    if (unlikely (status))
+		break;
+
+	    /* as for cairo_scaled_font_glyph_extents(), "invisible"
+	     * glyphs have no ink */
+	    metrics = &glyph_cache[cache_index].metrics;
+	    if (metrics->width == 0 || metrics->height == 0) {
+		metrics->x_bearing = metrics->y_bearing = 0;
+		metrics->width = metrics->height = 0;
+	    }
+
+	    glyph_cache[cache_index].index = index;
+	}
+
+	extents[i] = glyph_cache[cache_index].metrics;
+    }
+
+    _cairo_scaled_font_thaw_cache (scaled_font);
+
+    if (unlikely (status)) {
+	status = _cairo_scaled_font_set_error (scaled_font, status);
+	memset (extents, 0, num_glyphs * sizeof (cairo_text_extents_t));
+    }
+
+    return status;
+}
+
+/* The mapping from codepoints to glyph indices and advances is fixed for
+ * the lifetime of a scaled font, so we remember it in a direct-mapped
+ * table hanging off the font rather than asking the backend again for
+ * every character of every string. The table starts small, enough for
+ * the Latin text that makes up most labels, and is enlarged whenever too
+ * many lookups evict a live entry, as happens with larger scripts.
+ *
+ * The table is only touched whilst the glyph cache is frozen, and so is
+ * protected by scaled_font->mutex.
+ */
+#define GLYPH_LUT_MIN_SIZE 64
+#define GLYPH_LUT_MAX_SIZE 1024
+
+struct glyph_lut_elt {
+    uint32_t unicode;
+    unsigned long index;
+    double x_advance;
+    double y_advance;
+};
+
+struct _cairo_scaled_font_glyph_lut {
+    unsigned int size;
+    unsigned int lookups;
+    unsigned int evictions;
+    struct glyph_lut_elt elt[1];
+};
+
+static cairo_scaled_font_glyph_lut_t *
+_cairo_scaled_font_glyph_lut_create (unsigned int size)
+{
+    cairo_scaled_font_glyph_lut_t *lut;
+    unsigned int i;
+
+    lut = _cairo_malloc_ab_plus_c (size - 1, sizeof (struct glyph_lut_elt),
+				   sizeof (cairo_scaled_font_glyph_lut_t));
+    if (unlikely (lut == NULL))
+	return NULL;
+
+    lut->size = size;
+    lut->lookups = 0;
+    lut->evictions = 0;
+    for (i = 0; i < size; i++)
+	lut->elt[i].unicode = ~0U;
+
+    return lut;
+}
+
+static cairo_scaled_font_glyph_lut_t *
+_cairo_scaled_font_glyph_lut (cairo_scaled_font_t *scaled_font)
+{
+    cairo_scaled_font_glyph_lut_t *lut = scaled_font->glyph_lut;
+
+    if (lut == NULL) {
+	lut = _cairo_scaled_font_glyph_lut_create (GLYPH_LUT_MIN_SIZE);
+	scaled_font->glyph_lut = lut;
+    }
+
+    return lut;
+}
+
+static void
+_cairo_scaled_font_glyph_lut_grow (cairo_scaled_font_t *scaled_font)
+{
+    cairo_scaled_font_glyph_lut_t *old = scaled_font->glyph_lut;
+    cairo_scaled_font_glyph_lut_t *lut;
+    unsigned int i;
+
+    lut = _cairo_scaled_font_glyph_lut_create (4 * old->size);
+    if (unlikely (lut == NULL)) {
+	/* Carry on with what we have, and try again later. */
+	old->lookups = old->evictions = 0;
+	return;
+    }
+
+    for (i = 0; i < old->size; i++) {
+	const struct glyph_lut_elt *elt = &old->elt[i];
+	if (elt->unicode != ~0U)
+	    lut->elt[elt->unicode & (lut->size - 1)] = *elt;
+    }
+
+    scaled_font->glyph_lut = lut;
+    free (old);
+}
+
 static cairo_status_t
 cairo_scaled_font_text_to_glyphs_internal_cached (cairo_scaled_font_t		 *scaled_font,
 						    double			  x,
@@ -1684,24 +1888,16 @@ cairo_scaled_font_text_to_glyphs_internal_cached (cairo_scaled_font_t		 *scaled_
 						    cairo_text_cluster_t	**clusters,
 						    int				  num_chars)
 {
-    struct glyph_lut_elt {
-	unsigned long index;
-	double x_advance;
-	double y_advance;
-    } glyph_lut[GLYPH_LUT_SIZE];
-    uint32_t glyph_lut_unicode[GLYPH_LUT_SIZE];
+    cairo_scaled_font_glyph_lut_t *lut = scaled_font->glyph_lut;
     cairo_status_t status;
     const char *p;
     int i;
 
-    for (i = 0; i < GLYPH_LUT_SIZE; i++)
-	glyph_lut_unicode[i] = ~0U;
-
     p = utf8;
     for (i = 0; i < num_chars; i++) {
-	int idx, num_bytes;
+	int num_bytes;
 	uint32_t unicode;
-	cairo_scaled_glyph_t *scaled_glyph;
+	cairo_text_extents_t metrics;
 	struct glyph_lut_elt *glyph_slot;
 
 	num_bytes = _cairo_utf8_get_char_validated (p, &unicode);
@@ -1710,9 +1906,8 @@ cairo_scaled_font_text_to_glyphs_internal_cached (cairo_scaled_font_t		 *scaled_
 	glyphs[i].x = x;
 	glyphs[i].y = y;
 
-	idx = unicode % ARRAY_LENGTH (glyph_lut);
-	glyph_slot = &glyph_lut[idx];
-	if (glyph_lut_unicode[idx] == unicode) {
+	glyph_slot = &lut->elt[unicode & (lut->size - 1)];
+	if (glyph_slot->unicode == unicode) {
 	    glyphs[i].index = glyph_slot->index;
 	    x += glyph_slot->x_advance;
 	    y += glyph_slot->y_advance;
@@ -1720,20 +1915,21 @@ cairo_scaled_font_text_to_glyphs_internal_cached (cairo_scaled_font_t		 *scaled_
 	    unsigned long g;
 
 	    g = scaled_font->backend->ucs4_to_index (scaled_font, unicode);
-	    status = _cairo_scaled_glyph_lookup (scaled_font,
-						 g,
-						 CAIRO_SCALED_GLYPH_INFO_METRICS,
-						 &scaled_glyph);
+	    status = _cairo_scaled_glyph_lookup_metrics (scaled_font, g,
+							 &metrics, NULL);
 	    if (unlikely (status))
 		return status;
 
-	    x += scaled_glyph->metrics.x_advance;
-	    y += scaled_glyph->metrics.y_advance;
+	    x += metrics.x_advance;
+	    y += metrics.y_advance;
 
-	    glyph_lut_unicode[idx] = unicode;
+	    if (glyph_slot->unicode != ~0U)
+		lut->evictions++;
+
+	    glyph_slot->unicode = unicode;
 	    glyph_slot->index = g;
-	    glyph_slot->x_advance = scaled_glyph->metrics.x_advance;
-	    glyph_slot->y_advance = scaled_glyph->metrics.y_advance;
+	    glyph_slot->x_advance = metrics.x_advance;
+	    glyph_slot->y_advance = metrics.y_advance;
 
 	    glyphs[i].index = g;
 	}
@@ -1744,6 +1940,18 @@ cairo_scaled_font_text_to_glyphs_internal_cached (cairo_scaled_font_t		 *scaled_
 	}
     }
 
+    /* Review the hit rate over a window of lookups proportional to the
+     * size of the table; if more than one in eight thrashed a live entry
+     * the working set is larger than the table.
+     */
+    lut->lookups += num_chars;
+    if (lut->lookups >= 4 * lut->size) {
+	if (lut->evictions > lut->lookups / 8 && lut->size < GLYPH_LUT_MAX_SIZE)
+	    _cairo_scaled_font_glyph_lut_grow (scaled_font);
+	else
+	    lut->lookups = lut->evictions = 0;
+    }
+
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -1764,7 +1972,7 @@ cairo_scaled_font_text_to_glyphs_internal_uncached (cairo_scaled_font_t	 *scaled
 	unsigned long g;
 	int num_bytes;
 	uint32_t unicode;
-	cairo_scaled_glyph_t *scaled_glyph;
+	cairo_text_extents_t metrics;
 	cairo_status_t status;
 
 	num_bytes = _cairo_utf8_get_char_validated (p, &unicode);
@@ -1780,15 +1988,13 @@ cairo_scaled_font_text_to_glyphs_internal_uncached (cairo_scaled_font_t	 *scaled
 	 * one-character strings by skipping glyph lookup.
 	 */
 	if (num_chars > 1) {
-	    status = _cairo_scaled_glyph_lookup (scaled_font,
-					     g,
-					     CAIRO_SCALED_GLYPH_INFO_METRICS,
-					     &scaled_glyph);
+	    status = _cairo_scaled_glyph_lookup_metrics (scaled_font, g,
+							 &metrics, NULL);
 	    if (unlikely (status))
 		return status;
 
-	    x += scaled_glyph->metrics.x_advance;
-	    y += scaled_glyph->metrics.y_advance;
+	    x += metrics.x_advance;
+	    y += metrics.y_advance;
 	}
 
 	glyphs[i].index = g;
@@ -1937,7 +2143,6 @@ cairo_scaled_font_text_to_glyphs_internal_uncached (cairo_scaled_font_t	 *scaled
  *
  * Since: 1.8
  **/
-#define CACHING_THRESHOLD 16
 cairo_status_t
 cairo_scaled_font_text_to_glyphs (cairo_scaled_font_t   *scaled_font,
 				  double		 x,
@@ -2091,7 +2296,7 @@ cairo_scaled_font_text_to_glyphs (cairo_scaled_font_t   *scaled_font,
 	*num_clusters = num_chars;
     }
 
-    if (num_chars > CACHING_THRESHOLD)
+    if (likely (_cairo_scaled_font_glyph_lut (scaled_font) != NULL))
 	status = cairo_scaled_font_text_to_glyphs_internal_cached (scaled_font,
 								     x, y,
 								     utf8,
@@ -2155,6 +2360,19 @@ _range_contains_glyph (const cairo_box_t *extents,
 	   top < extents->p2.y;
 }
 
+/* The images of glyphs placed at subpixel phases may lie up to half
+ * a phase away from the exact position of the glyph. */
+static cairo_fixed_t
+_cairo_scaled_font_phase_pad (cairo_scaled_font_t *scaled_font)
+{
+    int phases = scaled_font->subpixel_phases;
+
+    if (phases <= 1)
+	return 0;
+
+    return _cairo_fixed_from_double (.5 / phases) + 1;
+}
+
 static cairo_status_t
 _cairo_scaled_font_single_glyph_device_extents (cairo_scaled_font_t	 *scaled_font,
 						const cairo_glyph_t	 *glyph,
@@ -2170,15 +2388,16 @@ _cairo_scaled_font_single_glyph_device_extents (cairo_scaled_font_t	 *scaled_fon
 					 &scaled_glyph);
     if (likely (status == CAIRO_STATUS_SUCCESS)) {
 	cairo_bool_t round_xy = _cairo_font_options_get_round_glyph_positions (&scaled_font->options) == CAIRO_ROUND_GLYPH_POS_ON;
+	cairo_fixed_t pad = _cairo_scaled_font_phase_pad (scaled_font);
 	cairo_box_t box;
 	cairo_fixed_t v;
 
-	if (round_xy)
+	if (round_xy && pad == 0)
 	    v = _cairo_fixed_from_int (_cairo_lround (glyph->x));
 	else
 	    v = _cairo_fixed_from_double (glyph->x);
-	box.p1.x = v + scaled_glyph->bbox.p1.x;
-	box.p2.x = v + scaled_glyph->bbox.p2.x;
+	box.p1.x = v + scaled_glyph->bbox.p1.x - pad;
+	box.p2.x = v + scaled_glyph->bbox.p2.x + pad;
 
 	if (round_xy)
 	    v = _cairo_fixed_from_int (_cairo_lround (glyph->y));
@@ -2208,6 +2427,7 @@ _cairo_scaled_font_glyph_device_extents (cairo_scaled_font_t	 *scaled_font,
     cairo_scaled_glyph_t *glyph_cache[64];
     cairo_bool_t overlap = overlap_out ? FALSE : TRUE;
     cairo_round_glyph_positions_t round_glyph_positions = _cairo_font_options_get_round_glyph_positions (&scaled_font->options);
+    cairo_fixed_t pad = _cairo_scaled_font_phase_pad (scaled_font);
     int i;
 
     if (unlikely (scaled_font->status))
@@ -2223,6 +2443,14 @@ _cairo_scaled_font_glyph_device_extents (cairo_scaled_font_t	 *scaled_font,
 
     _cairo_scaled_font_freeze_cache (scaled_font);
 
+    status = _cairo_scaled_font_prefetch_glyphs (scaled_font,
+						 glyphs, num_glyphs,
+						 CAIRO_SCALED_GLYPH_INFO_METRICS);
+    if (unlikely (status)) {
+	_cairo_scaled_font_thaw_cache (scaled_font);
+	return status;
+    }
+
     memset (glyph_cache, 0, sizeof (glyph_cache));
 
     for (i = 0; i < num_glyphs; i++) {
@@ -2244,12 +2472,12 @@ _cairo_scaled_font_glyph_device_extents (cairo_scaled_font_t	 *scaled_font,
 	    glyph_cache[cache_index] = scaled_glyph;
 	}
 
-	if (round_glyph_positions == CAIRO_ROUND_GLYPH_POS_ON)
+	if (round_glyph_positions == CAIRO_ROUND_GLYPH_POS_ON && pad == 0)
 	    x = _cairo_fixed_from_int (_cairo_lround (glyphs[i].x));
 	else
 	    x = _cairo_fixed_from_double (glyphs[i].x);
-	x1 = x + scaled_glyph->bbox.p1.x;
-	x2 = x + scaled_glyph->bbox.p2.x;
+	x1 = x + scaled_glyph->bbox.p1.x - pad;
+	x2 = x + scaled_glyph->bbox.p2.x + pad;
 
 	if (round_glyph_positions == CAIRO_ROUND_GLYPH_POS_ON)
 	    y = _cairo_fixed_from_int (_cairo_lround (glyphs[i].y));
@@ -2328,6 +2556,39 @@ _cairo_scaled_font_glyph_approximate_extents (cairo_scaled_font_t	 *scaled_font,
     return TRUE;
 }
 
+/**
+ * _cairo_scaled_font_glyph_phase:
+ * @scaled_font: a #cairo_scaled_font_t
+ * @index: the glyph index
+ * @x: the device-space x position of the glyph
+ *
+ * Chooses the image of the glyph to composite at @x. If the font
+ * options ask for subpixel phases and the backend can render them, @x
+ * is split into a whole pixel, returned in @x, and the nearest phase
+ * within it, which is folded into the returned cache key; otherwise
+ * @index is returned as it is and @x is left for the caller to round,
+ * as for any other font.
+ *
+ * Returns: the key to look the glyph up with
+ **/
+unsigned long
+_cairo_scaled_font_glyph_phase (cairo_scaled_font_t *scaled_font,
+				unsigned long        index,
+				double              *x)
+{
+    int phases = scaled_font->subpixel_phases;
+    double q, pixel;
+
+    if (phases <= 1 || index > CAIRO_SCALED_GLYPH_INDEX_MASK)
+	return index;
+
+    q = floor (*x * phases + .5);
+    pixel = floor (q / phases);
+    *x = pixel;
+
+    return index | ((unsigned long) (q - pixel * phases) << CAIRO_SCALED_GLYPH_PHASE_SHIFT);
+}
+
 #if 0
 /* XXX win32 */
 cairo_status_t
@@ -2771,11 +3032,23 @@ _cairo_scaled_glyph_set_surface (cairo_scaled_glyph_t *scaled_glyph,
 				 cairo_scaled_font_t *scaled_font,
 				 cairo_image_surface_t *surface)
 {
-    if (scaled_glyph->surface != NULL)
-	cairo_surface_destroy (&scaled_glyph->surface->base);
+    _cairo_scaled_glyph_fini_surface (scaled_glyph);
 
     /* sanity check the backend glyph contents */
     _cairo_debug_check_image_surface_is_defined (&surface->base);
+
+    /* Move small glyphs into the shared atlas, so that their images
+     * are packed together rather than spread across the heap. */
+    if (surface != NULL) {
+	cairo_image_surface_t *atlas;
+
+	atlas = _cairo_image_glyph_atlas_store (surface,
+						&scaled_glyph->atlas_shelf);
+	if (atlas != NULL) {
+	    cairo_surface_destroy (&surface->base);
+	    surface = atlas;
+	}
+    }
     scaled_glyph->surface = surface;
 
     if (surface != NULL)
@@ -2915,6 +3188,22 @@ _cairo_scaled_font_free_last_glyph (cairo_scaled_font_t *scaled_font,
     }
 }
 
+/* Sets the cache key of a glyph, taking its subpixel phase apart from
+ * the index only for fonts rendering phases (see
+ * _cairo_scaled_font_glyph_phase()), so that other fonts may use their
+ * whole range of indices.
+ */
+static void
+_cairo_scaled_glyph_set_key (cairo_scaled_font_t  *scaled_font,
+			     cairo_scaled_glyph_t *scaled_glyph,
+			     unsigned long	   key)
+{
+    scaled_glyph->hash_entry.hash = key;
+    scaled_glyph->xphase = 0;
+    if (scaled_font->subpixel_phases > 1)
+	scaled_glyph->xphase = key >> CAIRO_SCALED_GLYPH_PHASE_SHIFT;
+}
+
 /**
  * _cairo_scaled_glyph_lookup:
  * @scaled_font: a #cairo_scaled_font_t
@@ -2974,7 +3263,7 @@ _cairo_scaled_glyph_lookup (cairo_scaled_font_t *scaled_font,
 	    goto err;
 
 	memset (scaled_glyph, 0, sizeof (cairo_scaled_glyph_t));
-	_cairo_scaled_glyph_set_index (scaled_glyph, index);
+	_cairo_scaled_glyph_set_key (scaled_font, scaled_glyph, index);
 	cairo_list_init (&scaled_glyph->dev_privates);
 
 	/* ask backend to initialize metrics and shape fields */
@@ -3025,6 +3314,437 @@ err:
     return status;
 }
 
+/*
+ * Text layout only ever asks for the metrics of glyphs, but a whole
+ * #cairo_scaled_glyph_t taken from a glyph page just for its advance
+ * counts against the global page cache the same as a rendered glyph,
+ * so laying out a long document pushes out the images of the glyphs
+ * actually on screen. Glyphs wanted only for their metrics are instead
+ * kept in a small open-addressed table of their own, holding just the
+ * metrics and device space bounds side by side. When it fills up at
+ * its largest size the table is simply emptied, as the metrics are
+ * cheap to find again.
+ *
+ * As with the glyph cache, the table is only touched whilst the cache
+ * is frozen, and so is protected by scaled_font->mutex.
+ */
+#define GLYPH_METRICS_MIN_SIZE 256
+#define GLYPH_METRICS_MAX_SIZE 16384
+#define GLYPH_METRICS_EMPTY (~0UL)
+
+struct _cairo_scaled_font_glyph_metrics {
+    unsigned int size;
+    unsigned int count;
+    cairo_text_extents_t *metrics;
+    cairo_box_t *bbox;
+    unsigned long *index;
+};
+
+static cairo_scaled_font_glyph_metrics_t *
+_cairo_scaled_font_glyph_metrics_create (unsigned int size)
+{
+    cairo_scaled_font_glyph_metrics_t *cache;
+    unsigned int i;
+
+    cache = malloc (sizeof (cairo_scaled_font_glyph_metrics_t));
+    if (unlikely (cache == NULL))
+	return NULL;
+
+    cache->metrics = _cairo_malloc_ab (size,
+				       sizeof (cairo_text_extents_t) +
+				       sizeof (cairo_box_t) +
+				       sizeof (unsigned long));
+    if (unlikely (cache->metrics == NULL)) {
+	free (cache);
+	return NULL;
+    }
+
+    cache->bbox = (cairo_box_t *) (cache->metrics + size);
+    cache->index = (unsigned long *) (cache->bbox + size);
+    cache->size = size;
+    cache->count = 0;
+    for (i = 0; i < size; i++)
+	cache->index[i] = GLYPH_METRICS_EMPTY;
+
+    return cache;
+}
+
+static void
+_cairo_scaled_font_glyph_metrics_destroy (cairo_scaled_font_glyph_metrics_t *cache)
+{
+    if (cache == NULL)
+	return;
+
+    free (cache->metrics);
+    free (cache);
+}
+
+static unsigned int
+_cairo_scaled_font_glyph_metrics_find (const cairo_scaled_font_glyph_metrics_t *cache,
+				       unsigned long index)
+{
+    unsigned int mask = cache->size - 1;
+    unsigned int i = (index * 2654435761u) & mask;
+
+    while (cache->index[i] != index && cache->index[i] != GLYPH_METRICS_EMPTY)
+	i = (i + 1) & mask;
+
+    return i;
+}
+
+static void
+_cairo_scaled_font_glyph_metrics_add (cairo_scaled_font_t *scaled_font,
+				      unsigned long index,
+				      const cairo_text_extents_t *metrics,
+				      const cairo_box_t *bbox)
+{
+    cairo_scaled_font_glyph_metrics_t *cache = scaled_font->glyph_metrics;
+    unsigned int i;
+
+    if (cache == NULL) {
+	cache = _cairo_scaled_font_glyph_metrics_create (GLYPH_METRICS_MIN_SIZE);
+	if (unlikely (cache == NULL))
+	    return;
+
+	scaled_font->glyph_metrics = cache;
+    }
+
+    /* keep the table at most half full */
+    if (2 * (cache->count + 1) > cache->size) {
+	if (cache->size < GLYPH_METRICS_MAX_SIZE) {
+	    cairo_scaled_font_glyph_metrics_t *old = cache;
+
+	    cache = _cairo_scaled_font_glyph_metrics_create (2 * old->size);
+	    if (unlikely (cache == NULL))
+		return;
+
+	    for (i = 0; i < old->size; i++) {
+		unsigned int j;
+
+		if (old->index[i] == GLYPH_METRICS_EMPTY)
+		    continue;
+
+		j = _cairo_scaled_font_glyph_metrics_find (cache, old->index[i]);
+		cache->index[j] = old->index[i];
+		cache->metrics[j] = old->metrics[i];
+		cache->bbox[j] = old->bbox[i];
+	    }
+	    cache->count = old->count;
+
+	    _cairo_scaled_font_glyph_metrics_destroy (old);
+	    scaled_font->glyph_metrics = cache;
+	} else {
+	    for (i = 0; i < cache->size; i++)
+		cache->index[i] = GLYPH_METRICS_EMPTY;
+	    cache->count = 0;
+	}
+    }
+
+    i = _cairo_scaled_font_glyph_metrics_find (cache, index);
+    cache->index[i] = index;
+    cache->metrics[i] = *metrics;
+    cache->bbox[i] = *bbox;
+    cache->count++;
+}
+
+/**
+ * _cairo_scaled_glyph_lookup_metrics:
+ * @scaled_font: a #cairo_scaled_font_t
+ * @index: the glyph to look up
+ * @metrics: return location for the user space metrics of the glyph,
+ * or %NULL
+ * @bbox: return location for the device space bounds of the glyph,
+ * or %NULL
+ *
+ * Finds the metrics of a glyph, as _cairo_scaled_glyph_lookup() would
+ * for %CAIRO_SCALED_GLYPH_INFO_METRICS, but without taking up a slot in
+ * the glyph cache for glyphs that are not already there. This is meant
+ * for callers that only lay out text and do not go on to draw it.
+ *
+ * Note: as for _cairo_scaled_glyph_lookup(), this function must be
+ * called with the scaled font frozen.
+ *
+ * Returns: %CAIRO_INT_STATUS_SUCCESS, or an error as for
+ * _cairo_scaled_glyph_lookup().
+ **/
+cairo_int_status_t
+_cairo_scaled_glyph_lookup_metrics (cairo_scaled_font_t *scaled_font,
+				    unsigned long index,
+				    cairo_text_extents_t *metrics,
+				    cairo_box_t *bbox)
+{
+    cairo_scaled_font_glyph_metrics_t *cache;
+    cairo_scaled_glyph_t *scaled_glyph;
+    cairo_scaled_glyph_t glyph;
+    cairo_int_status_t status;
+
+    if (unlikely (scaled_font->status))
+	return scaled_font->status;
+
+    assert (CAIRO_MUTEX_IS_LOCKED(scaled_font->mutex));
+    assert (scaled_font->cache_frozen);
+
+    scaled_glyph = _cairo_hash_table_lookup (scaled_font->glyphs,
+					     (cairo_hash_entry_t *) &index);
+    if (scaled_glyph == NULL) {
+	cache = scaled_font->glyph_metrics;
+	if (cache != NULL) {
+	    unsigned int i = _cairo_scaled_font_glyph_metrics_find (cache, index);
+
+	    if (cache->index[i] == index) {
+		if (metrics)
+		    *metrics = cache->metrics[i];
+		if (bbox)
+		    *bbox = cache->bbox[i];
+		return CAIRO_INT_STATUS_SUCCESS;
+	    }
+	}
+    }
+
+    /* The glyph table may not hold the glyph index reserved to mark
+     * empty slots, nor can it add to a glyph already in the cache. */
+    if (scaled_glyph != NULL || index == GLYPH_METRICS_EMPTY) {
+	status = _cairo_scaled_glyph_lookup (scaled_font, index,
+					     CAIRO_SCALED_GLYPH_INFO_METRICS,
+					     &scaled_glyph);
+	if (unlikely (status))
+	    return status;
+
+	if (metrics)
+	    *metrics = scaled_glyph->metrics;
+	if (bbox)
+	    *bbox = scaled_glyph->bbox;
+	return CAIRO_INT_STATUS_SUCCESS;
+    }
+
+    if (CAIRO_INJECT_FAULT ())
+	return _cairo_scaled_font_set_error (scaled_font, CAIRO_STATUS_NO_MEMORY);
+
+    /* Ask the backend for the metrics of a glyph that lives only on
+     * the stack. */
+    memset (&glyph, 0, sizeof (cairo_scaled_glyph_t));
+    _cairo_scaled_glyph_set_key (scaled_font, &glyph, index);
+    cairo_list_init (&glyph.dev_privates);
+
+    status = scaled_font->backend->scaled_glyph_init (scaled_font, &glyph,
+						      CAIRO_SCALED_GLYPH_INFO_METRICS);
+    if (unlikely (status)) {
+	_cairo_scaled_glyph_fini (scaled_font, &glyph);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    status = _cairo_scaled_font_set_error (scaled_font, status);
+	return status;
+    }
+
+    if (metrics)
+	*metrics = glyph.metrics;
+    if (bbox)
+	*bbox = glyph.bbox;
+
+    /* Some backends, user fonts amongst them, have to do all the work
+     * of drawing the glyph to find its metrics. Rather than throw that
+     * away, such glyphs go into the glyph cache after all.
+     */
+    if (glyph.has_info == CAIRO_SCALED_GLYPH_INFO_METRICS &&
+	cairo_list_is_empty (&glyph.dev_privates))
+    {
+	_cairo_scaled_font_glyph_metrics_add (scaled_font, index,
+					      &glyph.metrics, &glyph.bbox);
+	return CAIRO_INT_STATUS_SUCCESS;
+    }
+
+    status = _cairo_scaled_font_allocate_glyph (scaled_font, &scaled_glyph);
+    if (unlikely (status)) {
+	_cairo_scaled_glyph_fini (scaled_font, &glyph);
+	return _cairo_scaled_font_set_error (scaled_font, status);
+    }
+
+    *scaled_glyph = glyph;
+    if (cairo_list_is_empty (&glyph.dev_privates))
+	cairo_list_init (&scaled_glyph->dev_privates);
+    else
+	cairo_list_swap (&scaled_glyph->dev_privates, &glyph.dev_privates);
+
+    status = _cairo_hash_table_insert (scaled_font->glyphs,
+				       &scaled_glyph->hash_entry);
+    if (unlikely (status)) {
+	_cairo_scaled_font_free_last_glyph (scaled_font, scaled_glyph);
+	return _cairo_scaled_font_set_error (scaled_font, status);
+    }
+
+    return CAIRO_INT_STATUS_SUCCESS;
+}
+
+/* Below this many glyphs there is too little work to be worth sharing. */
+#define PREFETCH_THRESHOLD 64
+
+#define _cairo_scaled_glyph_ptr_compare(a, b) (((a) > (b)) - ((a) < (b)))
+CAIRO_COMBSORT_DECLARE (_cairo_scaled_glyph_ptr_sort,
+			cairo_scaled_glyph_t *,
+			_cairo_scaled_glyph_ptr_compare)
+
+/**
+ * _cairo_scaled_font_prefetch_glyphs:
+ * @scaled_font: a #cairo_scaled_font_t
+ * @glyphs: the glyphs about to be used
+ * @num_glyphs: the number of glyphs
+ * @info: a #cairo_scaled_glyph_info_t marking which portions of
+ * the glyphs will be wanted.
+ *
+ * Gathers up every glyph in @glyphs lacking some of @info and hands
+ * them to the backend in a single batch, so that it may fill them in
+ * more efficiently than one at a time through _cairo_scaled_glyph_lookup().
+ * This is purely advisory; nothing is done for short runs of glyphs or
+ * if the backend has no means to load glyphs in bulk.
+ *
+ * Note: as for _cairo_scaled_glyph_lookup(), this function must be called
+ * with the scaled font frozen.
+ **/
+cairo_int_status_t
+_cairo_scaled_font_prefetch_glyphs (cairo_scaled_font_t *scaled_font,
+				    const cairo_glyph_t *glyphs,
+				    int			 num_glyphs,
+				    cairo_scaled_glyph_info_t info)
+{
+    cairo_scaled_glyph_t *stack_pending[CAIRO_STACK_ARRAY_LENGTH (cairo_scaled_glyph_t *)];
+    cairo_scaled_glyph_t **pending = stack_pending;
+    cairo_int_status_t status = CAIRO_INT_STATUS_SUCCESS;
+    int num_pending = 0, i, j;
+
+    if (unlikely (scaled_font->status))
+	return scaled_font->status;
+
+    if (scaled_font->backend->scaled_glyphs_init == NULL ||
+	num_glyphs < PREFETCH_THRESHOLD)
+	return CAIRO_INT_STATUS_SUCCESS;
+
+    assert (scaled_font->cache_frozen);
+
+    info |= CAIRO_SCALED_GLYPH_INFO_METRICS;
+
+    if (num_glyphs > ARRAY_LENGTH (stack_pending)) {
+	pending = _cairo_malloc_ab (num_glyphs, sizeof (cairo_scaled_glyph_t *));
+	if (unlikely (pending == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    for (i = 0; i < num_glyphs; i++) {
+	unsigned long index = glyphs[i].index;
+	cairo_scaled_glyph_t *scaled_glyph;
+
+	scaled_glyph = _cairo_hash_table_lookup (scaled_font->glyphs,
+						 (cairo_hash_entry_t *) &index);
+	if (scaled_glyph == NULL) {
+	    status = _cairo_scaled_font_allocate_glyph (scaled_font,
+							&scaled_glyph);
+	    if (unlikely (status))
+		goto BAIL;
+
+	    memset (scaled_glyph, 0, sizeof (cairo_scaled_glyph_t));
+	    _cairo_scaled_glyph_set_key (scaled_font, scaled_glyph, index);
+	    cairo_list_init (&scaled_glyph->dev_privates);
+
+	    /* Entering the glyph now means that later repeats find it */
+	    status = _cairo_hash_table_insert (scaled_font->glyphs,
+					       &scaled_glyph->hash_entry);
+	    if (unlikely (status)) {
+		_cairo_scaled_font_free_last_glyph (scaled_font, scaled_glyph);
+		goto BAIL;
+	    }
+	} else if ((info & ~scaled_glyph->has_info) == 0)
+	    continue;
+
+	pending[num_pending++] = scaled_glyph;
+    }
+
+    if (num_pending == 0)
+	goto BAIL;
+
+    /* Glyphs that were already present may have been listed repeatedly */
+    _cairo_scaled_glyph_ptr_sort (pending, num_pending);
+    for (i = j = 1; i < num_pending; i++) {
+	if (pending[i] != pending[j-1])
+	    pending[j++] = pending[i];
+    }
+    num_pending = j;
+
+    status = scaled_font->backend->scaled_glyphs_init (scaled_font,
+						       pending, num_pending,
+						       info);
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	/* The new glyphs are already in the cache, so must be completed
+	 * here, but may as well all be done now.
+	 */
+	for (i = 0; i < num_pending; i++) {
+	    cairo_scaled_glyph_t *scaled_glyph = pending[i];
+
+	    status = scaled_font->backend->scaled_glyph_init (scaled_font,
+							      scaled_glyph,
+							      info & ~scaled_glyph->has_info);
+	    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+		(scaled_glyph->has_info & CAIRO_SCALED_GLYPH_INFO_METRICS) == 0)
+	    {
+		status = scaled_font->backend->scaled_glyph_init (scaled_font,
+								  scaled_glyph,
+								  CAIRO_SCALED_GLYPH_INFO_METRICS);
+	    }
+	    if (status == CAIRO_INT_STATUS_UNSUPPORTED)
+		status = CAIRO_INT_STATUS_SUCCESS;
+	    if (unlikely (status))
+		break;
+	}
+    }
+
+BAIL:
+    if (pending != stack_pending)
+	free (pending);
+
+    if (unlikely (status))
+	status = _cairo_scaled_font_set_error (scaled_font, status);
+    return status;
+}
+
+/**
+ * cairo_scaled_font_prefetch_glyphs:
+ * @scaled_font: a #cairo_scaled_font_t
+ * @glyphs: an array of glyph IDs with X and Y offsets.
+ * @num_glyphs: the number of glyphs in the @glyphs array
+ *
+ * Loads and rasterizes any of @glyphs that are not yet in the glyph
+ * cache of @scaled_font, in anticipation of them being drawn. Where the
+ * font backend supports it, for instance for FreeType fonts loaded from
+ * a file, the work is shared out between several threads, which makes
+ * a large difference to the first rendering of a page of text using
+ * thousands of distinct glyphs.
+ *
+ * Calling this is never necessary; cairo loads glyphs as it needs
+ * them, and also prefetches the glyphs of long runs passed to
+ * cairo_show_glyphs(). Short runs of glyphs are left to be loaded as
+ * they are drawn. The glyph cache is limited in size, so prefetching
+ * more glyphs than will fit only wastes time.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_scaled_font_prefetch_glyphs (cairo_scaled_font_t	 *scaled_font,
+				   const cairo_glyph_t	 *glyphs,
+				   int			  num_glyphs)
+{
+    if (unlikely (scaled_font->status))
+	return;
+
+    if (glyphs == NULL || num_glyphs < PREFETCH_THRESHOLD ||
+	scaled_font->backend->scaled_glyphs_init == NULL)
+	return;
+
+    _cairo_scaled_font_freeze_cache (scaled_font);
+    (void) _cairo_scaled_font_prefetch_glyphs (scaled_font,
+					       glyphs, num_glyphs,
+					       CAIRO_SCALED_GLYPH_INFO_METRICS |
+					       CAIRO_SCALED_GLYPH_INFO_SURFACE);
+    _cairo_scaled_font_thaw_cache (scaled_font);
+}
+slim_hidden_def (cairo_scaled_font_prefetch_glyphs);
+
 double
 _cairo_scaled_font_get_max_scale (cairo_scaled_font_t *scaled_font)
 {
@@ -3156,3 +3876,500 @@ cairo_scaled_font_get_font_options (cairo_scaled_font_t		*scaled_font,
     _cairo_font_options_init_copy (options, &scaled_font->options);
 }
 slim_hidden_def (cairo_scaled_font_get_font_options);
+
+/* A glyph cache file holds the metrics and images of the glyphs of a
+ * scaled font, so that another process may start with them already
+ * cached. It starts with a header identifying the font, followed by
+ * the backend's key for the font file, a record for each glyph, and
+ * finally the glyph images, each aligned so that the file may be
+ * mapped into memory and its images used in place.
+ */
+#define GLYPH_CACHE_MAGIC "CAIROGC"
+#define GLYPH_CACHE_VERSION 1
+#define GLYPH_CACHE_BYTE_ORDER 0x01020304
+#define GLYPH_CACHE_ALIGN 16
+
+typedef struct _cairo_glyph_cache_header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    uint32_t key_length;
+    uint32_t num_glyphs;
+    double font_matrix[6];
+    double ctm[6];
+    int32_t options[7];
+    uint32_t reserved;
+} cairo_glyph_cache_header_t;
+
+typedef struct _cairo_glyph_cache_record {
+    uint32_t index;		/* including the subpixel phase */
+    int32_t format;		/* CAIRO_FORMAT_INVALID for metrics only */
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    uint32_t offset;		/* of the image from the start of the file */
+    double x0, y0;		/* device offset of the image */
+    double metrics[6];		/* font-space metrics */
+} cairo_glyph_cache_record_t;
+
+typedef struct _cairo_glyph_cache_mapping {
+    cairo_destroy_func_t destroy;
+    void *closure;
+    int num_surfaces;
+    cairo_surface_t *surfaces[1];
+} cairo_glyph_cache_mapping_t;
+
+#define GLYPH_CACHE_RECORDS_OFFSET(key_length) \
+    ((sizeof (cairo_glyph_cache_header_t) + (key_length) + 7) & -8)
+
+static void
+_cairo_glyph_cache_header_init (cairo_glyph_cache_header_t *header,
+				cairo_scaled_font_t *scaled_font,
+				unsigned int key_length)
+{
+    const cairo_font_options_t *options = &scaled_font->options;
+
+    memset (header, 0, sizeof (cairo_glyph_cache_header_t));
+    memcpy (header->magic, GLYPH_CACHE_MAGIC, sizeof (GLYPH_CACHE_MAGIC));
+    header->byte_order = GLYPH_CACHE_BYTE_ORDER;
+    header->version = GLYPH_CACHE_VERSION;
+    header->key_length = key_length;
+
+    header->font_matrix[0] = scaled_font->font_matrix.xx;
+    header->font_matrix[1] = scaled_font->font_matrix.yx;
+    header->font_matrix[2] = scaled_font->font_matrix.xy;
+    header->font_matrix[3] = scaled_font->font_matrix.yy;
+    header->font_matrix[4] = scaled_font->font_matrix.x0;
+    header->font_matrix[5] = scaled_font->font_matrix.y0;
+
+    header->ctm[0] = scaled_font->ctm.xx;
+    header->ctm[1] = scaled_font->ctm.yx;
+    header->ctm[2] = scaled_font->ctm.xy;
+    header->ctm[3] = scaled_font->ctm.yy;
+    header->ctm[4] = scaled_font->ctm.x0;
+    header->ctm[5] = scaled_font->ctm.y0;
+
+    header->options[0] = options->antialias;
+    header->options[1] = options->subpixel_order;
+    header->options[2] = options->lcd_filter;
+    header->options[3] = options->hint_style;
+    header->options[4] = options->hint_metrics;
+    header->options[5] = options->round_glyph_positions;
+    header->options[6] = options->subpixel_phases;
+}
+
+static cairo_bool_t
+_cairo_glyph_cache_format_supported (cairo_format_t format)
+{
+    return format == CAIRO_FORMAT_A1 ||
+	   format == CAIRO_FORMAT_A8 ||
+	   format == CAIRO_FORMAT_ARGB32;
+}
+
+/* The image of @scaled_glyph to store, if any. */
+static cairo_image_surface_t *
+_cairo_glyph_cache_image (cairo_scaled_glyph_t *scaled_glyph)
+{
+    cairo_image_surface_t *image = scaled_glyph->surface;
+
+    if ((scaled_glyph->has_info & CAIRO_SCALED_GLYPH_INFO_SURFACE) == 0 ||
+	image == NULL || image->base.status ||
+	! _cairo_glyph_cache_format_supported (image->format))
+	return NULL;
+
+    return image;
+}
+
+static cairo_bool_t
+_cairo_glyph_cache_glyph_stored (cairo_scaled_glyph_t *scaled_glyph)
+{
+    return (scaled_glyph->has_info & CAIRO_SCALED_GLYPH_INFO_METRICS) &&
+	   _cairo_scaled_glyph_key (scaled_glyph) <= 0xffffffff;
+}
+
+static cairo_status_t
+_cairo_glyph_cache_write_padding (cairo_write_func_t  write_func,
+				  void		     *closure,
+				  unsigned long	     *offset,
+				  unsigned int	      align)
+{
+    static const unsigned char zero[GLYPH_CACHE_ALIGN];
+    unsigned int n = -*offset & (align - 1);
+
+    if (n == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    *offset += n;
+    return write_func (closure, zero, n);
+}
+
+/**
+ * _cairo_scaled_font_write_glyph_cache:
+ * @scaled_font: a #cairo_scaled_font_t
+ * @key: the backend's identification of the font file
+ * @key_length: the size of @key in bytes
+ * @write_func: a #cairo_write_func_t to accept the data
+ * @closure: the closure argument for @write_func
+ *
+ * Writes the metrics and images of every glyph currently cached by
+ * @scaled_font, for _cairo_scaled_font_load_glyph_cache() to reload.
+ **/
+cairo_status_t
+_cairo_scaled_font_write_glyph_cache (cairo_scaled_font_t *scaled_font,
+				      const void	  *key,
+				      unsigned int	   key_length,
+				      cairo_write_func_t   write_func,
+				      void		  *closure)
+{
+    cairo_glyph_cache_header_t header;
+    cairo_glyph_cache_record_t *records = NULL;
+    cairo_scaled_glyph_page_t *page;
+    cairo_status_t status;
+    unsigned long offset;
+    int num_glyphs, i, n;
+
+    if (unlikely (scaled_font->status))
+	return scaled_font->status;
+
+    _cairo_scaled_font_freeze_cache (scaled_font);
+
+    num_glyphs = 0;
+    cairo_list_foreach_entry (page, cairo_scaled_glyph_page_t,
+			      &scaled_font->glyph_pages, link)
+    {
+	num_glyphs += page->num_glyphs;
+    }
+
+    if (num_glyphs) {
+	records = _cairo_malloc_ab (num_glyphs,
+				    sizeof (cairo_glyph_cache_record_t));
+	if (unlikely (records == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto BAIL;
+	}
+    }
+
+    /* lay out the file */
+    offset = GLYPH_CACHE_RECORDS_OFFSET (key_length) +
+	     num_glyphs * sizeof (cairo_glyph_cache_record_t);
+    n = 0;
+    cairo_list_foreach_entry (page, cairo_scaled_glyph_page_t,
+			      &scaled_font->glyph_pages, link)
+    {
+	for (i = 0; i < page->num_glyphs; i++) {
+	    cairo_scaled_glyph_t *scaled_glyph = &page->glyphs[i];
+	    cairo_glyph_cache_record_t *record;
+	    cairo_image_surface_t *image;
+
+	    if (! _cairo_glyph_cache_glyph_stored (scaled_glyph))
+		continue;
+
+	    record = &records[n++];
+	    memset (record, 0, sizeof (cairo_glyph_cache_record_t));
+	    record->index = _cairo_scaled_glyph_key (scaled_glyph);
+	    record->format = CAIRO_FORMAT_INVALID;
+	    record->metrics[0] = scaled_glyph->fs_metrics.x_bearing;
+	    record->metrics[1] = scaled_glyph->fs_metrics.y_bearing;
+	    record->metrics[2] = scaled_glyph->fs_metrics.width;
+	    record->metrics[3] = scaled_glyph->fs_metrics.height;
+	    record->metrics[4] = scaled_glyph->fs_metrics.x_advance;
+	    record->metrics[5] = scaled_glyph->fs_metrics.y_advance;
+
+	    image = _cairo_glyph_cache_image (scaled_glyph);
+	    if (image == NULL)
+		continue;
+
+	    offset = (offset + GLYPH_CACHE_ALIGN - 1) & -GLYPH_CACHE_ALIGN;
+	    record->format = image->format;
+	    record->width = image->width;
+	    record->height = image->height;
+	    record->stride = cairo_format_stride_for_width (image->format, image->width);
+	    record->offset = offset;
+	    record->x0 = image->base.device_transform.x0;
+	    record->y0 = image->base.device_transform.y0;
+	    offset += record->stride * record->height;
+	}
+    }
+
+    if (offset > 0xffffffff) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto BAIL;
+    }
+
+    _cairo_glyph_cache_header_init (&header, scaled_font, key_length);
+    header.num_glyphs = n;
+
+    offset = 0;
+    status = write_func (closure, (unsigned char *) &header, sizeof (header));
+    if (unlikely (status))
+	goto BAIL;
+    offset += sizeof (header);
+
+    status = write_func (closure, (const unsigned char *) key, key_length);
+    if (unlikely (status))
+	goto BAIL;
+    offset += key_length;
+
+    status = _cairo_glyph_cache_write_padding (write_func, closure, &offset, 8);
+    if (unlikely (status))
+	goto BAIL;
+
+    if (n) {
+	status = write_func (closure, (unsigned char *) records,
+			     n * sizeof (cairo_glyph_cache_record_t));
+	if (unlikely (status))
+	    goto BAIL;
+	offset += n * sizeof (cairo_glyph_cache_record_t);
+    }
+
+    /* and then the images, visiting the glyphs in the same order */
+    n = 0;
+    cairo_list_foreach_entry (page, cairo_scaled_glyph_page_t,
+			      &scaled_font->glyph_pages, link)
+    {
+	for (i = 0; i < page->num_glyphs; i++) {
+	    cairo_scaled_glyph_t *scaled_glyph = &page->glyphs[i];
+	    cairo_glyph_cache_record_t *record;
+	    cairo_image_surface_t *image;
+	    const unsigned char *row;
+	    int y;
+
+	    if (! _cairo_glyph_cache_glyph_stored (scaled_glyph))
+		continue;
+
+	    record = &records[n++];
+	    image = _cairo_glyph_cache_image (scaled_glyph);
+	    if (image == NULL)
+		continue;
+
+	    status = _cairo_glyph_cache_write_padding (write_func, closure,
+						       &offset,
+						       GLYPH_CACHE_ALIGN);
+	    if (unlikely (status))
+		goto BAIL;
+	    assert (offset == record->offset);
+
+	    row = image->data;
+	    for (y = 0; y < image->height; y++) {
+		status = write_func (closure, row, record->stride);
+		if (unlikely (status))
+		    goto BAIL;
+		row += image->stride;
+	    }
+	    offset += record->stride * record->height;
+	}
+    }
+
+BAIL:
+    _cairo_scaled_font_thaw_cache (scaled_font);
+    free (records);
+    return status;
+}
+
+static void
+_cairo_glyph_cache_mapping_destroy (void *data)
+{
+    cairo_glyph_cache_mapping_t *mapping = data;
+    int i;
+
+    /* Nothing may read the images once the data has gone. */
+    for (i = 0; i < mapping->num_surfaces; i++) {
+	cairo_surface_finish (mapping->surfaces[i]);
+	cairo_surface_destroy (mapping->surfaces[i]);
+    }
+
+    if (mapping->destroy)
+	mapping->destroy (mapping->closure);
+
+    free (mapping);
+}
+
+static cairo_bool_t
+_cairo_glyph_cache_record_valid (const cairo_glyph_cache_record_t *record,
+				 unsigned long length)
+{
+    unsigned long size;
+    int i;
+
+    /* garbage here would poison the extents of everything drawn */
+    for (i = 0; i < ARRAY_LENGTH (record->metrics); i++) {
+	if (! ISFINITE (record->metrics[i]))
+	    return FALSE;
+    }
+
+    if (record->format == CAIRO_FORMAT_INVALID)
+	return TRUE;
+
+    /* and the images are placed by rounding their offsets to integers */
+    if (! ISFINITE (record->x0) || fabs (record->x0) > 65536. ||
+	! ISFINITE (record->y0) || fabs (record->y0) > 65536.)
+	return FALSE;
+
+    if (! _cairo_glyph_cache_format_supported (record->format) ||
+	record->width < 0 || record->width > 32767 ||
+	record->height < 0 || record->height > 32767 ||
+	record->stride != cairo_format_stride_for_width (record->format,
+						  record->width) ||
+	record->offset & 3)
+	return FALSE;
+
+    size = (unsigned long) record->stride * record->height;
+    return record->offset <= length && size <= length - record->offset;
+}
+
+/**
+ * _cairo_scaled_font_load_glyph_cache:
+ * @scaled_font: a #cairo_scaled_font_t
+ * @key: the backend's identification of the font file
+ * @key_length: the size of @key in bytes
+ * @data: the contents of a glyph cache file
+ * @length: the size of @data in bytes
+ * @destroy: called with @closure once @data is no longer needed
+ * @closure: the argument for @destroy
+ *
+ * Adds the glyphs stored in @data by _cairo_scaled_font_write_glyph_cache()
+ * to the cache of @scaled_font. The glyph images are used in place,
+ * so @data must stay valid until @destroy is called.
+ *
+ * Return value: %CAIRO_STATUS_FONT_TYPE_MISMATCH if @data was written
+ * for a different font or with different settings, or
+ * %CAIRO_STATUS_READ_ERROR if it is malformed, in which case nothing
+ * is loaded and @destroy is not called. Otherwise @destroy will be
+ * called, even if an error is returned.
+ **/
+cairo_status_t
+_cairo_scaled_font_load_glyph_cache (cairo_scaled_font_t  *scaled_font,
+				     const void		  *key,
+				     unsigned int	   key_length,
+				     const unsigned char  *data,
+				     unsigned long	   length,
+				     cairo_destroy_func_t  destroy,
+				     void		  *closure)
+{
+    cairo_glyph_cache_header_t header, expected;
+    cairo_glyph_cache_mapping_t *mapping;
+    cairo_glyph_cache_record_t record;
+    cairo_status_t status;
+    unsigned long records;
+    unsigned int i;
+
+    if (unlikely (scaled_font->status))
+	return scaled_font->status;
+
+    /* pixman requires the rows of an image to be 32-bit aligned */
+    if (length < sizeof (header) || ((uintptr_t) data & 3))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    memcpy (&header, data, sizeof (header));
+    if (memcmp (header.magic, GLYPH_CACHE_MAGIC, sizeof (GLYPH_CACHE_MAGIC)) ||
+	header.byte_order != GLYPH_CACHE_BYTE_ORDER ||
+	header.version != GLYPH_CACHE_VERSION)
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    _cairo_glyph_cache_header_init (&expected, scaled_font, key_length);
+    expected.num_glyphs = header.num_glyphs;
+    if (memcmp (&header, &expected, sizeof (header)) ||
+	length < sizeof (header) + key_length ||
+	memcmp (data + sizeof (header), key, key_length))
+	return _cairo_error (CAIRO_STATUS_FONT_TYPE_MISMATCH);
+
+    records = GLYPH_CACHE_RECORDS_OFFSET (key_length);
+    if (records > length ||
+	header.num_glyphs > (length - records) / sizeof (record))
+	return _cairo_error (CAIRO_STATUS_READ_ERROR);
+
+    for (i = 0; i < header.num_glyphs; i++) {
+	memcpy (&record, data + records + i * sizeof (record), sizeof (record));
+	if (! _cairo_glyph_cache_record_valid (&record, length))
+	    return _cairo_error (CAIRO_STATUS_READ_ERROR);
+    }
+
+    /* From here on the font owns the data. */
+    mapping = _cairo_malloc_ab_plus_c (header.num_glyphs,
+				       sizeof (cairo_surface_t *),
+				       sizeof (cairo_glyph_cache_mapping_t));
+    if (unlikely (mapping == NULL)) {
+	if (destroy)
+	    destroy (closure);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    mapping->destroy = destroy;
+    mapping->closure = closure;
+    mapping->num_surfaces = 0;
+
+    /* each mapping is its own key, so that several may be loaded */
+    status = _cairo_user_data_array_set_data (&scaled_font->user_data,
+					      (cairo_user_data_key_t *) mapping,
+					      mapping,
+					      _cairo_glyph_cache_mapping_destroy);
+    if (unlikely (status)) {
+	_cairo_glyph_cache_mapping_destroy (mapping);
+	return status;
+    }
+
+    _cairo_scaled_font_freeze_cache (scaled_font);
+
+    for (i = 0; i < header.num_glyphs; i++) {
+	cairo_scaled_glyph_t *scaled_glyph;
+	cairo_text_extents_t fs_metrics;
+	cairo_surface_t *surface = NULL;
+	cairo_hash_entry_t entry;
+
+	memcpy (&record, data + records + i * sizeof (record), sizeof (record));
+
+	entry.hash = record.index;
+	if (_cairo_hash_table_lookup (scaled_font->glyphs, &entry))
+	    continue;
+
+	if (record.format != CAIRO_FORMAT_INVALID) {
+	    surface = cairo_image_surface_create_for_data ((unsigned char *) data + record.offset,
+							   record.format,
+							   record.width,
+							   record.height,
+							   record.stride);
+	    status = surface->status;
+	    if (unlikely (status)) {
+		cairo_surface_destroy (surface);
+		break;
+	    }
+
+	    cairo_surface_set_device_offset (surface, record.x0, record.y0);
+	    mapping->surfaces[mapping->num_surfaces++] = surface;
+	}
+
+	status = _cairo_scaled_font_allocate_glyph (scaled_font, &scaled_glyph);
+	if (unlikely (status))
+	    break;
+
+	memset (scaled_glyph, 0, sizeof (cairo_scaled_glyph_t));
+	_cairo_scaled_glyph_set_key (scaled_font, scaled_glyph, record.index);
+	cairo_list_init (&scaled_glyph->dev_privates);
+
+	fs_metrics.x_bearing = record.metrics[0];
+	fs_metrics.y_bearing = record.metrics[1];
+	fs_metrics.width = record.metrics[2];
+	fs_metrics.height = record.metrics[3];
+	fs_metrics.x_advance = record.metrics[4];
+	fs_metrics.y_advance = record.metrics[5];
+	_cairo_scaled_glyph_set_metrics (scaled_glyph, scaled_font, &fs_metrics);
+
+	/* used in place, rather than moved into the glyph atlas */
+	if (surface != NULL) {
+	    scaled_glyph->surface = (cairo_image_surface_t *)
+		cairo_surface_reference (surface);
+	    scaled_glyph->has_info |= CAIRO_SCALED_GLYPH_INFO_SURFACE;
+	}
+
+	status = _cairo_hash_table_insert (scaled_font->glyphs,
+					   &scaled_glyph->hash_entry);
+	if (unlikely (status)) {
+	    _cairo_scaled_font_free_last_glyph (scaled_font, scaled_glyph);
+	    break;
+	}
+    }
+
+    _cairo_scaled_font_thaw_cache (scaled_font);
+
+    return status;
+}
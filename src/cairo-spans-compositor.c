@@ -713,12 +713,14 @@ composite_boxes (const cairo_spans_compositor_t *compositor,
     cairo_abstract_span_renderer_t renderer;
     cairo_rectangular_scan_converter_t converter;
     const struct _cairo_boxes_chunk *chunk;
+    cairo_bool_t needs_clip;
     cairo_int_status_t status;
     cairo_box_t box;
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
     _cairo_box_from_rectangle (&box, &extents->unbounded);
-    if (composite_needs_clip (extents, &box)) {
+    needs_clip = composite_needs_clip (extents, &box);
+    if (needs_clip && ! extents->is_bounded) {
 	TRACE ((stderr, "%s: unsupported clip\n", __FUNCTION__));
 	return CAIRO_INT_STATUS_UNSUPPORTED;
     }
@@ -736,7 +738,7 @@ composite_boxes (const cairo_spans_compositor_t *compositor,
     }
 
     status = compositor->renderer_init (&renderer, extents,
-					CAIRO_ANTIALIAS_DEFAULT, FALSE);
+					CAIRO_ANTIALIAS_DEFAULT, needs_clip);
     if (likely (status == CAIRO_INT_STATUS_SUCCESS))
 	status = converter.base.generate (&converter.base, &renderer.base);
     compositor->renderer_fini (&renderer, status);
@@ -746,6 +748,38 @@ cleanup_converter:
     return status;
 }
 
+static cairo_int_status_t
+composite_ellipse (const cairo_spans_compositor_t	*compositor,
+		   cairo_composite_rectangles_t		*extents,
+		   const cairo_ellipse_double_t		*ellipse,
+		   cairo_antialias_t			 antialias)
+{
+    cairo_abstract_span_renderer_t renderer;
+    cairo_ellipse_scan_converter_t converter;
+    cairo_bool_t needs_clip;
+    cairo_int_status_t status;
+    cairo_box_t box;
+
+    TRACE ((stderr, "%s\n", __FUNCTION__));
+    _cairo_box_from_rectangle (&box, &extents->unbounded);
+    needs_clip = composite_needs_clip (extents, &box);
+    if (needs_clip && ! extents->is_bounded) {
+	TRACE ((stderr, "%s: unsupported clip\n", __FUNCTION__));
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    _cairo_ellipse_scan_converter_init (&converter, &extents->unbounded, ellipse);
+
+    status = compositor->renderer_init (&renderer, extents,
+					antialias, needs_clip);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter.base.generate (&converter.base, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+    converter.base.destroy (&converter.base);
+    return status;
+}
+
 static cairo_int_status_t
 composite_polygon (const cairo_spans_compositor_t	*compositor,
 		   cairo_composite_rectangles_t		 *extents,
@@ -763,7 +797,10 @@ composite_polygon (const cairo_spans_compositor_t	*compositor,
     else
 	needs_clip = !_clip_is_region (extents->clip) || extents->clip->num_boxes > 1;
     TRACE ((stderr, "%s - needs_clip=%d\n", __FUNCTION__, needs_clip));
-    if (needs_clip) {
+    /* A bounded operation is clipped by the renderer, which multiplies the
+     * coverage of the clip into that of the shape.
+     */
+    if (needs_clip && ! extents->is_bounded) {
 	TRACE ((stderr, "%s: unsupported clip\n", __FUNCTION__));
 	return CAIRO_INT_STATUS_UNSUPPORTED;
 	converter = _cairo_clip_tor_scan_converter_create (extents->clip,
@@ -778,6 +815,13 @@ composite_polygon (const cairo_spans_compositor_t	*compositor,
 							    r->y + r->height,
 							    fill_rule, antialias);
 	    status = _cairo_tor22_scan_converter_add_polygon (converter, polygon);
+	} else if (antialias == CAIRO_ANTIALIAS_GOOD ||
+		   antialias == CAIRO_ANTIALIAS_BEST) {
+	    converter = _cairo_area_scan_converter_create (r->x, r->y,
+							   r->x + r->width,
+							   r->y + r->height,
+							   fill_rule);
+	    status = _cairo_area_scan_converter_add_polygon (converter, polygon);
 	} else if (antialias == CAIRO_ANTIALIAS_NONE) {
 	    converter = _cairo_mono_scan_converter_create (r->x, r->y,
 							   r->x + r->width,
@@ -1125,6 +1169,16 @@ _cairo_spans_compositor_fill (const cairo_compositor_t		*_compositor,
 	if (likely (status == CAIRO_INT_STATUS_SUCCESS))
 	    status = clip_and_composite_boxes (compositor, extents, &boxes);
 	_cairo_boxes_fini (&boxes);
+    } else if (antialias != CAIRO_ANTIALIAS_NONE) {
+	cairo_ellipse_double_t ellipse;
+
+	/* Full circles, as drawn for dots and markers, are rendered with
+	 * exact coverage instead of tessellating their flattened outline.
+	 */
+	if (_cairo_path_fixed_is_ellipse (path, tolerance, &ellipse)) {
+	    TRACE((stderr, "%s - ellipse\n", __FUNCTION__));
+	    status = composite_ellipse (compositor, extents, &ellipse, antialias);
+	}
     }
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	cairo_polygon_t polygon;
@@ -105,6 +105,16 @@ cairo_private cairo_status_t
 _cairo_tor22_scan_converter_add_polygon (void		*converter,
 					 const cairo_polygon_t *polygon);
 
+cairo_private cairo_scan_converter_t *
+_cairo_area_scan_converter_create (int			xmin,
+				   int			ymin,
+				   int			xmax,
+				   int			ymax,
+				   cairo_fill_rule_t	fill_rule);
+cairo_private cairo_status_t
+_cairo_area_scan_converter_add_polygon (void		*converter,
+					const cairo_polygon_t *polygon);
+
 cairo_private cairo_scan_converter_t *
 _cairo_mono_scan_converter_create (int			xmin,
 				   int			ymin,
@@ -145,6 +155,18 @@ _cairo_rectangular_scan_converter_add_box (cairo_rectangular_scan_converter_t *s
 					   const cairo_box_t *box,
 					   int dir);
 
+typedef struct _cairo_ellipse_scan_converter {
+    cairo_scan_converter_t base;
+
+    cairo_rectangle_int_t extents;
+    cairo_ellipse_double_t ellipse;
+} cairo_ellipse_scan_converter_t;
+
+cairo_private void
+_cairo_ellipse_scan_converter_init (cairo_ellipse_scan_converter_t *self,
+				    const cairo_rectangle_int_t *extents,
+				    const cairo_ellipse_double_t *ellipse);
+
 typedef struct _cairo_botor_scan_converter {
     cairo_scan_converter_t base;
 
@@ -53,6 +53,7 @@ typedef struct _cairo_stroker_dash {
     double dash_offset;
     const double *dashes;
     unsigned int num_dashes;
+    double dash_period;
 } cairo_stroker_dash_t;
 
 cairo_private void
@@ -65,6 +66,9 @@ _cairo_stroker_dash_start (cairo_stroker_dash_t *dash);
 cairo_private void
 _cairo_stroker_dash_step (cairo_stroker_dash_t *dash, double step);
 
+cairo_private double
+_cairo_stroker_dash_seek (cairo_stroker_dash_t *dash, double distance);
+
 CAIRO_END_DECLS
 
 #endif /* CAIRO_STROKE_DASH_PRIVATE_H */
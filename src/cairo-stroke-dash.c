@@ -80,6 +80,53 @@ _cairo_stroker_dash_step (cairo_stroker_dash_t *dash, double step)
     }
 }
 
+/* Advance the pattern to the start of the dash containing the position
+ * @distance further along, jumping over whole periods of the pattern at
+ * once rather than stepping through every dash. Returns the distance
+ * actually advanced, which is 0 if that position lies within the current
+ * dash.
+ */
+double
+_cairo_stroker_dash_seek (cairo_stroker_dash_t *dash, double distance)
+{
+    double skipped;
+    unsigned int i;
+    cairo_bool_t on;
+
+    if (distance < dash->dash_remain || dash->dash_period <= 0.)
+	return 0.;
+
+    skipped = dash->dash_remain;
+    distance -= skipped;
+
+    on = ! dash->dash_on;
+    i = dash->dash_index + 1;
+    if (i == dash->num_dashes)
+	i = 0;
+
+    if (distance >= dash->dash_period) {
+	double periods = floor (distance / dash->dash_period);
+
+	skipped += periods * dash->dash_period;
+	distance -= periods * dash->dash_period;
+    }
+
+    while (distance >= dash->dashes[i]) {
+	skipped += dash->dashes[i];
+	distance -= dash->dashes[i];
+
+	on = ! on;
+	if (++i == dash->num_dashes)
+	    i = 0;
+    }
+
+    dash->dash_index = i;
+    dash->dash_on = on;
+    dash->dash_remain = dash->dashes[i];
+
+    return skipped;
+}
+
 void
 _cairo_stroker_dash_init (cairo_stroker_dash_t *dash,
 			  const cairo_stroke_style_t *style)
@@ -92,5 +139,7 @@ _cairo_stroker_dash_init (cairo_stroker_dash_t *dash,
     dash->num_dashes = style->num_dashes;
     dash->dash_offset = style->dash_offset;
 
+    dash->dash_period = _cairo_stroke_style_dash_period (style);
+
     _cairo_stroker_dash_start (dash);
 }
@@ -67,6 +67,7 @@ struct pattern {
 
 struct path {
     unsigned int type[5]; /* empty/pixel/rectilinear/straight/curved */
+    unsigned int culled; /* subpaths lying wholly outside the extents */
 };
 
 struct clip {
@@ -232,6 +232,26 @@ add_path (struct path *stats,
     stats->type[classify_path(path, is_fill)]++;
 }
 
+static unsigned int
+count_culled (const cairo_path_fixed_t *path,
+	      const cairo_composite_rectangles_t *extents,
+	      double dx, double dy)
+{
+    cairo_box_t box;
+    cairo_fixed_t fdx, fdy;
+
+    fdx = _cairo_fixed_from_double (dx);
+    fdy = _cairo_fixed_from_double (dy);
+
+    _cairo_box_from_rectangle (&box, &extents->unbounded);
+    box.p1.x -= fdx;
+    box.p2.x += fdx;
+    box.p1.y -= fdy;
+    box.p2.y += fdy;
+
+    return _cairo_path_fixed_count_culled (path, &box);
+}
+
 static int
 classify_clip (const cairo_clip_t *clip)
 {
@@ -903,6 +923,7 @@ _cairo_surface_observer_fill (void			*abstract_surface,
     cairo_composite_rectangles_t composite;
     cairo_int_status_t status;
     cairo_time_t t;
+    unsigned int culled;
     int x, y;
 
     surface->log.fill.count++;
@@ -935,6 +956,10 @@ _cairo_surface_observer_fill (void			*abstract_surface,
 
     add_extents (&surface->log.fill.extents, &composite);
     add_extents (&device->log.fill.extents, &composite);
+
+    culled = count_culled (path, &composite, 0, 0);
+    surface->log.fill.path.culled += culled;
+    device->log.fill.path.culled += culled;
     _cairo_composite_rectangles_fini (&composite);
 
     t = _cairo_time_get ();
@@ -1018,6 +1043,8 @@ _cairo_surface_observer_stroke (void				*abstract_surface,
     cairo_composite_rectangles_t composite;
     cairo_int_status_t status;
     cairo_time_t t;
+    unsigned int culled;
+    double dx, dy;
     int x, y;
 
     surface->log.stroke.count++;
@@ -1053,6 +1080,11 @@ _cairo_surface_observer_stroke (void				*abstract_surface,
 
     add_extents (&surface->log.stroke.extents, &composite);
     add_extents (&device->log.stroke.extents, &composite);
+
+    _cairo_stroke_style_max_distance_from_path (style, path, ctm, &dx, &dy);
+    culled = count_culled (path, &composite, dx, dy);
+    surface->log.stroke.path.culled += culled;
+    device->log.stroke.path.culled += culled;
     _cairo_composite_rectangles_fini (&composite);
 
     t = _cairo_time_get ();
@@ -1727,6 +1759,8 @@ print_path (cairo_output_stream_t *stream,
 {
     _cairo_output_stream_printf (stream, "  path:");
     print_array (stream, p->type, path_names, ARRAY_LENGTH (path_names));
+    if (p->culled)
+	_cairo_output_stream_printf (stream, " [culled subpaths %u]", p->culled);
     _cairo_output_stream_printf (stream, "\n");
 }
 
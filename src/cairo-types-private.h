@@ -74,6 +74,7 @@ typedef struct _cairo_gstate_backend cairo_gstate_backend_t;
 typedef struct _cairo_glyph_text_info cairo_glyph_text_info_t;
 typedef struct _cairo_hash_entry cairo_hash_entry_t;
 typedef struct _cairo_hash_table cairo_hash_table_t;
+typedef struct _cairo_image_glyph_shelf cairo_image_glyph_shelf_t;
 typedef struct _cairo_image_surface cairo_image_surface_t;
 typedef struct _cairo_mime_data cairo_mime_data_t;
 typedef struct _cairo_observer cairo_observer_t;
@@ -194,6 +195,7 @@ struct _cairo_font_options {
     cairo_hint_style_t hint_style;
     cairo_hint_metrics_t hint_metrics;
     cairo_round_glyph_positions_t round_glyph_positions;
+    int subpixel_phases;
 };
 
 struct _cairo_glyph_text_info {
@@ -277,6 +279,11 @@ typedef struct _cairo_circle_double {
     double               radius;
 } cairo_circle_double_t;
 
+typedef struct _cairo_ellipse_double {
+    cairo_point_double_t center;
+    double               rx, ry;
+} cairo_ellipse_double_t;
+
 typedef struct _cairo_distance_double {
     double dx;
     double dy;
@@ -39,6 +39,7 @@
 #include "cairo-recording-surface-private.h"
 #include "cairo-analysis-surface-private.h"
 #include "cairo-error-private.h"
+#include "cairo-hash-private.h"
 
 /**
  * SECTION:cairo-user-fonts
@@ -76,9 +77,25 @@ typedef struct _cairo_user_font_face {
      * the scaled_font_methods cannot change anymore. */
     cairo_bool_t		     immutable;
 
+    /* Set if the glyphs are drawn the same at every size, in which case
+     * their recordings are shared by all the scaled fonts of the face. */
+    cairo_bool_t		     scalable;
+    cairo_mutex_t		     mutex;
+    cairo_hash_table_t		    *glyph_recordings;
+
     cairo_user_scaled_font_methods_t scaled_font_methods;
 } cairo_user_font_face_t;
 
+typedef struct _cairo_user_glyph_recording {
+    cairo_hash_entry_t   base;
+
+    unsigned long        index;
+    cairo_content_t      content;
+
+    cairo_surface_t     *recording_surface; /* in font space */
+    cairo_text_extents_t extents;	    /* as set by render_glyph */
+} cairo_user_glyph_recording_t;
+
 typedef struct _cairo_user_scaled_font {
     cairo_scaled_font_t  base;
 
@@ -132,6 +149,151 @@ _cairo_user_scaled_font_create_recording_context (const cairo_user_scaled_font_t
     return cr;
 }
 
+/* #cairo_user_glyph_recording_t */
+
+static cairo_bool_t
+_cairo_user_glyph_recording_equal (const void *key_a, const void *key_b)
+{
+    const cairo_user_glyph_recording_t *a = key_a;
+    const cairo_user_glyph_recording_t *b = key_b;
+
+    return a->index == b->index && a->content == b->content;
+}
+
+static void
+_cairo_user_glyph_recording_init_key (cairo_user_glyph_recording_t *key,
+				      unsigned long                  index,
+				      cairo_content_t                content)
+{
+    key->base.hash = index ^ ((unsigned long) content << 24);
+    key->index = index;
+    key->content = content;
+}
+
+static void
+_cairo_user_glyph_recording_pluck (void *entry, void *closure)
+{
+    cairo_user_glyph_recording_t *recording = entry;
+
+    _cairo_hash_table_remove (closure, &recording->base);
+    cairo_surface_destroy (recording->recording_surface);
+    free (recording);
+}
+
+/* The scale at which the glyphs of scalable user fonts are recorded.
+ * Recording surfaces store paths in fixed point, so a glyph recorded at
+ * 1 unit to the em would lose everything finer than 1/256 em, which is
+ * most of a pixel once replayed at a large size.
+ */
+#define SHARED_GLYPH_SCALE 1024.
+
+/* Draws a glyph of a scalable user font into @recording_surface, at the
+ * size and transformation of @scaled_font. The glyph is only drawn by
+ * the user once, in font space, and that recording is replayed for
+ * each scaled font that wants it afterwards.
+ */
+static cairo_int_status_t
+_cairo_user_scaled_font_replay_shared_glyph (cairo_user_scaled_font_t *scaled_font,
+					     unsigned long             index,
+					     cairo_surface_t          *recording_surface,
+					     cairo_text_extents_t     *extents)
+{
+    cairo_user_font_face_t *face =
+	(cairo_user_font_face_t *) scaled_font->base.font_face;
+    cairo_user_glyph_recording_t key, *recording, *other;
+    cairo_int_status_t status;
+    cairo_surface_t *glyph;
+    cairo_matrix_t scale, shared_scale;
+
+    _cairo_user_glyph_recording_init_key (&key, index,
+					  recording_surface->content);
+
+    CAIRO_MUTEX_LOCK (face->mutex);
+    recording = _cairo_hash_table_lookup (face->glyph_recordings, &key.base);
+    if (recording != NULL) {
+	glyph = cairo_surface_reference (recording->recording_surface);
+	*extents = recording->extents;
+    }
+    CAIRO_MUTEX_UNLOCK (face->mutex);
+
+    if (recording == NULL) {
+	cairo_t *cr;
+
+	/* The face is not locked whilst the user draws the glyph, so
+	 * that they may use other fonts, or this one, to do so. */
+	glyph = cairo_recording_surface_create (recording_surface->content,
+						NULL);
+	cr = cairo_create (glyph);
+	cairo_scale (cr, SHARED_GLYPH_SCALE, SHARED_GLYPH_SCALE);
+	cairo_set_font_size (cr, 1.0);
+	cairo_set_font_options (cr, &scaled_font->base.options);
+	cairo_set_source_rgb (cr, 1., 1., 1.);
+
+	status = face->scaled_font_methods.render_glyph ((cairo_scaled_font_t *)scaled_font,
+							 index, cr, extents);
+	if (status == CAIRO_INT_STATUS_SUCCESS)
+	    status = cairo_status (cr);
+
+	cairo_destroy (cr);
+
+	if (unlikely (status)) {
+	    cairo_surface_destroy (glyph);
+	    return status;
+	}
+
+	recording = malloc (sizeof (cairo_user_glyph_recording_t));
+	if (unlikely (recording == NULL)) {
+	    cairo_surface_destroy (glyph);
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	}
+
+	recording->base.hash = key.base.hash;
+	recording->index = index;
+	recording->content = key.content;
+	recording->recording_surface = cairo_surface_reference (glyph);
+	recording->extents = *extents;
+
+	/* Another scaled font may have drawn the same glyph meanwhile. */
+	CAIRO_MUTEX_LOCK (face->mutex);
+	other = _cairo_hash_table_lookup (face->glyph_recordings, &key.base);
+	if (other == NULL)
+	    status = _cairo_hash_table_insert (face->glyph_recordings,
+					       &recording->base);
+	CAIRO_MUTEX_UNLOCK (face->mutex);
+
+	if (other != NULL || unlikely (status)) {
+	    cairo_surface_destroy (recording->recording_surface);
+	    free (recording);
+	    if (unlikely (status)) {
+		cairo_surface_destroy (glyph);
+		return status;
+	    }
+	}
+    }
+
+    /* The recording is replayed through the inverse of the font scale,
+     * and the scale it was recorded at, so as to draw it at the scale
+     * of this font. */
+    scale = scaled_font->base.scale;
+    scale.x0 = scale.y0 = 0.;
+    status = cairo_matrix_invert (&scale);
+    if (status == CAIRO_INT_STATUS_SUCCESS) {
+	cairo_matrix_init_scale (&shared_scale,
+				 SHARED_GLYPH_SCALE, SHARED_GLYPH_SCALE);
+	cairo_matrix_multiply (&scale, &scale, &shared_scale);
+
+	status = _cairo_recording_surface_replay_with_clip (glyph, &scale,
+							    recording_surface,
+							    NULL);
+    } else {
+	/* a font squashed flat draws nothing */
+	status = CAIRO_INT_STATUS_SUCCESS;
+    }
+    cairo_surface_destroy (glyph);
+
+    return status;
+}
+
 static cairo_int_status_t
 _cairo_user_scaled_glyph_init (void			 *abstract_font,
 			       cairo_scaled_glyph_t	 *scaled_glyph,
@@ -154,14 +316,21 @@ _cairo_user_scaled_glyph_init (void			 *abstract_font,
 
 	/* special case for 0 rank matrix (as in _cairo_scaled_font_init): empty surface */
         if (!_cairo_matrix_is_scale_0 (&scaled_font->base.scale)) {
-	    cr = _cairo_user_scaled_font_create_recording_context (scaled_font, recording_surface);
-	    status = face->scaled_font_methods.render_glyph ((cairo_scaled_font_t *)scaled_font,
-							     _cairo_scaled_glyph_index(scaled_glyph),
-							     cr, &extents);
-	    if (status == CAIRO_INT_STATUS_SUCCESS)
-	        status = cairo_status (cr);
-
-	    cairo_destroy (cr);
+	    if (face->scalable) {
+		status = _cairo_user_scaled_font_replay_shared_glyph (scaled_font,
+								      _cairo_scaled_glyph_index(scaled_glyph),
+								      recording_surface,
+								      &extents);
+	    } else {
+		cr = _cairo_user_scaled_font_create_recording_context (scaled_font, recording_surface);
+		status = face->scaled_font_methods.render_glyph ((cairo_scaled_font_t *)scaled_font,
+								 _cairo_scaled_glyph_index(scaled_glyph),
+								 cr, &extents);
+		if (status == CAIRO_INT_STATUS_SUCCESS)
+		    status = cairo_status (cr);
+
+		cairo_destroy (cr);
+	    }
 
 	    if (unlikely (status)) {
 	        cairo_surface_destroy (recording_surface);
@@ -375,6 +544,23 @@ _cairo_user_font_face_create_for_toy (cairo_toy_font_face_t   *toy_face,
     return _cairo_font_face_twin_create_for_toy (toy_face, font_face);
 }
 
+static cairo_bool_t
+_cairo_user_font_face_destroy (void *abstract_face)
+{
+    cairo_user_font_face_t *font_face = abstract_face;
+
+    if (font_face->glyph_recordings != NULL) {
+	_cairo_hash_table_foreach (font_face->glyph_recordings,
+				   _cairo_user_glyph_recording_pluck,
+				   font_face->glyph_recordings);
+	_cairo_hash_table_destroy (font_face->glyph_recordings);
+    }
+
+    CAIRO_MUTEX_FINI (font_face->mutex);
+
+    return TRUE;
+}
+
 static const cairo_scaled_font_backend_t _cairo_user_scaled_font_backend = {
     CAIRO_FONT_TYPE_USER,
     NULL,	/* scaled_font_fini */
@@ -507,7 +693,7 @@ _cairo_user_font_face_scaled_font_create (void                        *abstract_
 const cairo_font_face_backend_t _cairo_user_font_face_backend = {
     CAIRO_FONT_TYPE_USER,
     _cairo_user_font_face_create_for_toy,
-    _cairo_font_face_destroy,
+    _cairo_user_font_face_destroy,
     _cairo_user_font_face_scaled_font_create
 };
 
@@ -553,6 +739,9 @@ cairo_user_font_face_create (void)
     _cairo_font_face_init (&font_face->base, &_cairo_user_font_face_backend);
 
     font_face->immutable = FALSE;
+    font_face->scalable = FALSE;
+    CAIRO_MUTEX_INIT (font_face->mutex);
+    font_face->glyph_recordings = NULL;
     memset (&font_face->scaled_font_methods, 0, sizeof (font_face->scaled_font_methods));
 
     return &font_face->base;
@@ -716,6 +905,59 @@ cairo_user_font_face_set_unicode_to_glyph_func (cairo_font_face_t
 }
 slim_hidden_def(cairo_user_font_face_set_unicode_to_glyph_func);
 
+/**
+ * cairo_user_font_face_set_scalable:
+ * @font_face: A user font face
+ * @scalable: whether the glyphs of @font_face look the same at every
+ * size
+ *
+ * Declares that the glyphs drawn by the render_glyph callback of a
+ * user-font do not depend on the size, transformation or options of the
+ * scaled-font they are drawn for, like the outlines of a scalable font.
+ * Each glyph is then drawn by the callback just once, in font space, and
+ * that drawing is reused at every size and transformation at which the
+ * glyph is wanted, for as long as the font-face is alive.
+ *
+ * The callback is passed whichever scaled-font first wants the glyph,
+ * and the metrics it returns are used for every scaled-font.
+ *
+ * The font-face should not be immutable or a %CAIRO_STATUS_USER_FONT_IMMUTABLE
+ * error will occur.  A user font-face is immutable as soon as a scaled-font
+ * is created from it.
+ *
+ * Since: 1.16
+ **/
+void
+cairo_user_font_face_set_scalable (cairo_font_face_t *font_face,
+				   cairo_bool_t       scalable)
+{
+    cairo_user_font_face_t *user_font_face;
+
+    if (font_face->status)
+	return;
+
+    if (! _cairo_font_face_is_user (font_face)) {
+	if (_cairo_font_face_set_error (font_face, CAIRO_STATUS_FONT_TYPE_MISMATCH))
+	    return;
+    }
+
+    user_font_face = (cairo_user_font_face_t *) font_face;
+    if (user_font_face->immutable) {
+	if (_cairo_font_face_set_error (font_face, CAIRO_STATUS_USER_FONT_IMMUTABLE))
+	    return;
+    }
+
+    if (scalable && user_font_face->glyph_recordings == NULL) {
+	user_font_face->glyph_recordings =
+	    _cairo_hash_table_create (_cairo_user_glyph_recording_equal);
+	if (unlikely (user_font_face->glyph_recordings == NULL)) {
+	    _cairo_font_face_set_error (font_face, CAIRO_STATUS_NO_MEMORY);
+	    return;
+	}
+    }
+    user_font_face->scalable = scalable;
+}
+
 /* User-font method getters */
 
 /**
@@ -829,3 +1071,32 @@ cairo_user_font_face_get_unicode_to_glyph_func (cairo_font_face_t *font_face)
     user_font_face = (cairo_user_font_face_t *) font_face;
     return user_font_face->scaled_font_methods.unicode_to_glyph;
 }
+
+/**
+ * cairo_user_font_face_get_scalable:
+ * @font_face: A user font face
+ *
+ * Gets whether the glyphs of a user-font are shared by all its sizes,
+ * as set by cairo_user_font_face_set_scalable().
+ *
+ * Return value: whether the glyphs of @font_face are scalable, or
+ * %FALSE if an error has occurred.
+ *
+ * Since: 1.16
+ **/
+cairo_bool_t
+cairo_user_font_face_get_scalable (cairo_font_face_t *font_face)
+{
+    cairo_user_font_face_t *user_font_face;
+
+    if (font_face->status)
+	return FALSE;
+
+    if (! _cairo_font_face_is_user (font_face)) {
+	if (_cairo_font_face_set_error (font_face, CAIRO_STATUS_FONT_TYPE_MISMATCH))
+	    return FALSE;
+    }
+
+    user_font_face = (cairo_user_font_face_t *) font_face;
+    return user_font_face->scalable;
+}
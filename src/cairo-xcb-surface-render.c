@@ -4452,6 +4452,36 @@ _cairo_xcb_surface_add_glyph (cairo_xcb_connection_t *connection,
 	    goto BAIL;
     }
 
+    /* Glyph images kept in the shared atlas are views with the stride
+     * of the atlas, whereas the server expects packed rows. */
+    if (glyph_surface->stride != cairo_format_stride_for_width (glyph_surface->format,
+								glyph_surface->width))
+    {
+	cairo_image_surface_t *packed;
+
+	packed = _cairo_image_surface_create_from_image (glyph_surface,
+							 glyph_surface->pixman_format,
+							 0, 0,
+							 glyph_surface->width,
+							 glyph_surface->height,
+							 cairo_format_stride_for_width (glyph_surface->format,
+											glyph_surface->width));
+	if (likely (packed->base.status == CAIRO_STATUS_SUCCESS)) {
+	    packed->base.device_transform =
+		glyph_surface->base.device_transform;
+	    packed->base.device_transform_inverse =
+		glyph_surface->base.device_transform_inverse;
+	}
+
+	if (glyph_surface != scaled_glyph->surface)
+	    cairo_surface_destroy (&glyph_surface->base);
+	glyph_surface = packed;
+
+	status = glyph_surface->base.status;
+	if (unlikely (status))
+	    goto BAIL;
+    }
+
     /* XXX: FRAGILE: We're ignore device_transform scaling here. A bug? */
     glyph_info.x = _cairo_lround (glyph_surface->base.device_transform.x0);
     glyph_info.y = _cairo_lround (glyph_surface->base.device_transform.y0);
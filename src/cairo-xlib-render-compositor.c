@@ -1238,11 +1238,15 @@ _cairo_xlib_surface_add_glyph (cairo_xlib_display_t *display,
     }
 #endif
 
-    /* If the glyph format does not match the font format, then we
-     * create a temporary surface for the glyph image with the font's
-     * format.
+    /* If the glyph format does not match the font format, or the
+     * glyph image is a view into the shared glyph atlas and so its
+     * rows are not packed as the server expects, then we create a
+     * temporary surface for the glyph image with the font's format.
      */
-    if (glyph_surface->format != info->format) {
+    if (glyph_surface->format != info->format ||
+	glyph_surface->stride != cairo_format_stride_for_width (glyph_surface->format,
+								glyph_surface->width))
+    {
 	cairo_surface_pattern_t pattern;
 	cairo_surface_t *tmp_surface;
 
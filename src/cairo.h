@@ -1411,6 +1411,12 @@ cairo_font_options_set_hint_metrics (cairo_font_options_t *options,
 cairo_public cairo_hint_metrics_t
 cairo_font_options_get_hint_metrics (const cairo_font_options_t *options);
 
+cairo_public void
+cairo_font_options_set_subpixel_phases (cairo_font_options_t *options,
+					int                   phases);
+cairo_public int
+cairo_font_options_get_subpixel_phases (const cairo_font_options_t *options);
+
 /* This interface is for dealing with text as text, not caring about the
    font object inside the the cairo_t. */
 
@@ -1612,6 +1618,17 @@ cairo_scaled_font_glyph_extents (cairo_scaled_font_t   *scaled_font,
 				 int                   num_glyphs,
 				 cairo_text_extents_t  *extents);
 
+cairo_public cairo_status_t
+cairo_scaled_font_glyph_extents_array (cairo_scaled_font_t  *scaled_font,
+				       const unsigned long  *glyph_indices,
+				       int		     num_glyphs,
+				       cairo_text_extents_t *extents);
+
+cairo_public void
+cairo_scaled_font_prefetch_glyphs (cairo_scaled_font_t	*scaled_font,
+				   const cairo_glyph_t	*glyphs,
+				   int			 num_glyphs);
+
 cairo_public cairo_status_t
 cairo_scaled_font_text_to_glyphs (cairo_scaled_font_t        *scaled_font,
 				  double		      x,
@@ -1886,6 +1903,10 @@ cairo_public void
 cairo_user_font_face_set_unicode_to_glyph_func (cairo_font_face_t                              *font_face,
 					        cairo_user_scaled_font_unicode_to_glyph_func_t  unicode_to_glyph_func);
 
+cairo_public void
+cairo_user_font_face_set_scalable (cairo_font_face_t *font_face,
+				   cairo_bool_t       scalable);
+
 /* User-font method getters */
 
 cairo_public cairo_user_scaled_font_init_func_t
@@ -1900,6 +1921,9 @@ cairo_user_font_face_get_text_to_glyphs_func (cairo_font_face_t *font_face);
 cairo_public cairo_user_scaled_font_unicode_to_glyph_func_t
 cairo_user_font_face_get_unicode_to_glyph_func (cairo_font_face_t *font_face);
 
+cairo_public cairo_bool_t
+cairo_user_font_face_get_scalable (cairo_font_face_t *font_face);
+
 
 /* Query functions */
 
@@ -2090,6 +2114,40 @@ cairo_append_path (cairo_t		*cr,
 cairo_public void
 cairo_path_destroy (cairo_path_t *path);
 
+/**
+ * cairo_path_combine_op_t:
+ * @CAIRO_PATH_COMBINE_UNION: the area covered by either path (Since 1.16)
+ * @CAIRO_PATH_COMBINE_INTERSECT: the area covered by both paths (Since 1.16)
+ * @CAIRO_PATH_COMBINE_DIFFERENCE: the area covered by the first path but
+ * not by the second (Since 1.16)
+ * @CAIRO_PATH_COMBINE_XOR: the area covered by exactly one of the paths
+ * (Since 1.16)
+ *
+ * #cairo_path_combine_op_t selects the boolean operation performed by
+ * cairo_path_combine().
+ *
+ * Since: 1.16
+ **/
+typedef enum _cairo_path_combine_op {
+    CAIRO_PATH_COMBINE_UNION,
+    CAIRO_PATH_COMBINE_INTERSECT,
+    CAIRO_PATH_COMBINE_DIFFERENCE,
+    CAIRO_PATH_COMBINE_XOR
+} cairo_path_combine_op_t;
+
+cairo_public cairo_path_t *
+cairo_path_combine (const cairo_path_t *a,
+		    cairo_fill_rule_t	fill_rule_a,
+		    const cairo_path_t *b,
+		    cairo_fill_rule_t	fill_rule_b,
+		    cairo_path_combine_op_t op,
+		    double		tolerance);
+
+cairo_public cairo_path_t *
+cairo_path_simplify (const cairo_path_t *path,
+		     double		 tolerance,
+		     cairo_bool_t	 preserve_curves);
+
 /* Error status queries */
 
 cairo_public cairo_status_t
@@ -366,6 +366,11 @@ cairo_private cairo_bool_t
 _cairo_box_intersects_line_segment (const cairo_box_t *box,
 	                            cairo_line_t *line) cairo_pure;
 
+cairo_private cairo_bool_t
+_cairo_box_clip_line_segment (const cairo_box_t *box,
+			      const cairo_line_t *line,
+			      double *t0, double *t1);
+
 cairo_private cairo_bool_t
 _cairo_spline_intersects (const cairo_point_t *a,
 			  const cairo_point_t *b,
@@ -416,8 +421,19 @@ _cairo_hash_bytes (unsigned long hash,
 		   const void *bytes,
 		   unsigned int length);
 
-#define _cairo_scaled_glyph_index(g) ((g)->hash_entry.hash)
-#define _cairo_scaled_glyph_set_index(g, i)  ((g)->hash_entry.hash = (i))
+/* The cache key of a scaled glyph is its index in the font. For fonts
+ * rendering at subpixel phases (see cairo_font_options_set_subpixel_phases()),
+ * the horizontal phase of the image of a glyph is added in above the low
+ * 24 bits, to which their indices are limited, and kept apart in the
+ * glyph as well. The indices of other fonts are left whole.
+ */
+#define CAIRO_SCALED_GLYPH_INDEX_MASK 0xffffff
+#define CAIRO_SCALED_GLYPH_PHASE_SHIFT 24
+#define CAIRO_SCALED_GLYPH_MAX_PHASES 16
+
+#define _cairo_scaled_glyph_key(g) ((g)->hash_entry.hash)
+#define _cairo_scaled_glyph_index(g) ((g)->hash_entry.hash - ((unsigned long) (g)->xphase << CAIRO_SCALED_GLYPH_PHASE_SHIFT))
+#define _cairo_scaled_glyph_xphase(g) ((g)->xphase)
 
 #include "cairo-scaled-font-private.h"
 
@@ -597,6 +613,23 @@ struct _cairo_scaled_font_backend {
                            long                  offset,
                            unsigned char        *buffer,
                            unsigned long        *length);
+
+    /* Optionally fill in @info for a batch of glyphs at once, such as
+     * by sharing out the work between threads.
+     * @scaled_font: font
+     * @scaled_glyphs: the glyphs, each with its index set and some info
+     *                 possibly already present
+     * @num_glyphs: the number of glyphs, each of which appears only once
+     * @info: the info to fill in for every glyph
+     *
+     * Returns CAIRO_INT_STATUS_UNSUPPORTED to have each glyph passed to
+     * scaled_glyph_init() in turn instead.
+     */
+    cairo_warn cairo_int_status_t
+    (*scaled_glyphs_init) (void			     *scaled_font,
+			   cairo_scaled_glyph_t	    **scaled_glyphs,
+			   int			      num_glyphs,
+			   cairo_scaled_glyph_info_t  info);
 };
 
 struct _cairo_font_face_backend {
@@ -986,6 +1019,19 @@ _cairo_path_fixed_interpret (const cairo_path_fixed_t	  *path,
 		       cairo_path_fixed_close_path_func_t *close_path,
 		       void				  *closure);
 
+cairo_private cairo_status_t
+_cairo_path_fixed_interpret_culled (const cairo_path_fixed_t *path,
+				    const cairo_box_t *bounds,
+				    cairo_path_fixed_move_to_func_t *move_to,
+				    cairo_path_fixed_line_to_func_t *line_to,
+				    cairo_path_fixed_curve_to_func_t *curve_to,
+				    cairo_path_fixed_close_path_func_t *close_path,
+				    void *closure);
+
+cairo_private unsigned int
+_cairo_path_fixed_count_culled (const cairo_path_fixed_t *path,
+				const cairo_box_t *bounds);
+
 cairo_private cairo_status_t
 _cairo_path_fixed_interpret_flat (const cairo_path_fixed_t *path,
 		       cairo_path_fixed_move_to_func_t	  *move_to,
@@ -1044,6 +1090,11 @@ cairo_private cairo_bool_t
 _cairo_path_fixed_is_rectangle (const cairo_path_fixed_t *path,
 				cairo_box_t        *box);
 
+cairo_private cairo_bool_t
+_cairo_path_fixed_is_ellipse (const cairo_path_fixed_t *path,
+			      double			tolerance,
+			      cairo_ellipse_double_t   *ellipse);
+
 /* cairo-path-in-fill.c */
 cairo_private cairo_bool_t
 _cairo_path_fixed_in_fill (const cairo_path_fixed_t	*path,
@@ -1052,6 +1103,13 @@ _cairo_path_fixed_in_fill (const cairo_path_fixed_t	*path,
 			   double		 x,
 			   double		 y);
 
+cairo_private cairo_bool_t
+_cairo_path_fixed_in_fill_indexed (cairo_path_fixed_t	*path,
+				   cairo_fill_rule_t	 fill_rule,
+				   double		 tolerance,
+				   double		 x,
+				   double		 y);
+
 /* cairo-path-fill.c */
 cairo_private cairo_status_t
 _cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
@@ -1204,6 +1262,27 @@ _cairo_scaled_font_glyph_approximate_extents (cairo_scaled_font_t	 *scaled_font,
 					      int                      num_glyphs,
 					      cairo_rectangle_int_t   *extents);
 
+cairo_private unsigned long
+_cairo_scaled_font_glyph_phase (cairo_scaled_font_t *scaled_font,
+				unsigned long        index,
+				double              *x);
+
+cairo_private cairo_status_t
+_cairo_scaled_font_write_glyph_cache (cairo_scaled_font_t *scaled_font,
+				      const void	  *key,
+				      unsigned int	   key_length,
+				      cairo_write_func_t   write_func,
+				      void		  *closure);
+
+cairo_private cairo_status_t
+_cairo_scaled_font_load_glyph_cache (cairo_scaled_font_t  *scaled_font,
+				     const void		  *key,
+				     unsigned int	   key_length,
+				     const unsigned char  *data,
+				     unsigned long	   length,
+				     cairo_destroy_func_t  destroy,
+				     void		  *closure);
+
 cairo_private cairo_status_t
 _cairo_scaled_font_show_glyphs (cairo_scaled_font_t *scaled_font,
 				cairo_operator_t     op,
@@ -1251,6 +1330,18 @@ _cairo_scaled_glyph_lookup (cairo_scaled_font_t *scaled_font,
 			    cairo_scaled_glyph_info_t info,
 			    cairo_scaled_glyph_t **scaled_glyph_ret);
 
+cairo_private cairo_int_status_t
+_cairo_scaled_glyph_lookup_metrics (cairo_scaled_font_t *scaled_font,
+				    unsigned long index,
+				    cairo_text_extents_t *metrics,
+				    cairo_box_t *bbox);
+
+cairo_private cairo_int_status_t
+_cairo_scaled_font_prefetch_glyphs (cairo_scaled_font_t *scaled_font,
+				    const cairo_glyph_t *glyphs,
+				    int			 num_glyphs,
+				    cairo_scaled_glyph_info_t info);
+
 cairo_private double
 _cairo_scaled_font_get_max_scale (cairo_scaled_font_t *scaled_font);
 
@@ -1538,6 +1629,16 @@ _cairo_image_scaled_glyph_fini (cairo_scaled_font_t *scaled_font,
 cairo_private void
 _cairo_image_reset_static_data (void);
 
+cairo_private cairo_image_surface_t *
+_cairo_image_glyph_atlas_store (cairo_image_surface_t *image,
+				cairo_image_glyph_shelf_t **shelf_out);
+
+cairo_private void
+_cairo_image_glyph_atlas_release (cairo_image_glyph_shelf_t *shelf);
+
+cairo_private void
+_cairo_image_glyph_atlas_reset_static_data (void);
+
 cairo_private cairo_surface_t *
 _cairo_image_surface_create_with_pixman_format (unsigned char		*data,
 						pixman_format_code_t	 pixman_format,
@@ -1830,6 +1931,15 @@ _cairo_drm_device_reset_static_data (void);
 cairo_private void
 _cairo_clip_reset_static_data (void);
 
+cairo_private void
+_cairo_bentley_ottmann_reset_static_data (void);
+
+cairo_private void
+_cairo_tor_scan_converter_reset_static_data (void);
+
+cairo_private void
+_cairo_tor22_scan_converter_reset_static_data (void);
+
 cairo_private void
 _cairo_pattern_reset_static_data (void);
 
@@ -1953,6 +2063,7 @@ slim_hidden_proto (cairo_scaled_font_get_font_face);
 slim_hidden_proto (cairo_scaled_font_get_font_matrix);
 slim_hidden_proto (cairo_scaled_font_get_font_options);
 slim_hidden_proto (cairo_scaled_font_glyph_extents);
+slim_hidden_proto (cairo_scaled_font_prefetch_glyphs);
 slim_hidden_proto_no_warn (cairo_scaled_font_reference);
 slim_hidden_proto (cairo_scaled_font_status);
 slim_hidden_proto (cairo_scaled_font_get_user_data);
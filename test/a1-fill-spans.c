@@ -0,0 +1,202 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Fill runs of many starts and lengths within a few words of an a1
+ * image, setting and clearing bits over a patterned background, both
+ * as boxes and as the spans of non-rectilinear paths. The a1 fills
+ * write the rows directly; they must agree bit for bit with the same
+ * fills onto an a8 image, which still go through pixman.
+ */
+
+#include "cairo-test.h"
+
+#define WIDTH 100
+#define HEIGHT 96
+
+static cairo_bool_t
+a1_get (cairo_surface_t *surface, int x, int y)
+{
+    const uint32_t *row = (const uint32_t *)
+	(cairo_image_surface_get_data (surface) +
+	 y * cairo_image_surface_get_stride (surface));
+#ifdef WORDS_BIGENDIAN
+    return (row[x >> 5] >> (31 - (x & 31))) & 1;
+#else
+    return (row[x >> 5] >> (x & 31)) & 1;
+#endif
+}
+
+static void
+a1_set (cairo_surface_t *surface, int x, int y, cairo_bool_t set)
+{
+    uint32_t *row = (uint32_t *)
+	(cairo_image_surface_get_data (surface) +
+	 y * cairo_image_surface_get_stride (surface));
+#ifdef WORDS_BIGENDIAN
+    uint32_t bit = 0x80000000u >> (x & 31);
+#else
+    uint32_t bit = 1u << (x & 31);
+#endif
+
+    if (set)
+	row[x >> 5] |= bit;
+    else
+	row[x >> 5] &= ~bit;
+}
+
+static cairo_surface_t *
+create_patterned (cairo_format_t format)
+{
+    cairo_surface_t *surface;
+    int x, y;
+
+    surface = cairo_image_surface_create (format, WIDTH, HEIGHT);
+    cairo_surface_flush (surface);
+    for (y = 0; y < HEIGHT; y++) {
+	unsigned char *row = cairo_image_surface_get_data (surface) +
+	    y * cairo_image_surface_get_stride (surface);
+	for (x = 0; x < WIDTH; x++) {
+	    cairo_bool_t set = (x * 7 + y * 3) % 5 < 2;
+	    if (format == CAIRO_FORMAT_A1)
+		a1_set (surface, x, y, set);
+	    else
+		row[x] = set ? 0xff : 0;
+	}
+    }
+    cairo_surface_mark_dirty (surface);
+
+    return surface;
+}
+
+static void
+fill_runs (cairo_t *cr, int parity)
+{
+    int y;
+
+    /* one run per row, each starting and ending at another bit */
+    for (y = parity; y < HEIGHT; y += 2) {
+	int x = (y * 5) % 37;
+	int w = (y * 13) % (WIDTH - x) + 1;
+	cairo_rectangle (cr, x, y, w, 1);
+    }
+    /* and a taller one, filled as a single box */
+    cairo_rectangle (cr, 3 + parity * 30, 10, 61, 20);
+}
+
+static void
+fill_star (cairo_t *cr, double cx, double cy, double r)
+{
+    int i;
+
+    for (i = 0; i < 9; i++) {
+	double a = i * 4 * M_PI / 9;
+	cairo_line_to (cr, cx + r * sin (a), cy - r * cos (a));
+    }
+    cairo_close_path (cr);
+}
+
+static void
+draw (cairo_t *cr, int pass)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_NONE);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+
+    switch (pass) {
+    case 0:
+	fill_runs (cr, 0);
+	break;
+    case 1:
+	cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+	fill_runs (cr, 1);
+	break;
+    case 2:
+	fill_star (cr, 40, 48, 45);
+	break;
+    case 3:
+	cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+	fill_star (cr, 61, 45, 30);
+	break;
+    }
+    cairo_fill (cr);
+}
+
+static cairo_test_status_t
+compare (const cairo_test_context_t *ctx,
+	 cairo_surface_t *a1, cairo_surface_t *a8, int pass)
+{
+    int x, y;
+
+    cairo_surface_flush (a1);
+    cairo_surface_flush (a8);
+    for (y = 0; y < HEIGHT; y++) {
+	const unsigned char *row = cairo_image_surface_get_data (a8) +
+	    y * cairo_image_surface_get_stride (a8);
+	for (x = 0; x < WIDTH; x++) {
+	    if (a1_get (a1, x, y) != (row[x] >= 0x80)) {
+		cairo_test_log (ctx,
+				"Error: pass %d, pixel (%d, %d) is %s in a1 but %d in a8\n",
+				pass, x, y,
+				a1_get (a1, x, y) ? "set" : "clear",
+				row[x]);
+		return CAIRO_TEST_FAILURE;
+	    }
+	}
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *a1, *a8;
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    int pass;
+
+    a1 = create_patterned (CAIRO_FORMAT_A1);
+    a8 = create_patterned (CAIRO_FORMAT_A8);
+
+    for (pass = 0; pass < 4 && result == CAIRO_TEST_SUCCESS; pass++) {
+	cairo_t *cr;
+
+	cr = cairo_create (a1);
+	draw (cr, pass);
+	cairo_destroy (cr);
+
+	cr = cairo_create (a8);
+	draw (cr, pass);
+	cairo_destroy (cr);
+
+	result = compare (ctx, a1, a8, pass);
+    }
+
+    cairo_surface_destroy (a1);
+    cairo_surface_destroy (a8);
+
+    return result;
+}
+
+CAIRO_TEST (a1_fill_spans,
+	    "Check direct fills of a1 rows against the same fills onto a8",
+	    "a1, fill", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
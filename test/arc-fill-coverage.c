@@ -0,0 +1,118 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Filled full circles are rasterised with exact coverage rather than
+ * via their flattened outline. Check that the result agrees with the
+ * generic scan conversion of the very same path (which we force by
+ * appending a sub-path lying outside the surface) to within the
+ * precision of the supersampling grid, and that the total coverage
+ * matches the area of the ellipse.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 64
+
+static const struct {
+    double xc, yc, radius;
+    double sx, sy;
+} shapes[] = {
+    { 32, 32, 20, 1, 1 },
+    { 31.3, 32.7, 0.8, 1, 1 },
+    { 10, 50, 7.25, 1, 1 },
+    { 16, 64, 12, 2, .5 },
+    { 0, 0, 30, 1, 1 },
+};
+
+static cairo_surface_t *
+fill_shape (int n, cairo_bool_t exact)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+
+    cairo_scale (cr, shapes[n].sx, shapes[n].sy);
+    cairo_arc (cr, shapes[n].xc, shapes[n].yc, shapes[n].radius, 0, 2 * M_PI);
+    if (! exact)
+	cairo_rectangle (cr, -SIZE, -SIZE, 1, 1);
+    cairo_fill (cr);
+
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    unsigned int n;
+
+    for (n = 0; n < ARRAY_LENGTH (shapes); n++) {
+	cairo_surface_t *exact, *ref;
+	const uint8_t *a, *b;
+	int stride, x, y;
+	double sum_a = 0, sum_b = 0;
+	int max_diff = 0;
+
+	exact = fill_shape (n, TRUE);
+	ref = fill_shape (n, FALSE);
+
+	cairo_surface_flush (exact);
+	cairo_surface_flush (ref);
+
+	a = cairo_image_surface_get_data (exact);
+	b = cairo_image_surface_get_data (ref);
+	stride = cairo_image_surface_get_stride (exact);
+
+	for (y = 0; y < SIZE; y++) {
+	    for (x = 0; x < SIZE; x++) {
+		int diff = abs (a[y*stride + x] - b[y*stride + x]);
+		if (diff > max_diff)
+		    max_diff = diff;
+		sum_a += a[y*stride + x];
+		sum_b += b[y*stride + x];
+	    }
+	}
+
+	cairo_test_log (ctx,
+			"shape %d: max pixel difference %d, total coverage %.1f vs %.1f\n",
+			n, max_diff, sum_a / 255., sum_b / 255.);
+
+	/* a single row of the 15-row grid is off by 255/15 */
+	if (max_diff > 24 || fabs (sum_a - sum_b) > .01 * sum_b + 255.)
+	    status = CAIRO_TEST_FAILURE;
+
+	cairo_surface_destroy (exact);
+	cairo_surface_destroy (ref);
+    }
+
+    return status;
+}
+
+CAIRO_TEST (arc_fill_coverage,
+	    "Compare the exact rasterisation of filled circles with the generic path",
+	    "fill, arc", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,124 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The mask of a clip path is kept with the path and reused by every
+ * later operation under it, up to a total over all clip paths beyond
+ * which the least recently used masks are released. Keep enough clips
+ * with large masks alive to overflow that total, draw under each of
+ * them, and then draw under them all again, hitting evicted and kept
+ * masks alike. Each second drawing must reproduce the first exactly.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 64
+#define NUM_CLIPS 12
+
+static void
+clip (cairo_t *cr, int i)
+{
+    /* a hole in a disc large enough for its mask to be kept at the limit
+     * of the size of a single mask, so that a few of them overflow the
+     * total */
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    cairo_arc (cr, SIZE / 2, SIZE / 2, 990, 0, 2 * M_PI);
+    cairo_new_sub_path (cr);
+    cairo_arc (cr, SIZE / 2 + i, SIZE / 2, 8 + 1.5 * i, 0, 2 * M_PI);
+    cairo_clip (cr);
+}
+
+static void
+draw (cairo_t *cr)
+{
+    /* clear outside the clip too */
+    cairo_save (cr);
+    cairo_reset_clip (cr);
+    cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint (cr);
+    cairo_restore (cr);
+
+    /* fill with another antialias than the clip's, so that the clip is
+     * not intersected with the shape but applied as a mask */
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_GOOD);
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    cairo_arc (cr, SIZE / 2, SIZE / 2, SIZE / 2 - 2, 0, 2 * M_PI);
+    cairo_fill (cr);
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_t *cr[NUM_CLIPS];
+    unsigned char *first[NUM_CLIPS];
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    int i, y;
+
+    for (i = 0; i < NUM_CLIPS; i++) {
+	cairo_surface_t *surface;
+
+	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+	cr[i] = cairo_create (surface);
+	cairo_surface_destroy (surface);
+
+	clip (cr[i], i);
+	draw (cr[i]);
+
+	cairo_surface_flush (surface);
+	first[i] = xmalloc (SIZE * cairo_image_surface_get_stride (surface));
+	memcpy (first[i], cairo_image_surface_get_data (surface),
+		SIZE * cairo_image_surface_get_stride (surface));
+    }
+
+    for (i = 0; i < NUM_CLIPS; i++) {
+	cairo_surface_t *surface = cairo_get_target (cr[i]);
+	int stride = cairo_image_surface_get_stride (surface);
+
+	draw (cr[i]);
+
+	cairo_surface_flush (surface);
+	for (y = 0; y < SIZE; y++) {
+	    if (memcmp (first[i] + y * stride,
+			cairo_image_surface_get_data (surface) + y * stride,
+			SIZE * 4))
+	    {
+		cairo_test_log (ctx,
+				"Error: clip %d, row %d differs when drawn again\n",
+				i, y);
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    for (i = 0; i < NUM_CLIPS; i++) {
+	cairo_destroy (cr[i]);
+	free (first[i]);
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (clip_mask_cache,
+	    "Check that reused and evicted clip masks draw alike",
+	    "clip", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,139 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Stroke long dashed lines that start far outside the surface, so that
+ * the stroker seeks over the dashes it cannot see, and compare what is
+ * visible with the same lines begun just outside a larger surface,
+ * where nothing is skipped. The dashes must be in the same places.
+ */
+
+#include "cairo-test.h"
+
+#define WIDTH 64
+#define HEIGHT 32
+#define PAD 32
+
+/* Lines of slope 3:4 and 4:-3, so that lengths along them are exact.
+ * Each passes through the surface 5000 units along, and leaves the
+ * padding of the reference 40 units before that.
+ */
+static const struct {
+    double x0, y0, dx, dy;
+} lines[] = {
+    { -2980, -4000, 3, 4 },
+    { -4000, 3016, 4, -3 },
+};
+
+#define LENGTH 10000
+#define REFERENCE_START (LENGTH / 2 - 40)
+
+static const double dashes[] = { 7, 5 };
+#define PERIOD 12
+#define OFFSET 3
+
+static void
+stroke_lines (cairo_t *cr, double start)
+{
+    int i;
+
+    cairo_set_line_width (cr, 3);
+    cairo_set_dash (cr, dashes, ARRAY_LENGTH (dashes),
+		    fmod (OFFSET + start, PERIOD));
+
+    for (i = 0; i < ARRAY_LENGTH (lines); i++) {
+	cairo_move_to (cr,
+		       lines[i].x0 + start * lines[i].dx / 5,
+		       lines[i].y0 + start * lines[i].dy / 5);
+	cairo_line_to (cr,
+		       lines[i].x0 + LENGTH * lines[i].dx / 5,
+		       lines[i].y0 + LENGTH * lines[i].dy / 5);
+    }
+    cairo_stroke (cr);
+}
+
+static cairo_surface_t *
+draw_lines (int width, int height, double translate, double start)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+    cr = cairo_create (surface);
+    cairo_translate (cr, translate, translate);
+    stroke_lines (cr, start);
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *culled, *reference;
+    const uint8_t *a, *b;
+    int stride_a, stride_b, x, y, drawn = 0;
+
+    culled = draw_lines (WIDTH, HEIGHT, 0, 0);
+    reference = draw_lines (WIDTH + 2 * PAD, HEIGHT + 2 * PAD,
+			    PAD, REFERENCE_START);
+
+    cairo_surface_flush (culled);
+    cairo_surface_flush (reference);
+    a = cairo_image_surface_get_data (culled);
+    b = cairo_image_surface_get_data (reference);
+    stride_a = cairo_image_surface_get_stride (culled);
+    stride_b = cairo_image_surface_get_stride (reference);
+
+    for (y = 0; y < HEIGHT; y++) {
+	for (x = 0; x < WIDTH; x++) {
+	    int va = a[y * stride_a + x];
+	    int vb = b[(y + PAD) * stride_b + x + PAD];
+
+	    if (abs (va - vb) > 8) {
+		cairo_test_log (ctx, "pixel %d,%d is %d, expected %d\n",
+				x, y, va, vb);
+		status = CAIRO_TEST_FAILURE;
+		goto done;
+	    }
+
+	    drawn += vb != 0;
+	}
+    }
+
+    if (drawn == 0) {
+	cairo_test_log (ctx, "the reference draws nothing\n");
+	status = CAIRO_TEST_FAILURE;
+    }
+
+done:
+    cairo_surface_destroy (culled);
+    cairo_surface_destroy (reference);
+
+    return status;
+}
+
+CAIRO_TEST (dash_offscreen_phase,
+	    "Check the phase of dashes on lines begun far outside the surface",
+	    "dash, stroke", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,102 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The scan converter keeps its storage from one fill to the next.
+ * Check that a small fill renders identically before and after the
+ * converter has been grown by much larger and more complex fills.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 40
+
+static cairo_surface_t *
+fill_small (void)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+    cairo_move_to (cr, 3.3, 5.1);
+    cairo_line_to (cr, 36.7, 12.9);
+    cairo_line_to (cr, 8.2, 35.4);
+    cairo_close_path (cr);
+    cairo_arc (cr, 24.5, 24.5, 9.75, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    return surface;
+}
+
+static void
+fill_large (void)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int i;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 2000, 1000);
+    cr = cairo_create (surface);
+    for (i = 0; i < 2000; i++)
+	cairo_line_to (cr, (i * 997) % 2000, (i * 631) % 1000);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+    cairo_surface_destroy (surface);
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *before, *after;
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    int y;
+
+    before = fill_small ();
+    fill_large ();
+    after = fill_small ();
+
+    for (y = 0; y < SIZE; y++) {
+	int stride = cairo_image_surface_get_stride (before);
+
+	if (memcmp (cairo_image_surface_get_data (before) + y * stride,
+		    cairo_image_surface_get_data (after) + y * stride,
+		    SIZE))
+	{
+	    cairo_test_log (ctx, "row %d differs after a large fill\n", y);
+	    status = CAIRO_TEST_FAILURE;
+	    break;
+	}
+    }
+
+    cairo_surface_destroy (before);
+    cairo_surface_destroy (after);
+
+    return status;
+}
+
+CAIRO_TEST (fill_converter_reuse,
+	    "Check that fills are unaffected by the scan converter's previous use",
+	    "fill", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,150 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* With CAIRO_ANTIALIAS_BEST the coverage of each pixel is its exact
+ * area within the polygon. Fill a few polygons, including a sliver
+ * too thin for any sampling grid and shapes hanging off the edges of
+ * the surface, and compare every pixel against its area computed by
+ * clipping the polygon to the pixel.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 32
+
+typedef struct { double x, y; } point_t;
+
+static const point_t sliver[] = {
+    { 1.3, 4.1 }, { 30.6, 5.35 }, { 2.2, 4.45 },
+};
+
+static const point_t diamond[] = {
+    { 16.2, -6.7 }, { 38.4, 15.1 }, { 16.9, 37.3 }, { -5.3, 16.4 },
+};
+
+static const point_t arrow[] = {
+    { 3.75, 20.2 }, { 28.1, 24.6 }, { 9.4, 30.9 }, { 12.6, 25.3 },
+};
+
+static int
+clip (const point_t *in, int n, point_t *out,
+      cairo_bool_t vertical, double v, cairo_bool_t keep_below)
+{
+    int i, m = 0;
+
+    for (i = 0; i < n; i++) {
+	point_t a = in[i], b = in[(i + 1) % n];
+	double av = vertical ? a.y : a.x;
+	double bv = vertical ? b.y : b.x;
+	cairo_bool_t a_in = keep_below ? av <= v : av >= v;
+	cairo_bool_t b_in = keep_below ? bv <= v : bv >= v;
+
+	if (a_in)
+	    out[m++] = a;
+	if (a_in != b_in) {
+	    double t = (v - av) / (bv - av);
+	    out[m].x = a.x + t * (b.x - a.x);
+	    out[m].y = a.y + t * (b.y - a.y);
+	    m++;
+	}
+    }
+
+    return m;
+}
+
+static double
+pixel_area (const point_t *p, int n, int x, int y)
+{
+    point_t a[16], b[16];
+    double area = 0;
+    int i;
+
+    n = clip (p, n, a, FALSE, x, FALSE);
+    n = clip (a, n, b, FALSE, x + 1, TRUE);
+    n = clip (b, n, a, TRUE, y, FALSE);
+    n = clip (a, n, b, TRUE, y + 1, TRUE);
+
+    for (i = 0; i < n; i++)
+	area += b[i].x * b[(i + 1) % n].y - b[(i + 1) % n].x * b[i].y;
+
+    return fabs (area) / 2;
+}
+
+static cairo_test_status_t
+check (cairo_test_context_t *ctx, const char *name,
+       const point_t *p, int n)
+{
+    cairo_surface_t *surface;
+    const uint8_t *data;
+    cairo_t *cr;
+    int stride, x, y, i, worst = 0;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_BEST);
+    for (i = 0; i < n; i++)
+	cairo_line_to (cr, p[i].x, p[i].y);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    data = cairo_image_surface_get_data (surface);
+    stride = cairo_image_surface_get_stride (surface);
+
+    for (y = 0; y < SIZE; y++) {
+	for (x = 0; x < SIZE; x++) {
+	    int expected = pixel_area (p, n, x, y) * 255 + .5;
+	    int diff = abs (data[y * stride + x] - expected);
+
+	    if (diff > worst)
+		worst = diff;
+	}
+    }
+
+    cairo_surface_destroy (surface);
+
+    cairo_test_log (ctx, "%s: worst pixel differs by %d\n", name, worst);
+
+    /* allow for rounding the vertices to cairo_fixed_t */
+    return worst <= 2 ? CAIRO_TEST_SUCCESS : CAIRO_TEST_FAILURE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+
+    if (check (ctx, "sliver", sliver, ARRAY_LENGTH (sliver)))
+	status = CAIRO_TEST_FAILURE;
+    if (check (ctx, "diamond", diamond, ARRAY_LENGTH (diamond)))
+	status = CAIRO_TEST_FAILURE;
+    if (check (ctx, "arrow", arrow, ARRAY_LENGTH (arrow)))
+	status = CAIRO_TEST_FAILURE;
+
+    return status;
+}
+
+CAIRO_TEST (fill_exact_coverage,
+	    "Check that the best antialiasing gives the exact area of each pixel",
+	    "fill, antialias", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
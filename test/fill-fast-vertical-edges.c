@@ -0,0 +1,168 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Fill shapes with vertical sides using the fast antialiasing, whose
+ * scan converter works on a 4x4 grid, and compare every pixel against
+ * its area computed by clipping the polygon to the pixel. Sides lying
+ * on the grid must come out exact; sloped ones to within the grid.
+ *
+ * Each path is given a small triangle in the corner, left out of the
+ * comparison, so that it goes through the scan converter rather than
+ * being composited as boxes.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 32
+#define CHECKED 24 /* the triangle lies beyond */
+
+typedef struct { double x, y; } point_t;
+
+static const point_t rectangle[] = {
+    { 4, 2 }, { 8, 2 }, { 8, 4 }, { 4, 4 },
+};
+
+static const point_t quarters[] = {
+    { 10.25, 6.5 }, { 13.75, 6.5 }, { 13.75, 9.25 }, { 10.25, 9.25 },
+};
+
+static const point_t left_vertical[] = {
+    { 4, 12 }, { 9, 12 }, { 7, 20 }, { 4, 20 },
+};
+
+static const point_t right_vertical[] = {
+    { 14, 12 }, { 20.5, 12 }, { 20.5, 22 }, { 16, 22 },
+};
+
+static int
+clip (const point_t *in, int n, point_t *out,
+      cairo_bool_t vertical, double v, cairo_bool_t keep_below)
+{
+    int i, m = 0;
+
+    for (i = 0; i < n; i++) {
+	point_t a = in[i], b = in[(i + 1) % n];
+	double av = vertical ? a.y : a.x;
+	double bv = vertical ? b.y : b.x;
+	cairo_bool_t a_in = keep_below ? av <= v : av >= v;
+	cairo_bool_t b_in = keep_below ? bv <= v : bv >= v;
+
+	if (a_in)
+	    out[m++] = a;
+	if (a_in != b_in) {
+	    double t = (v - av) / (bv - av);
+	    out[m].x = a.x + t * (b.x - a.x);
+	    out[m].y = a.y + t * (b.y - a.y);
+	    m++;
+	}
+    }
+
+    return m;
+}
+
+static double
+pixel_area (const point_t *p, int n, int x, int y)
+{
+    point_t a[16], b[16];
+    double area = 0;
+    int i;
+
+    n = clip (p, n, a, FALSE, x, FALSE);
+    n = clip (a, n, b, FALSE, x + 1, TRUE);
+    n = clip (b, n, a, TRUE, y, FALSE);
+    n = clip (a, n, b, TRUE, y + 1, TRUE);
+
+    for (i = 0; i < n; i++)
+	area += b[i].x * b[(i + 1) % n].y - b[(i + 1) % n].x * b[i].y;
+
+    return fabs (area) / 2;
+}
+
+static cairo_test_status_t
+check (cairo_test_context_t *ctx, const char *name,
+       const point_t *p, int n, int tolerance)
+{
+    cairo_surface_t *surface;
+    const uint8_t *data;
+    cairo_t *cr;
+    int stride, x, y, i, worst = 0;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    for (i = 0; i < n; i++)
+	cairo_line_to (cr, p[i].x, p[i].y);
+    cairo_close_path (cr);
+    cairo_move_to (cr, 27, 27);
+    cairo_line_to (cr, 31, 27);
+    cairo_line_to (cr, 27, 31);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    data = cairo_image_surface_get_data (surface);
+    stride = cairo_image_surface_get_stride (surface);
+
+    for (y = 0; y < CHECKED; y++) {
+	for (x = 0; x < CHECKED; x++) {
+	    int expected = pixel_area (p, n, x, y) * 255 + .5;
+	    int diff = abs (data[y * stride + x] - expected);
+
+	    if (diff > worst)
+		worst = diff;
+	}
+    }
+
+    cairo_surface_destroy (surface);
+
+    cairo_test_log (ctx, "%s: worst pixel differs by %d\n", name, worst);
+
+    return worst <= tolerance ? CAIRO_TEST_SUCCESS : CAIRO_TEST_FAILURE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+
+    /* every side on the grid */
+    if (check (ctx, "rectangle", rectangle, ARRAY_LENGTH (rectangle), 2))
+	status = CAIRO_TEST_FAILURE;
+    if (check (ctx, "quarters", quarters, ARRAY_LENGTH (quarters), 2))
+	status = CAIRO_TEST_FAILURE;
+
+    /* a sloped side may be out by an eighth of a pixel */
+    if (check (ctx, "left vertical", left_vertical,
+	       ARRAY_LENGTH (left_vertical), 40))
+	status = CAIRO_TEST_FAILURE;
+    if (check (ctx, "right vertical", right_vertical,
+	       ARRAY_LENGTH (right_vertical), 40))
+	status = CAIRO_TEST_FAILURE;
+
+    return status;
+}
+
+CAIRO_TEST (fill_fast_vertical_edges,
+	    "Check fast antialiasing of fills with vertical sides",
+	    "fill, antialias", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
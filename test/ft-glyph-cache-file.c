@@ -0,0 +1,236 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Write out the glyphs cached by a font, then check that they load
+ * into another font of the same face, size and options whose cache is
+ * still cold, drawing just what the first font drew, and are rejected
+ * by a font at another size or when the data is damaged.
+ */
+
+#include "cairo-test.h"
+
+#include <cairo-ft.h>
+
+#define TEXT "Hamburgefonts"
+#define WIDTH 200
+#define HEIGHT 40
+
+typedef struct _buffer {
+    uint32_t *data; /* kept 4-byte aligned for loading */
+    unsigned long length, size;
+} buffer_t;
+
+static cairo_status_t
+write_func (void *closure, const unsigned char *data, unsigned int length)
+{
+    buffer_t *buffer = closure;
+
+    if (buffer->length + length > buffer->size) {
+	unsigned long size = 2 * (buffer->length + length);
+	uint32_t *grown = realloc (buffer->data, size + 3);
+
+	if (grown == NULL)
+	    return CAIRO_STATUS_NO_MEMORY;
+
+	buffer->data = grown;
+	buffer->size = size;
+    }
+
+    memcpy ((unsigned char *) buffer->data + buffer->length, data, length);
+    buffer->length += length;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Every call makes a new font face, and so a new scaled font with
+ * nothing yet in its cache, yet resolving to the same file and settings.
+ */
+static cairo_scaled_font_t *
+create_scaled_font (double size)
+{
+    FcPattern *pattern;
+    cairo_font_face_t *font_face;
+    cairo_font_options_t *options;
+    cairo_scaled_font_t *scaled_font;
+    cairo_matrix_t font_matrix, ctm;
+
+    pattern = FcPatternCreate ();
+    FcPatternAddString (pattern, FC_FAMILY,
+			(FcChar8 *) CAIRO_TEST_FONT_FAMILY " Sans");
+    font_face = cairo_ft_font_face_create_for_pattern (pattern);
+    FcPatternDestroy (pattern);
+
+    options = cairo_font_options_create ();
+    cairo_font_options_set_antialias (options, CAIRO_ANTIALIAS_GRAY);
+    cairo_font_options_set_hint_metrics (options, CAIRO_HINT_METRICS_OFF);
+    cairo_matrix_init_scale (&font_matrix, size, size);
+    cairo_matrix_init_identity (&ctm);
+
+    scaled_font = cairo_scaled_font_create (font_face,
+					    &font_matrix, &ctm, options);
+
+    cairo_font_options_destroy (options);
+    cairo_font_face_destroy (font_face);
+
+    return scaled_font;
+}
+
+static cairo_surface_t *
+draw_text (cairo_scaled_font_t *scaled_font)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, WIDTH, HEIGHT);
+    cr = cairo_create (surface);
+
+    cairo_set_scaled_font (cr, scaled_font);
+    cairo_move_to (cr, 4, 30);
+    cairo_show_text (cr, TEXT);
+
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    return surface;
+}
+
+static int
+count_differences (cairo_surface_t *a, cairo_surface_t *b)
+{
+    const uint8_t *pa = cairo_image_surface_get_data (a);
+    const uint8_t *pb = cairo_image_surface_get_data (b);
+    int stride = cairo_image_surface_get_stride (a);
+    int x, y, differ = 0;
+
+    for (y = 0; y < HEIGHT; y++) {
+	for (x = 0; x < WIDTH; x++) {
+	    if (pa[y * stride + x] != pb[y * stride + x])
+		differ++;
+	}
+    }
+
+    return differ;
+}
+
+static void
+check (cairo_test_context_t *ctx,
+       cairo_test_status_t *result,
+       const char *what,
+       cairo_status_t status,
+       cairo_status_t expected)
+{
+    if (status == expected)
+	return;
+
+    cairo_test_log (ctx, "%s: expected \"%s\", got \"%s\"\n", what,
+		    cairo_status_to_string (expected),
+		    cairo_status_to_string (status));
+    *result = CAIRO_TEST_FAILURE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_scaled_font_t *font, *other, *cold;
+    cairo_surface_t *rendered, *loaded = NULL;
+    cairo_status_t load;
+    buffer_t buffer = { NULL, 0, 0 };
+    unsigned char *damaged;
+    int differ;
+
+    font = create_scaled_font (20);
+    if (cairo_scaled_font_status (font) ||
+	cairo_scaled_font_get_type (font) != CAIRO_FONT_TYPE_FT)
+    {
+	cairo_scaled_font_destroy (font);
+	return CAIRO_TEST_UNTESTED;
+    }
+
+    rendered = draw_text (font);
+
+    if (cairo_ft_scaled_font_write_glyph_cache (font, write_func, &buffer) ||
+	buffer.length == 0)
+    {
+	cairo_test_log (ctx, "failed to write the glyph cache\n");
+	status = CAIRO_TEST_FAILURE;
+	goto done;
+    }
+    cairo_test_log (ctx, "glyph cache of %lu bytes\n", buffer.length);
+
+    other = create_scaled_font (21);
+    load = cairo_ft_scaled_font_load_glyph_cache (other,
+						  (unsigned char *) buffer.data,
+						  buffer.length,
+						  NULL, NULL);
+    check (ctx, &status, "another size", load,
+	   CAIRO_STATUS_FONT_TYPE_MISMATCH);
+    cairo_scaled_font_destroy (other);
+
+    damaged = (unsigned char *) buffer.data;
+    damaged[0] ^= 0xff;
+    load = cairo_ft_scaled_font_load_glyph_cache (font,
+						  damaged, buffer.length,
+						  NULL, NULL);
+    check (ctx, &status, "damaged", load, CAIRO_STATUS_READ_ERROR);
+    damaged[0] ^= 0xff;
+
+    load = cairo_ft_scaled_font_load_glyph_cache (font,
+						  (unsigned char *) buffer.data,
+						  buffer.length / 2,
+						  NULL, NULL);
+    check (ctx, &status, "truncated", load, CAIRO_STATUS_READ_ERROR);
+
+    cold = create_scaled_font (20);
+    load = cairo_ft_scaled_font_load_glyph_cache (cold,
+						  (unsigned char *) buffer.data,
+						  buffer.length,
+						  free, buffer.data);
+    check (ctx, &status, "same size", load, CAIRO_STATUS_SUCCESS);
+    /* the font now owns the data, and frees it when done */
+    if (load == CAIRO_STATUS_SUCCESS)
+	buffer.data = NULL;
+
+    /* drawn from the loaded glyphs, which must match those rendered */
+    loaded = draw_text (cold);
+    cairo_scaled_font_destroy (cold);
+
+    differ = count_differences (rendered, loaded);
+    cairo_test_log (ctx, "%d pixels differ when drawn from the loaded glyphs\n",
+		    differ);
+    if (differ)
+	status = CAIRO_TEST_FAILURE;
+
+done:
+    cairo_surface_destroy (rendered);
+    if (loaded)
+	cairo_surface_destroy (loaded);
+    cairo_scaled_font_destroy (font);
+    free (buffer.data);
+    return status;
+}
+
+CAIRO_TEST (ft_glyph_cache_file,
+	    "Check that saved glyph caches reload only into matching fonts",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,180 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Draw runs of uncached glyphs from several faces at once on many
+ * threads, so that the threads contend for the faces and the batches are
+ * split between workers, together wanting more copies of the faces than
+ * may be kept open. Each thread must render exactly what a single thread
+ * drawing alone does.
+ *
+ * Only built with real pthreads: cairo only spreads the batch over
+ * threads if the program is linked against them.
+ */
+
+#include "cairo-test.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#define N_THREADS 8
+#define NUM_FACES 12
+#define NUM_GLYPHS 128
+#define COLS 32
+#define CELL 16
+#define WIDTH (COLS * CELL)
+#define ROWS (NUM_GLYPHS / COLS)
+#define HEIGHT (NUM_FACES * ROWS * CELL)
+
+static const char *families[] = {
+    CAIRO_TEST_FONT_FAMILY " Sans",
+    CAIRO_TEST_FONT_FAMILY " Serif",
+    CAIRO_TEST_FONT_FAMILY " Sans Mono",
+};
+
+typedef struct {
+    int id;
+    cairo_surface_t *surface;
+} thread_data_t;
+
+static cairo_surface_t *
+draw_faces (int id)
+{
+    cairo_glyph_t glyphs[NUM_GLYPHS];
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int face, i;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, WIDTH, HEIGHT);
+    cr = cairo_create (surface);
+
+    for (face = 0; face < NUM_FACES; face++) {
+	/* Every thread uses a font of its own that renders identically,
+	 * so that each starts with an empty glyph cache.
+	 */
+	cairo_select_font_face (cr, families[face % 3],
+				face & 4 ? CAIRO_FONT_SLANT_ITALIC :
+					   CAIRO_FONT_SLANT_NORMAL,
+				face & 8 ? CAIRO_FONT_WEIGHT_BOLD :
+					   CAIRO_FONT_WEIGHT_NORMAL);
+	cairo_set_font_size (cr, (9 + face % 4) * (1 + id * 1e-9));
+
+	for (i = 0; i < NUM_GLYPHS; i++) {
+	    glyphs[i].index = i + 3;
+	    glyphs[i].x = (i % COLS) * CELL + 2;
+	    glyphs[i].y = (face * ROWS + i / COLS) * CELL + 12;
+	}
+	cairo_show_glyphs (cr, glyphs, NUM_GLYPHS);
+    }
+
+    if (cairo_status (cr)) {
+	cairo_surface_destroy (surface);
+	surface = NULL;
+    } else
+	cairo_surface_flush (surface);
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+static void *
+draw_thread (void *arg)
+{
+    thread_data_t *data = arg;
+
+    data->surface = draw_faces (data->id);
+    return NULL;
+}
+
+static int
+count_differences (cairo_surface_t *a, cairo_surface_t *b)
+{
+    const uint8_t *pa = cairo_image_surface_get_data (a);
+    const uint8_t *pb = cairo_image_surface_get_data (b);
+    int stride = cairo_image_surface_get_stride (a);
+    int x, y, differ = 0;
+
+    for (y = 0; y < HEIGHT; y++) {
+	for (x = 0; x < WIDTH; x++) {
+	    if (pa[y * stride + x] != pb[y * stride + x])
+		differ++;
+	}
+    }
+
+    return differ;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    thread_data_t data[N_THREADS];
+    pthread_t threads[N_THREADS];
+    cairo_surface_t *reference;
+    int i;
+
+    reference = draw_faces (0);
+    if (reference == NULL) {
+	cairo_test_log (ctx, "drawing the reference failed\n");
+	return CAIRO_TEST_FAILURE;
+    }
+
+    for (i = 0; i < N_THREADS; i++) {
+	data[i].id = i + 1;
+	data[i].surface = NULL;
+	if (pthread_create (&threads[i], NULL, draw_thread, &data[i]) != 0) {
+	    status = cairo_test_status_from_status (ctx, CAIRO_STATUS_NO_MEMORY);
+	    break;
+	}
+    }
+
+    while (i--) {
+	pthread_join (threads[i], NULL);
+
+	if (data[i].surface == NULL) {
+	    if (status == CAIRO_TEST_SUCCESS) {
+		cairo_test_log (ctx, "thread %d failed to draw\n", i);
+		status = CAIRO_TEST_FAILURE;
+	    }
+	    continue;
+	}
+
+	if (status == CAIRO_TEST_SUCCESS) {
+	    int differ = count_differences (reference, data[i].surface);
+
+	    if (differ) {
+		cairo_test_log (ctx, "thread %d: %d pixels differ\n", i, differ);
+		status = CAIRO_TEST_FAILURE;
+	    }
+	}
+	cairo_surface_destroy (data[i].surface);
+    }
+
+    cairo_surface_destroy (reference);
+
+    return status;
+}
+
+CAIRO_TEST (ft_pooled_faces,
+	    "Check that glyphs loaded concurrently from many faces match",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,129 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Draw a long run of glyphs that are not yet cached, so that they are
+ * loaded together (and possibly on several threads), and check that the
+ * result matches drawing the same glyphs one at a time through a font
+ * whose cache is equally cold.
+ *
+ * Only built with real pthreads: cairo only spreads the batch over
+ * threads if the program is linked against them.
+ */
+
+#include "cairo-test.h"
+
+#define NUM_GLYPHS 512
+#define COLS 32
+#define CELL 16
+#define WIDTH (COLS * CELL)
+#define HEIGHT (NUM_GLYPHS / COLS * CELL)
+
+static cairo_surface_t *
+draw_glyphs (cairo_test_context_t *ctx,
+	     double size, cairo_bool_t one_at_a_time)
+{
+    cairo_glyph_t glyphs[NUM_GLYPHS];
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int i;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, WIDTH, HEIGHT);
+    cr = cairo_create (surface);
+
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, size);
+
+    for (i = 0; i < NUM_GLYPHS; i++) {
+	glyphs[i].index = i;
+	glyphs[i].x = (i % COLS) * CELL + 2;
+	glyphs[i].y = (i / COLS) * CELL + 12;
+    }
+
+    if (one_at_a_time) {
+	for (i = 0; i < NUM_GLYPHS; i++)
+	    cairo_show_glyphs (cr, &glyphs[i], 1);
+    } else {
+	cairo_scaled_font_prefetch_glyphs (cairo_get_scaled_font (cr),
+					   glyphs, NUM_GLYPHS);
+	cairo_show_glyphs (cr, glyphs, NUM_GLYPHS);
+    }
+
+    if (cairo_status (cr)) {
+	cairo_test_log (ctx, "drawing failed: %s\n",
+			cairo_status_to_string (cairo_status (cr)));
+	cairo_surface_destroy (surface);
+	surface = NULL;
+    } else
+	cairo_surface_flush (surface);
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *batch, *single;
+    const uint8_t *a, *b;
+    int stride, x, y, differ = 0;
+
+    /* Slightly different sizes so that each font starts with an empty
+     * glyph cache, yet renders identically.
+     */
+    batch = draw_glyphs (ctx, 11, FALSE);
+    single = draw_glyphs (ctx, 11 * (1 + 1e-9), TRUE);
+    if (batch == NULL || single == NULL) {
+	if (batch)
+	    cairo_surface_destroy (batch);
+	if (single)
+	    cairo_surface_destroy (single);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    a = cairo_image_surface_get_data (batch);
+    b = cairo_image_surface_get_data (single);
+    stride = cairo_image_surface_get_stride (batch);
+    for (y = 0; y < HEIGHT; y++) {
+	for (x = 0; x < WIDTH; x++) {
+	    if (a[y * stride + x] != b[y * stride + x])
+		differ++;
+	}
+    }
+
+    cairo_test_log (ctx, "%d pixels differ\n", differ);
+    if (differ)
+	status = CAIRO_TEST_FAILURE;
+
+    cairo_surface_destroy (batch);
+    cairo_surface_destroy (single);
+
+    return status;
+}
+
+CAIRO_TEST (ft_prefetch_glyphs,
+	    "Check that prefetched glyphs match those loaded one at a time",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,237 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Faces for unresolved patterns share a cache of the faces fontconfig
+ * resolved them to, flushed when the configuration changes or fonts are
+ * added to it. Switch to configurations of our own holding one font or
+ * two, and check which font a pattern resolves to: a change of
+ * configuration, or a better font added to the same one, must flush the
+ * cache. With the cache disabled, by setting
+ * CAIRO_FT_RESOLVED_PATTERN_CACHE_SIZE to 0 and having it read again
+ * through cairo_debug_reset_static_data(), even a new rule that adds no
+ * font is seen at once.
+ */
+
+#include "cairo-test.h"
+
+#include <cairo-ft.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FAMILY CAIRO_TEST_FONT_FAMILY " Sans"
+#define OTHER_FAMILY CAIRO_TEST_FONT_FAMILY " Serif"
+#define CACHE_SIZE_ENV "CAIRO_FT_RESOLVED_PATTERN_CACHE_SIZE"
+
+/* Sends FAMILY to OTHER_FAMILY without adding a font */
+#define PREFER_OTHER_FAMILY \
+    "<?xml version=\"1.0\"?>" \
+    "<fontconfig>" \
+    " <match target=\"pattern\">" \
+    "  <test name=\"family\"><string>" FAMILY "</string></test>" \
+    "  <edit name=\"family\" mode=\"assign\" binding=\"strong\">" \
+    "   <string>" OTHER_FAMILY "</string>" \
+    "  </edit>" \
+    " </match>" \
+    "</fontconfig>"
+
+/* Returns the file fontconfig matches @family to, to be freed. */
+static char *
+match_file (const char *family)
+{
+    FcPattern *pattern, *match;
+    FcChar8 *file;
+    FcResult result;
+    char *copy = NULL;
+
+    pattern = FcPatternCreate ();
+    FcPatternAddString (pattern, FC_FAMILY, (FcChar8 *) family);
+    FcConfigSubstitute (NULL, pattern, FcMatchPattern);
+    FcDefaultSubstitute (pattern);
+
+    match = FcFontMatch (NULL, pattern, &result);
+    if (match != NULL) {
+	if (FcPatternGetString (match, FC_FILE, 0, &file) == FcResultMatch)
+	    copy = strdup ((const char *) file);
+	FcPatternDestroy (match);
+    }
+    FcPatternDestroy (pattern);
+
+    return copy;
+}
+
+/* Resolves FAMILY through a new face, so that nothing but the shared
+ * cache remembers earlier resolutions, and returns the family of the
+ * font it ends up with, to be freed.
+ */
+static char *
+resolve_family (void)
+{
+    FcPattern *pattern;
+    cairo_font_face_t *font_face;
+    cairo_font_options_t *options;
+    cairo_scaled_font_t *scaled_font;
+    cairo_matrix_t font_matrix, ctm;
+    char *family = NULL;
+    FT_Face face;
+
+    pattern = FcPatternCreate ();
+    FcPatternAddString (pattern, FC_FAMILY, (FcChar8 *) FAMILY);
+    font_face = cairo_ft_font_face_create_for_pattern (pattern);
+    FcPatternDestroy (pattern);
+
+    options = cairo_font_options_create ();
+    cairo_matrix_init_scale (&font_matrix, 12, 12);
+    cairo_matrix_init_identity (&ctm);
+    scaled_font = cairo_scaled_font_create (font_face,
+					    &font_matrix, &ctm, options);
+    cairo_font_options_destroy (options);
+    cairo_font_face_destroy (font_face);
+
+    face = cairo_ft_scaled_font_lock_face (scaled_font);
+    if (face != NULL) {
+	if (face->family_name != NULL)
+	    family = strdup (face->family_name);
+	cairo_ft_scaled_font_unlock_face (scaled_font);
+    }
+    cairo_scaled_font_destroy (scaled_font);
+
+    return family;
+}
+
+/* Makes a configuration of the single font @file current. */
+static void
+use_config_of (const char *file)
+{
+    FcConfig *config;
+
+    config = FcConfigCreate ();
+    FcConfigAppFontAddFile (config, (const FcChar8 *) file);
+    FcConfigSetCurrent (config);
+    FcConfigDestroy (config);
+}
+
+static void
+check_family (cairo_test_context_t *ctx,
+	      cairo_test_status_t *status,
+	      const char *what,
+	      const char *expected)
+{
+    char *family = resolve_family ();
+
+    if (family == NULL || strcmp (family, expected)) {
+	cairo_test_log (ctx, "%s: expected \"%s\", resolved to \"%s\"\n",
+			what, expected, family ? family : "(nothing)");
+	*status = CAIRO_TEST_FAILURE;
+    }
+
+    free (family);
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    char *file, *other_file, *family, *other_family, *cache_size;
+    FcConfig *original;
+
+    file = match_file (FAMILY);
+    other_file = match_file (OTHER_FAMILY);
+    family = resolve_family ();
+    if (file == NULL || other_file == NULL || family == NULL ||
+	strcmp (file, other_file) == 0)
+    {
+	cairo_test_log (ctx, "need distinct fonts for \"%s\" and \"%s\"\n",
+			FAMILY, OTHER_FAMILY);
+	free (file);
+	free (other_file);
+	free (family);
+	return CAIRO_TEST_UNTESTED;
+    }
+
+    cache_size = getenv (CACHE_SIZE_ENV);
+    if (cache_size != NULL)
+	cache_size = strdup (cache_size);
+    unsetenv (CACHE_SIZE_ENV);
+
+    original = FcConfigReference (NULL);
+
+    /* With only the other font to be had, the pattern resolves to it,
+     * which it cannot if the cache still held the earlier face.
+     */
+    use_config_of (other_file);
+    other_family = resolve_family ();
+    if (other_family == NULL || strcmp (other_family, family) == 0) {
+	cairo_test_log (ctx, "not flushed on a change of configuration: "
+			"still resolved to \"%s\"\n", family);
+	status = CAIRO_TEST_FAILURE;
+	goto restore;
+    }
+
+    /* The configuration is the same, but the better match added to it
+     * must be seen rather than the face found in the cache.
+     */
+    FcConfigAppFontAddFile (NULL, (const FcChar8 *) file);
+    check_family (ctx, &status, "font added", family);
+    check_family (ctx, &status, "font added, resolved again", family);
+
+    /* A rule changes neither the configuration nor its fonts, so only
+     * with the cache disabled is it certain to be seen.
+     */
+    setenv (CACHE_SIZE_ENV, "0", 1);
+    cairo_debug_reset_static_data ();
+    check_family (ctx, &status, "cache disabled", family);
+    if (! FcConfigParseAndLoadFromMemory (NULL,
+					  (const FcChar8 *) PREFER_OTHER_FAMILY,
+					  FcTrue))
+    {
+	cairo_test_log (ctx, "could not load the rule\n");
+	status = CAIRO_TEST_FAILURE;
+	goto restore;
+    }
+    check_family (ctx, &status, "cache disabled, rule added", other_family);
+
+restore:
+    if (cache_size != NULL)
+	setenv (CACHE_SIZE_ENV, cache_size, 1);
+    else
+	unsetenv (CACHE_SIZE_ENV);
+    free (cache_size);
+
+    FcConfigSetCurrent (original);
+    FcConfigDestroy (original);
+
+    /* so that the size of the cache is read again */
+    cairo_debug_reset_static_data ();
+
+    free (file);
+    free (other_file);
+    free (family);
+    free (other_family);
+
+    return status;
+}
+
+CAIRO_TEST (ft_resolved_pattern_cache,
+	    "Check that resolved patterns are cached until fontconfig changes",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
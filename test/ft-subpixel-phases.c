@@ -0,0 +1,237 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Draw the same text at fractional offsets, with and without subpixel
+ * phases. Without them, a glyph snaps to whole pixels; with four
+ * phases, the ink must move by the fraction asked for (to within half
+ * a phase), and text a whole pixel further along must be an exact
+ * copy of the same phase.
+ *
+ * Fonts whose backend cannot render the phases, such as user fonts,
+ * must be placed just as if no phases had been asked for, and must be
+ * given their glyph indices whole, however large.
+ */
+
+#include "cairo-test.h"
+
+#define WIDTH 96
+#define HEIGHT 24
+#define TEXT "Hamburgefonts"
+
+static cairo_surface_t *
+draw_text (int phases, double x, const char *text)
+{
+    cairo_font_options_t *options;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, WIDTH, HEIGHT);
+    cr = cairo_create (surface);
+
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 10);
+
+    options = cairo_font_options_create ();
+    cairo_font_options_set_antialias (options, CAIRO_ANTIALIAS_GRAY);
+    cairo_font_options_set_hint_style (options, CAIRO_HINT_STYLE_NONE);
+    cairo_font_options_set_hint_metrics (options, CAIRO_HINT_METRICS_OFF);
+    cairo_font_options_set_subpixel_phases (options, phases);
+    cairo_set_font_options (cr, options);
+    cairo_font_options_destroy (options);
+
+    cairo_move_to (cr, x, 16);
+    cairo_show_text (cr, text);
+
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    return surface;
+}
+
+#define USER_GLYPH 0x12345678
+
+static unsigned long user_glyph_rendered;
+
+static cairo_status_t
+render_user_glyph (cairo_scaled_font_t  *scaled_font,
+		   unsigned long         glyph,
+		   cairo_t              *cr,
+		   cairo_text_extents_t *extents)
+{
+    user_glyph_rendered = glyph;
+
+    cairo_rectangle (cr, .1, -.7, .5, .7);
+    cairo_fill (cr);
+
+    extents->x_advance = .7;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+draw_user_glyph (cairo_font_face_t *face, int phases, double x)
+{
+    cairo_font_options_t *options;
+    cairo_surface_t *surface;
+    cairo_glyph_t glyph;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, WIDTH, HEIGHT);
+    cr = cairo_create (surface);
+
+    cairo_set_font_face (cr, face);
+    cairo_set_font_size (cr, 10);
+
+    options = cairo_font_options_create ();
+    cairo_font_options_set_antialias (options, CAIRO_ANTIALIAS_GRAY);
+    cairo_font_options_set_subpixel_phases (options, phases);
+    cairo_set_font_options (cr, options);
+    cairo_font_options_destroy (options);
+
+    glyph.index = USER_GLYPH;
+    glyph.x = x;
+    glyph.y = 16;
+    cairo_show_glyphs (cr, &glyph, 1);
+
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    return surface;
+}
+
+static double
+centroid (cairo_surface_t *surface)
+{
+    const uint8_t *data = cairo_image_surface_get_data (surface);
+    int stride = cairo_image_surface_get_stride (surface);
+    double sum = 0, weight = 0;
+    int x, y;
+
+    for (y = 0; y < HEIGHT; y++) {
+	for (x = 0; x < WIDTH; x++) {
+	    sum += x * data[y * stride + x];
+	    weight += data[y * stride + x];
+	}
+    }
+
+    return weight ? sum / weight : 0;
+}
+
+/* Counts the pixels of @a that differ from those of @b moved @dx left. */
+static int
+compare (cairo_surface_t *a, cairo_surface_t *b, int dx)
+{
+    const uint8_t *pa = cairo_image_surface_get_data (a);
+    const uint8_t *pb = cairo_image_surface_get_data (b);
+    int stride = cairo_image_surface_get_stride (a);
+    int x, y, differ = 0;
+
+    for (y = 0; y < HEIGHT; y++) {
+	for (x = 0; x + dx < WIDTH; x++) {
+	    if (pa[y * stride + x] != pb[y * stride + x + dx])
+		differ++;
+	}
+    }
+
+    return differ;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_font_options_t *options;
+    cairo_font_face_t *user_face;
+    cairo_surface_t *whole, *whole_quarter;
+    cairo_surface_t *base, *half, *next_half;
+    double shift, x;
+    int differ;
+
+    options = cairo_font_options_create ();
+    cairo_font_options_set_subpixel_phases (options, 100);
+    if (cairo_font_options_get_subpixel_phases (options) != 16) {
+	cairo_test_log (ctx, "subpixel phases not clamped: %d\n",
+			cairo_font_options_get_subpixel_phases (options));
+	status = CAIRO_TEST_FAILURE;
+    }
+    cairo_font_options_destroy (options);
+
+    whole = draw_text (0, 4, "H");
+    whole_quarter = draw_text (0, 4.25, "H");
+    differ = compare (whole, whole_quarter, 0);
+    cairo_test_log (ctx, "without phases, %d pixels move\n", differ);
+    if (differ)
+	status = CAIRO_TEST_FAILURE;
+
+    base = draw_text (4, 4, TEXT);
+    half = draw_text (4, 4.5, TEXT);
+    next_half = draw_text (4, 5.5, TEXT);
+
+    shift = centroid (half) - centroid (base);
+    cairo_test_log (ctx, "with 4 phases, half a pixel moves the ink by %f\n",
+		    shift);
+    if (fabs (shift - .5) > .125)
+	status = CAIRO_TEST_FAILURE;
+
+    differ = compare (half, next_half, 1);
+    cairo_test_log (ctx, "%d pixels differ a pixel later\n", differ);
+    if (differ)
+	status = CAIRO_TEST_FAILURE;
+
+    cairo_surface_destroy (whole);
+    cairo_surface_destroy (whole_quarter);
+    cairo_surface_destroy (base);
+    cairo_surface_destroy (half);
+    cairo_surface_destroy (next_half);
+
+    user_face = cairo_user_font_face_create ();
+    cairo_user_font_face_set_render_glyph_func (user_face, render_user_glyph);
+    for (x = 4; x < 5; x += .25) {
+	whole = draw_user_glyph (user_face, 0, x);
+	base = draw_user_glyph (user_face, 4, x);
+
+	differ = compare (whole, base, 0);
+	cairo_test_log (ctx, "user font at %.2f: %d pixels differ with phases\n",
+			x, differ);
+	if (differ)
+	    status = CAIRO_TEST_FAILURE;
+
+	cairo_surface_destroy (whole);
+	cairo_surface_destroy (base);
+    }
+    cairo_font_face_destroy (user_face);
+
+    if (user_glyph_rendered != USER_GLYPH) {
+	cairo_test_log (ctx, "user font asked for glyph %lx, not %lx\n",
+			user_glyph_rendered, (unsigned long) USER_GLYPH);
+	status = CAIRO_TEST_FAILURE;
+    }
+
+    return status;
+}
+
+CAIRO_TEST (ft_subpixel_phases,
+	    "Check that glyphs are rendered at subpixel phases when asked",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
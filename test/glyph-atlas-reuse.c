@@ -0,0 +1,181 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Small glyph images are packed into a shared atlas, whose space is
+ * handed back as glyphs are evicted and then given to others. Draw some
+ * text with a font we keep alive, churn through enough other fonts for
+ * their glyphs to be stored and released many times over, and check
+ * that the text drawn again (from the kept font, and from a fresh one
+ * whose glyphs land in reused space) still matches the original.
+ */
+
+#include "cairo-test.h"
+
+#define WIDTH 256
+#define HEIGHT 40
+#define NUM_CHURN 400
+#define SIZE 12
+
+static const char text[] = "The quick brown fox jumps over 1234567890";
+
+static cairo_scaled_font_t *
+create_font (cairo_antialias_t antialias, double size)
+{
+    cairo_font_face_t *face;
+    cairo_font_options_t *options;
+    cairo_scaled_font_t *scaled_font;
+    cairo_matrix_t font_matrix, ctm;
+
+    face = cairo_toy_font_face_create (CAIRO_TEST_FONT_FAMILY " Sans",
+				       CAIRO_FONT_SLANT_NORMAL,
+				       CAIRO_FONT_WEIGHT_NORMAL);
+    options = cairo_font_options_create ();
+    cairo_font_options_set_antialias (options, antialias);
+    cairo_font_options_set_hint_metrics (options, CAIRO_HINT_METRICS_OFF);
+    cairo_matrix_init_scale (&font_matrix, size, size);
+    cairo_matrix_init_identity (&ctm);
+
+    scaled_font = cairo_scaled_font_create (face, &font_matrix, &ctm, options);
+
+    cairo_font_options_destroy (options);
+    cairo_font_face_destroy (face);
+
+    return scaled_font;
+}
+
+static cairo_surface_t *
+draw_text (cairo_scaled_font_t *scaled_font)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, WIDTH, HEIGHT);
+    cr = cairo_create (surface);
+
+    cairo_set_scaled_font (cr, scaled_font);
+    cairo_move_to (cr, 2, 14);
+    cairo_show_text (cr, text);
+    cairo_move_to (cr, 2, 34);
+    cairo_show_text (cr, text);
+
+    if (cairo_status (cr)) {
+	cairo_surface_destroy (surface);
+	surface = NULL;
+    } else
+	cairo_surface_flush (surface);
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+static cairo_bool_t
+surfaces_equal (cairo_surface_t *a, cairo_surface_t *b)
+{
+    const uint8_t *pa = cairo_image_surface_get_data (a);
+    const uint8_t *pb = cairo_image_surface_get_data (b);
+    int stride = cairo_image_surface_get_stride (a);
+    int y;
+
+    for (y = 0; y < HEIGHT; y++) {
+	if (memcmp (pa + y * stride, pb + y * stride, WIDTH))
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+static cairo_test_status_t
+check_antialias (cairo_test_context_t *ctx, cairo_antialias_t antialias)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_scaled_font_t *kept, *fresh;
+    cairo_surface_t *reference, *image;
+    int i;
+
+    kept = create_font (antialias, SIZE);
+    reference = draw_text (kept);
+    if (reference == NULL) {
+	cairo_scaled_font_destroy (kept);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    /* Each font is dropped as soon as it has been used, so that once the
+     * holdovers are full every new font evicts the glyphs of an old one.
+     */
+    for (i = 0; i < NUM_CHURN; i++) {
+	cairo_scaled_font_t *scaled_font;
+
+	scaled_font = create_font (antialias, 6 + i * .0625);
+	image = draw_text (scaled_font);
+	cairo_scaled_font_destroy (scaled_font);
+
+	if (image == NULL) {
+	    cairo_test_log (ctx, "churning font %d failed\n", i);
+	    status = CAIRO_TEST_FAILURE;
+	    goto DONE;
+	}
+	cairo_surface_destroy (image);
+    }
+
+    image = draw_text (kept);
+    if (image == NULL || ! surfaces_equal (reference, image)) {
+	cairo_test_log (ctx, "antialias %d: kept font differs\n", antialias);
+	status = CAIRO_TEST_FAILURE;
+    }
+    if (image != NULL)
+	cairo_surface_destroy (image);
+
+    /* renders identically, but loads every glyph anew */
+    fresh = create_font (antialias, SIZE * (1 + 1e-9));
+    image = draw_text (fresh);
+    if (image == NULL || ! surfaces_equal (reference, image)) {
+	cairo_test_log (ctx, "antialias %d: fresh font differs\n", antialias);
+	status = CAIRO_TEST_FAILURE;
+    }
+    if (image != NULL)
+	cairo_surface_destroy (image);
+    cairo_scaled_font_destroy (fresh);
+
+DONE:
+    cairo_surface_destroy (reference);
+    cairo_scaled_font_destroy (kept);
+
+    return status;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status;
+
+    status = check_antialias (ctx, CAIRO_ANTIALIAS_GRAY);
+    if (status == CAIRO_TEST_SUCCESS)
+	status = check_antialias (ctx, CAIRO_ANTIALIAS_NONE);
+
+    return status;
+}
+
+CAIRO_TEST (glyph_atlas_reuse,
+	    "Check that glyphs survive their atlas space being reused",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
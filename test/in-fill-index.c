@@ -0,0 +1,196 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Repeatedly hit-test a path with many edges, which is answered from an
+ * index of its edges after the first query, and check every answer
+ * against a fresh copy of the path queried only once, across both fill
+ * rules, a change of tolerance and an extension of the path.
+ *
+ * Also check a square one side of which is a curve whose control points
+ * coincide with its ends: it is still a straight edge and must count.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 100
+#define STEP 1.25
+
+static void
+build_path (cairo_t *cr)
+{
+    int i;
+
+    /* a circle and a star, all curves and all lines */
+    cairo_arc (cr, 30, 30, 25, 0, 2 * M_PI);
+    cairo_close_path (cr);
+
+    cairo_move_to (cr, 70, 5);
+    for (i = 1; i < 11; i++) {
+	double a = i * 4 * M_PI / 11;
+	cairo_line_to (cr, 70 + 25 * sin (a), 30 - 25 * cos (a));
+    }
+    cairo_close_path (cr);
+
+    /* overlapping the star with a rounded rectangle of the other direction */
+    cairo_move_to (cr, 55, 20);
+    cairo_line_to (cr, 55, 90);
+    cairo_curve_to (cr, 55, 95, 60, 95, 65, 95);
+    cairo_line_to (cr, 95, 95);
+    cairo_line_to (cr, 95, 25);
+    cairo_curve_to (cr, 95, 20, 90, 15, 85, 15);
+    cairo_close_path (cr);
+
+    /* a small spiral of curves */
+    cairo_move_to (cr, 25, 75);
+    for (i = 0; i < 8; i++) {
+	double r = 4 + 2.5 * i;
+	cairo_curve_to (cr,
+			25 + r, 75 - r,
+			25 + r, 75 + r,
+			25 - r, 75 + r);
+    }
+    cairo_close_path (cr);
+}
+
+static cairo_test_status_t
+check_grid (const cairo_test_context_t *ctx,
+	    cairo_t *cr, cairo_t *ref, const char *what)
+{
+    cairo_path_t *path;
+    double x, y;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+
+    path = cairo_copy_path (cr);
+    cairo_set_fill_rule (ref, cairo_get_fill_rule (cr));
+    cairo_set_tolerance (ref, cairo_get_tolerance (cr));
+
+    for (y = -STEP; y <= SIZE + STEP && ret == CAIRO_TEST_SUCCESS; y += STEP) {
+	for (x = -STEP; x <= SIZE + STEP; x += STEP) {
+	    cairo_bool_t expected, got;
+
+	    /* a new path is walked in full on its first query */
+	    cairo_new_path (ref);
+	    cairo_append_path (ref, path);
+	    expected = cairo_in_fill (ref, x, y);
+
+	    got = cairo_in_fill (cr, x, y);
+	    if (got != expected) {
+		cairo_test_log (ctx,
+				"Error: %s: (%g, %g) is %s, expected %s\n",
+				what, x, y,
+				got ? "inside" : "outside",
+				expected ? "inside" : "outside");
+		ret = CAIRO_TEST_FAILURE;
+		break;
+	    }
+	}
+    }
+
+    cairo_path_destroy (path);
+
+    return ret;
+}
+
+static cairo_test_status_t
+check_degenerate_curve (const cairo_test_context_t *ctx, cairo_t *cr)
+{
+    const struct {
+	double x, y;
+	cairo_bool_t inside;
+    } points[] = {
+	{ 50, 50, TRUE },
+	{ 12, 50, TRUE },
+	{ 5, 50, FALSE },
+	{ 95, 50, FALSE },
+    };
+    unsigned int i, n;
+
+    cairo_new_path (cr);
+    cairo_move_to (cr, 10, 10);
+    cairo_line_to (cr, 90, 10);
+    cairo_line_to (cr, 90, 90);
+    cairo_line_to (cr, 10, 90);
+    cairo_curve_to (cr, 10, 90, 10, 10, 10, 10);
+    cairo_close_path (cr);
+
+    /* ask more than once, to use both the walk and the index */
+    for (n = 0; n < 3; n++) {
+	for (i = 0; i < ARRAY_LENGTH (points); i++) {
+	    if (cairo_in_fill (cr, points[i].x, points[i].y) != points[i].inside) {
+		cairo_test_log (ctx,
+				"Error: degenerate curve: (%g, %g) should be %s\n",
+				points[i].x, points[i].y,
+				points[i].inside ? "inside" : "outside");
+		return CAIRO_TEST_FAILURE;
+	    }
+	}
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr, *ref;
+    cairo_test_status_t ret;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 0, 0);
+    cr = cairo_create (surface);
+    ref = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    build_path (cr);
+
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_WINDING);
+    ret = check_grid (ctx, cr, ref, "winding");
+
+    if (ret == CAIRO_TEST_SUCCESS) {
+	cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+	ret = check_grid (ctx, cr, ref, "even-odd");
+    }
+
+    if (ret == CAIRO_TEST_SUCCESS) {
+	cairo_set_tolerance (cr, 2.);
+	ret = check_grid (ctx, cr, ref, "coarse tolerance");
+    }
+
+    if (ret == CAIRO_TEST_SUCCESS) {
+	cairo_rectangle (cr, 40, 40, 30, 30);
+	ret = check_grid (ctx, cr, ref, "extended path");
+    }
+
+    if (ret == CAIRO_TEST_SUCCESS)
+	ret = check_degenerate_curve (ctx, cr);
+
+    cairo_destroy (ref);
+    cairo_destroy (cr);
+
+    return ret;
+}
+
+CAIRO_TEST (in_fill_index,
+	    "Check repeated cairo_in_fill() on a complex path against single queries",
+	    "in, fill", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,188 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Fill the result of each boolean operation on a pair of overlapping
+ * paths, under either fill rule, and check pixel by pixel that it covers
+ * exactly what the operation applied to the fills of the operands would.
+ * Without antialiasing, only pixels whose centres lie within rounding
+ * error of an edge may disagree.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 64
+
+static const cairo_path_combine_op_t ops[] = {
+    CAIRO_PATH_COMBINE_UNION,
+    CAIRO_PATH_COMBINE_INTERSECT,
+    CAIRO_PATH_COMBINE_DIFFERENCE,
+    CAIRO_PATH_COMBINE_XOR,
+};
+
+static void
+shape_a (cairo_t *cr)
+{
+    /* two overlapping discs, so that the fill rule matters */
+    cairo_arc (cr, 24, 28, 16, 0, 2 * M_PI);
+    cairo_new_sub_path (cr);
+    cairo_arc (cr, 36, 24, 12, 0, 2 * M_PI);
+}
+
+static void
+shape_b (cairo_t *cr)
+{
+    /* a self-intersecting star beside a rectangle */
+    cairo_move_to (cr, 40, 6);
+    cairo_line_to (cr, 52, 58);
+    cairo_line_to (cr, 14, 24);
+    cairo_line_to (cr, 62, 24);
+    cairo_line_to (cr, 20, 58);
+    cairo_close_path (cr);
+    cairo_rectangle (cr, 4.5, 44.25, 30, 12);
+}
+
+static cairo_surface_t *
+fill (cairo_path_t *path, cairo_fill_rule_t fill_rule)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_NONE);
+    cairo_set_fill_rule (cr, fill_rule);
+    cairo_append_path (cr, path);
+    cairo_fill (cr);
+
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    return surface;
+}
+
+static cairo_bool_t
+combine (cairo_path_combine_op_t op, cairo_bool_t a, cairo_bool_t b)
+{
+    switch (op) {
+    case CAIRO_PATH_COMBINE_UNION: return a || b;
+    case CAIRO_PATH_COMBINE_INTERSECT: return a && b;
+    case CAIRO_PATH_COMBINE_DIFFERENCE: return a && ! b;
+    case CAIRO_PATH_COMBINE_XOR: return a != b;
+    }
+    return FALSE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *surface;
+    cairo_path_t *a, *b;
+    cairo_t *cr;
+    unsigned int n, rule;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+    shape_a (cr);
+    a = cairo_copy_path (cr);
+    cairo_new_path (cr);
+    shape_b (cr);
+    b = cairo_copy_path (cr);
+    cairo_destroy (cr);
+    cairo_surface_destroy (surface);
+
+    for (rule = 0; rule < 4; rule++) {
+	cairo_fill_rule_t rule_a = rule & 1 ? CAIRO_FILL_RULE_EVEN_ODD : CAIRO_FILL_RULE_WINDING;
+	cairo_fill_rule_t rule_b = rule & 2 ? CAIRO_FILL_RULE_EVEN_ODD : CAIRO_FILL_RULE_WINDING;
+	cairo_surface_t *fill_a, *fill_b;
+
+	fill_a = fill (a, rule_a);
+	fill_b = fill (b, rule_b);
+
+	for (n = 0; n < ARRAY_LENGTH (ops); n++) {
+	    cairo_surface_t *result_even_odd, *result_winding;
+	    const uint8_t *pa, *pb, *pw, *pe;
+	    cairo_path_t *path;
+	    int stride, x, y;
+	    int wrong = 0, differ = 0;
+
+	    path = cairo_path_combine (a, rule_a, b, rule_b, ops[n], 0.1);
+	    if (path->status) {
+		cairo_test_log (ctx, "op %d, rules %d: %s\n",
+				ops[n], rule,
+				cairo_status_to_string (path->status));
+		cairo_path_destroy (path);
+		status = CAIRO_TEST_FAILURE;
+		continue;
+	    }
+
+	    /* the contours do not overlap, so the fill rule is immaterial */
+	    result_winding = fill (path, CAIRO_FILL_RULE_WINDING);
+	    result_even_odd = fill (path, CAIRO_FILL_RULE_EVEN_ODD);
+	    cairo_path_destroy (path);
+
+	    pa = cairo_image_surface_get_data (fill_a);
+	    pb = cairo_image_surface_get_data (fill_b);
+	    pw = cairo_image_surface_get_data (result_winding);
+	    pe = cairo_image_surface_get_data (result_even_odd);
+	    stride = cairo_image_surface_get_stride (fill_a);
+
+	    for (y = 0; y < SIZE; y++) {
+		for (x = 0; x < SIZE; x++) {
+		    int i = y * stride + x;
+		    cairo_bool_t expected;
+
+		    expected = combine (ops[n], pa[i] != 0, pb[i] != 0);
+		    if (expected != (pw[i] != 0))
+			wrong++;
+		    if (pw[i] != pe[i])
+			differ++;
+		}
+	    }
+
+	    cairo_test_log (ctx,
+			    "op %d, rules %d: %d pixels wrong, %d differ between fill rules\n",
+			    ops[n], rule, wrong, differ);
+
+	    if (wrong > SIZE / 8 || differ)
+		status = CAIRO_TEST_FAILURE;
+
+	    cairo_surface_destroy (result_winding);
+	    cairo_surface_destroy (result_even_odd);
+	}
+
+	cairo_surface_destroy (fill_a);
+	cairo_surface_destroy (fill_b);
+    }
+
+    cairo_path_destroy (a);
+    cairo_path_destroy (b);
+
+    return status;
+}
+
+CAIRO_TEST (path_combine,
+	    "Check boolean operations on paths against the fills of their operands",
+	    "path, fill", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,203 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Simplify a dense, slightly noisy track and check that far fewer
+ * points remain, that the ends of the track are kept exactly, and that
+ * every original point stays close to the simplified line. Then check
+ * that curves are kept or flattened as requested.
+ */
+
+#include "cairo-test.h"
+
+#define NUM_POINTS 4000
+#define TOLERANCE 0.5
+
+static double
+segment_distance (double px, double py,
+		  double x1, double y1,
+		  double x2, double y2)
+{
+    double dx = x2 - x1, dy = y2 - y1;
+    double t = 0;
+
+    if (dx || dy)
+	t = ((px - x1) * dx + (py - y1) * dy) / (dx * dx + dy * dy);
+    if (t < 0)
+	t = 0;
+    else if (t > 1)
+	t = 1;
+
+    return hypot (x1 + t * dx - px, y1 + t * dy - py);
+}
+
+static int
+count_type (const cairo_path_t *path, cairo_path_data_type_t type)
+{
+    int i, count = 0;
+
+    for (i = 0; i < path->num_data; i += path->data[i].header.length) {
+	if (path->data[i].header.type == type)
+	    count++;
+    }
+
+    return count;
+}
+
+static cairo_test_status_t
+check_track (cairo_test_context_t *ctx, cairo_t *cr)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_path_t *track, *simple;
+    double worst = 0;
+    int i, j, n;
+
+    cairo_new_path (cr);
+    for (i = 0; i < NUM_POINTS; i++) {
+	double t = i / (double) NUM_POINTS;
+	/* a deterministic wobble well below the tolerance */
+	double noise = .1 * sin (i * 7.3);
+
+	cairo_line_to (cr, 400 * t, 100 + 80 * sin (t * 12) + noise);
+    }
+    track = cairo_copy_path (cr);
+
+    simple = cairo_path_simplify (track, TOLERANCE, FALSE);
+    if (simple->status) {
+	cairo_test_log (ctx, "simplify failed: %s\n",
+			cairo_status_to_string (simple->status));
+	cairo_path_destroy (simple);
+	cairo_path_destroy (track);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    n = simple->num_data;
+    for (i = 0; i < track->num_data; i += 2) {
+	const cairo_path_data_t *p = &track->data[i+1];
+	double best = HUGE_VAL;
+
+	for (j = 0; j + 2 < n; j += 2) {
+	    double d = segment_distance (p->point.x, p->point.y,
+					 simple->data[j+1].point.x,
+					 simple->data[j+1].point.y,
+					 simple->data[j+3].point.x,
+					 simple->data[j+3].point.y);
+	    if (d < best)
+		best = d;
+	}
+	if (best > worst)
+	    worst = best;
+    }
+
+    cairo_test_log (ctx, "track of %d points simplified to %d, max error %f\n",
+		    track->num_data / 2, n / 2, worst);
+
+    if (n / 2 > NUM_POINTS / 20 || worst > 2 * TOLERANCE)
+	status = CAIRO_TEST_FAILURE;
+
+    if (n < 4 ||
+	simple->data[1].point.x != track->data[1].point.x ||
+	simple->data[1].point.y != track->data[1].point.y ||
+	simple->data[n-1].point.x != track->data[track->num_data-1].point.x ||
+	simple->data[n-1].point.y != track->data[track->num_data-1].point.y)
+    {
+	cairo_test_log (ctx, "end points of the track were not preserved\n");
+	status = CAIRO_TEST_FAILURE;
+    }
+
+    cairo_path_destroy (simple);
+    cairo_path_destroy (track);
+
+    return status;
+}
+
+static cairo_test_status_t
+check_curves (cairo_test_context_t *ctx, cairo_t *cr)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_path_t *path, *kept, *flat;
+
+    cairo_new_path (cr);
+    cairo_move_to (cr, 0, 0);
+    cairo_line_to (cr, 10, 0.01);
+    cairo_line_to (cr, 20, 0);
+    cairo_curve_to (cr, 30, 0, 40, 10, 40, 20);
+    cairo_line_to (cr, 40, 40);
+    cairo_close_path (cr);
+    path = cairo_copy_path (cr);
+
+    kept = cairo_path_simplify (path, TOLERANCE, TRUE);
+    flat = cairo_path_simplify (path, TOLERANCE, FALSE);
+
+    if (kept->status || flat->status) {
+	cairo_test_log (ctx, "simplify failed\n");
+	status = CAIRO_TEST_FAILURE;
+    } else {
+	/* the nearly straight start collapses to a single line */
+	if (count_type (kept, CAIRO_PATH_CURVE_TO) != 1 ||
+	    count_type (kept, CAIRO_PATH_LINE_TO) != 2)
+	{
+	    cairo_test_log (ctx, "curve not preserved: %d curves, %d lines\n",
+			    count_type (kept, CAIRO_PATH_CURVE_TO),
+			    count_type (kept, CAIRO_PATH_LINE_TO));
+	    status = CAIRO_TEST_FAILURE;
+	}
+
+	if (count_type (flat, CAIRO_PATH_CURVE_TO) != 0 ||
+	    count_type (flat, CAIRO_PATH_CLOSE_PATH) != 1)
+	{
+	    cairo_test_log (ctx, "curve not flattened\n");
+	    status = CAIRO_TEST_FAILURE;
+	}
+    }
+
+    cairo_path_destroy (kept);
+    cairo_path_destroy (flat);
+    cairo_path_destroy (path);
+
+    return status;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    status = check_track (ctx, cr);
+    if (status == CAIRO_TEST_SUCCESS)
+	status = check_curves (ctx, cr);
+
+    cairo_destroy (cr);
+
+    return status;
+}
+
+CAIRO_TEST (path_simplify,
+	    "Check that simplified paths keep their shape with fewer points",
+	    "path", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,130 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Stroke rectilinear paths that double back on themselves, with butt
+ * caps. A round join at the reversal draws a half disc beyond the
+ * turning point, while bevel and miter joins end flush with it, so a
+ * round join must not be reduced to boxes like the others. Check both
+ * an explicit reversal and a close_path that doubles back onto the
+ * start of the subpath.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 40
+
+typedef struct {
+    int x, y;
+    cairo_bool_t inked;
+} probe_t;
+
+static cairo_test_status_t
+check (const cairo_test_context_t *ctx,
+       const char *what,
+       cairo_bool_t close_path,
+       cairo_line_join_t join,
+       const probe_t *probes, int num_probes)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    const unsigned char *data;
+    int stride, i;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, SIZE, SIZE);
+    cr = cairo_create (surface);
+
+    cairo_translate (cr, 20, 20);
+    cairo_set_line_width (cr, 4);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_BUTT);
+    cairo_set_line_join (cr, join);
+
+    cairo_move_to (cr, 0, 0);
+    cairo_line_to (cr, 10, 0);
+    if (close_path)
+	cairo_close_path (cr);
+    else
+	cairo_line_to (cr, 5, 0);
+    cairo_stroke (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_flush (surface);
+    data = cairo_image_surface_get_data (surface);
+    stride = cairo_image_surface_get_stride (surface);
+    for (i = 0; i < num_probes; i++) {
+	int alpha = data[probes[i].y * stride + probes[i].x];
+
+	if (probes[i].inked ? alpha < 0x80 : alpha != 0) {
+	    cairo_test_log (ctx,
+			    "Error: %s: pixel (%d, %d) has alpha %d, expected it %s\n",
+			    what, probes[i].x, probes[i].y, alpha,
+			    probes[i].inked ? "inked" : "clear");
+	    ret = CAIRO_TEST_FAILURE;
+	}
+    }
+
+    cairo_surface_destroy (surface);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    /* The line covers x in [20, 30], y in [18, 22]; a round join at
+     * either end reaches 2 pixels further out. */
+    const probe_t reversal_round[] = {
+	{ 25, 19, TRUE }, { 30, 19, TRUE }, { 30, 20, TRUE },
+	{ 19, 19, FALSE },
+    };
+    const probe_t reversal_flush[] = {
+	{ 25, 19, TRUE }, { 30, 19, FALSE }, { 30, 20, FALSE },
+    };
+    const probe_t closed_round[] = {
+	{ 25, 19, TRUE }, { 30, 19, TRUE }, { 19, 20, TRUE },
+    };
+    const probe_t closed_flush[] = {
+	{ 25, 19, TRUE }, { 30, 19, FALSE }, { 19, 20, FALSE },
+    };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+
+#define CHECK(what, close, join, probes) \
+    if (check (ctx, what, close, join, probes, ARRAY_LENGTH (probes))) \
+	ret = CAIRO_TEST_FAILURE
+
+    CHECK ("reversal, round", FALSE, CAIRO_LINE_JOIN_ROUND, reversal_round);
+    CHECK ("reversal, bevel", FALSE, CAIRO_LINE_JOIN_BEVEL, reversal_flush);
+    CHECK ("reversal, miter", FALSE, CAIRO_LINE_JOIN_MITER, reversal_flush);
+    CHECK ("closed, round", TRUE, CAIRO_LINE_JOIN_ROUND, closed_round);
+    CHECK ("closed, bevel", TRUE, CAIRO_LINE_JOIN_BEVEL, closed_flush);
+    CHECK ("closed, miter", TRUE, CAIRO_LINE_JOIN_MITER, closed_flush);
+
+#undef CHECK
+
+    return ret;
+}
+
+CAIRO_TEST (rectilinear_reversal,
+	    "Check the joins of rectilinear strokes that double back",
+	    "stroke, line-join", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,116 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Check that the extents of a run of glyphs fetched in one call match
+ * those of each glyph fetched on its own, and that bad arguments are
+ * caught.
+ */
+
+#include "cairo-test.h"
+
+#define TEXT "The five boxing wizards jump quickly, and then jump again."
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    cairo_scaled_font_t *scaled_font;
+    cairo_text_extents_t *extents;
+    unsigned long *indices;
+    cairo_surface_t *surface;
+    cairo_glyph_t *glyphs = NULL;
+    cairo_status_t status;
+    int num_glyphs = 0;
+    cairo_t *cr;
+    int i;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 13);
+    scaled_font = cairo_get_scaled_font (cr);
+
+    status = cairo_scaled_font_text_to_glyphs (scaled_font, 0, 0,
+					       TEXT, -1,
+					       &glyphs, &num_glyphs,
+					       NULL, NULL, NULL);
+    if (status) {
+	cairo_destroy (cr);
+	return cairo_test_status_from_status (ctx, status);
+    }
+
+    indices = xmalloc (num_glyphs * sizeof (unsigned long));
+    extents = xmalloc (num_glyphs * sizeof (cairo_text_extents_t));
+    for (i = 0; i < num_glyphs; i++)
+	indices[i] = glyphs[i].index;
+
+    status = cairo_scaled_font_glyph_extents_array (scaled_font,
+						    indices, num_glyphs,
+						    extents);
+    if (status) {
+	result = cairo_test_status_from_status (ctx, status);
+	goto done;
+    }
+
+    for (i = 0; i < num_glyphs; i++) {
+	cairo_glyph_t glyph = { indices[i], 0, 0 };
+	cairo_text_extents_t single;
+
+	cairo_scaled_font_glyph_extents (scaled_font, &glyph, 1, &single);
+	if (fabs (single.x_bearing - extents[i].x_bearing) > 1e-9 ||
+	    fabs (single.y_bearing - extents[i].y_bearing) > 1e-9 ||
+	    fabs (single.width - extents[i].width) > 1e-9 ||
+	    fabs (single.height - extents[i].height) > 1e-9 ||
+	    single.x_advance != extents[i].x_advance ||
+	    single.y_advance != extents[i].y_advance)
+	{
+	    cairo_test_log (ctx, "glyph %lu: extents differ from a single lookup\n",
+			    indices[i]);
+	    result = CAIRO_TEST_FAILURE;
+	}
+    }
+
+    status = cairo_scaled_font_glyph_extents_array (scaled_font,
+						    indices, -1, extents);
+    if (status != CAIRO_STATUS_NEGATIVE_COUNT) {
+	cairo_test_log (ctx, "negative count not reported\n");
+	result = CAIRO_TEST_FAILURE;
+    }
+
+done:
+    free (extents);
+    free (indices);
+    cairo_glyph_free (glyphs);
+    cairo_destroy (cr);
+
+    return result;
+}
+
+CAIRO_TEST (scaled_font_glyph_extents_array,
+	    "Check the extents of glyphs fetched in one call",
+	    "font, extents", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
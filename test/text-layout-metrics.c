@@ -0,0 +1,217 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Measure text before any of it is drawn, so that only the metrics of
+ * the glyphs are looked up, then draw it and measure it again. The
+ * extents must not change, whether the font is a toy font or a user
+ * font that has to draw its glyphs to measure them. For a FreeType
+ * font, measuring a long text that is never drawn must also leave the
+ * glyphs cached by the drawing just as they were.
+ */
+
+#include "cairo-test.h"
+
+#if CAIRO_HAS_FT_FONT
+#include <cairo-ft.h>
+#endif
+
+#define TEXT "The quick brown fox jumps over the lazy dog 0123456789"
+
+static cairo_status_t
+box_render_glyph (cairo_scaled_font_t  *scaled_font,
+		  unsigned long         glyph,
+		  cairo_t              *cr,
+		  cairo_text_extents_t *extents)
+{
+    double width = .3 + (glyph % 7) / 10.;
+
+    cairo_rectangle (cr, .05, -.7, width, .7 + (glyph % 3) / 10.);
+    cairo_fill (cr);
+
+    extents->x_advance = width + .1;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+box_unicode_to_glyph (cairo_scaled_font_t *scaled_font,
+		      unsigned long	   unicode,
+		      unsigned long	  *glyph)
+{
+    *glyph = unicode;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_test_status_t
+check_font (cairo_test_context_t *ctx, cairo_t *cr, const char *name)
+{
+    cairo_text_extents_t before, after;
+
+    cairo_text_extents (cr, TEXT, &before);
+
+    cairo_move_to (cr, 4, 30);
+    cairo_show_text (cr, TEXT);
+
+    cairo_text_extents (cr, TEXT, &after);
+
+    if (memcmp (&before, &after, sizeof (before))) {
+	cairo_test_log (ctx,
+			"%s: extents %g,%g %gx%g +%g before drawing, "
+			"%g,%g %gx%g +%g after\n", name,
+			before.x_bearing, before.y_bearing,
+			before.width, before.height, before.x_advance,
+			after.x_bearing, after.y_bearing,
+			after.width, after.height, after.x_advance);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    if (before.width <= 0 || before.x_advance <= 0) {
+	cairo_test_log (ctx, "%s: text has no extents\n", name);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+#if CAIRO_HAS_FT_FONT
+typedef struct _buffer {
+    unsigned char *data;
+    unsigned long length, size;
+} buffer_t;
+
+static cairo_status_t
+write_func (void *closure, const unsigned char *data, unsigned int length)
+{
+    buffer_t *buffer = closure;
+
+    if (buffer->length + length > buffer->size) {
+	unsigned long size = 2 * (buffer->length + length);
+	unsigned char *grown = realloc (buffer->data, size);
+
+	if (grown == NULL)
+	    return CAIRO_STATUS_NO_MEMORY;
+
+	buffer->data = grown;
+	buffer->size = size;
+    }
+
+    memcpy (buffer->data + buffer->length, data, length);
+    buffer->length += length;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Every glyph of Latin-1 and Latin Extended-A and B, as UTF-8 */
+static void
+long_text (char *utf8)
+{
+    unsigned int c;
+
+    for (c = 0x21; c < 0x7f; c++)
+	*utf8++ = c;
+    for (c = 0xa1; c < 0x250; c++) {
+	*utf8++ = 0xc0 | (c >> 6);
+	*utf8++ = 0x80 | (c & 0x3f);
+    }
+    *utf8 = '\0';
+}
+
+static cairo_test_status_t
+check_cache_kept (cairo_test_context_t *ctx, cairo_t *cr)
+{
+    cairo_scaled_font_t *scaled_font = cairo_get_scaled_font (cr);
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    buffer_t before = { NULL, 0, 0 }, after = { NULL, 0, 0 };
+    cairo_text_extents_t extents;
+    char utf8[2 * 0x250];
+
+    /* the glyphs of TEXT, as drawn by check_font() */
+    if (cairo_ft_scaled_font_write_glyph_cache (scaled_font,
+						write_func, &before))
+    {
+	cairo_test_log (ctx, "toy font is not a FreeType font, "
+			"glyph cache not checked\n");
+	goto done;
+    }
+
+    long_text (utf8);
+    cairo_text_extents (cr, utf8, &extents);
+
+    if (cairo_ft_scaled_font_write_glyph_cache (scaled_font,
+						write_func, &after) ||
+	after.length != before.length ||
+	memcmp (after.data, before.data, before.length))
+    {
+	cairo_test_log (ctx, "measuring text changed the glyph cache "
+			"from %lu bytes to %lu\n",
+			before.length, after.length);
+	status = CAIRO_TEST_FAILURE;
+    }
+
+done:
+    free (before.data);
+    free (after.data);
+
+    return status;
+}
+#endif
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status;
+    cairo_font_face_t *face;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 400, 40);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    /* an unusual size, so that no other test has measured the text */
+    cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 11.75);
+    status = check_font (ctx, cr, "toy font");
+#if CAIRO_HAS_FT_FONT
+    if (status == CAIRO_TEST_SUCCESS)
+	status = check_cache_kept (ctx, cr);
+#endif
+
+    face = cairo_user_font_face_create ();
+    cairo_user_font_face_set_render_glyph_func (face, box_render_glyph);
+    cairo_user_font_face_set_unicode_to_glyph_func (face, box_unicode_to_glyph);
+    cairo_set_font_face (cr, face);
+    cairo_font_face_destroy (face);
+    if (status == CAIRO_TEST_SUCCESS)
+	status = check_font (ctx, cr, "user font");
+
+    cairo_destroy (cr);
+
+    return status;
+}
+
+CAIRO_TEST (text_layout_metrics,
+	    "Check that text measures the same before and after it is drawn",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
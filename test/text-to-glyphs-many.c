@@ -0,0 +1,180 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Convert text of many more distinct characters than the table of
+ * recent characters kept by each scaled font starts with, so that it
+ * thrashes and is enlarged between calls, and check every glyph index
+ * and position against those worked out one glyph at a time.
+ */
+
+#include "cairo-test.h"
+
+#define FIRST_CHAR 0x4e00
+#define NUM_CHARS 600
+#define REPEATS 3
+#define FONT_SIZE 13.
+
+static unsigned long
+char_to_glyph (unsigned long unicode)
+{
+    return 3 * (unicode - FIRST_CHAR) + 7;
+}
+
+static cairo_status_t
+many_render_glyph (cairo_scaled_font_t  *scaled_font,
+		   unsigned long         glyph,
+		   cairo_t              *cr,
+		   cairo_text_extents_t *extents)
+{
+    cairo_rectangle (cr, .1, -.6, .5, .6);
+    cairo_fill (cr);
+
+    extents->x_advance = .4 + (glyph % 11) / 20.;
+    extents->y_advance = (glyph % 5) / 50.;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+many_unicode_to_glyph (cairo_scaled_font_t *scaled_font,
+		       unsigned long	    unicode,
+		       unsigned long	   *glyph)
+{
+    *glyph = char_to_glyph (unicode);
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* The characters in an order that keeps colliding in a small table */
+static unsigned long
+nth_char (int n)
+{
+    n %= NUM_CHARS;
+    return FIRST_CHAR + (n % 8) * 128 + n / 8;
+}
+
+static cairo_test_status_t
+check_text (cairo_test_context_t *ctx,
+	    cairo_scaled_font_t  *scaled_font,
+	    const char		 *utf8,
+	    int			  pass)
+{
+    cairo_glyph_t *glyphs = NULL;
+    int num_glyphs = 0, i;
+    cairo_text_extents_t extents;
+    cairo_glyph_t expected, single;
+    cairo_status_t status;
+
+    status = cairo_scaled_font_text_to_glyphs (scaled_font, 10, 20,
+					       utf8, -1,
+					       &glyphs, &num_glyphs,
+					       NULL, NULL, NULL);
+    if (status) {
+	cairo_test_log (ctx, "pass %d: %s\n",
+			pass, cairo_status_to_string (status));
+	return CAIRO_TEST_FAILURE;
+    }
+
+    if (num_glyphs != REPEATS * NUM_CHARS) {
+	cairo_test_log (ctx, "pass %d: %d glyphs for %d characters\n",
+			pass, num_glyphs, REPEATS * NUM_CHARS);
+	cairo_glyph_free (glyphs);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    expected.x = 10;
+    expected.y = 20;
+    for (i = 0; i < num_glyphs; i++) {
+	expected.index = char_to_glyph (nth_char (i));
+
+	if (glyphs[i].index != expected.index ||
+	    glyphs[i].x != expected.x || glyphs[i].y != expected.y)
+	{
+	    cairo_test_log (ctx,
+			    "pass %d, glyph %d: %lu at %g,%g, "
+			    "expected %lu at %g,%g\n",
+			    pass, i,
+			    glyphs[i].index, glyphs[i].x, glyphs[i].y,
+			    expected.index, expected.x, expected.y);
+	    cairo_glyph_free (glyphs);
+	    return CAIRO_TEST_FAILURE;
+	}
+
+	/* the advance of the glyph on its own */
+	single.index = expected.index;
+	single.x = single.y = 0;
+	cairo_scaled_font_glyph_extents (scaled_font, &single, 1, &extents);
+	expected.x += extents.x_advance;
+	expected.y += extents.y_advance;
+    }
+
+    cairo_glyph_free (glyphs);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_font_face_t *face;
+    cairo_scaled_font_t *scaled_font;
+    cairo_font_options_t *options;
+    cairo_matrix_t font_matrix, ctm;
+    char utf8[3 * REPEATS * NUM_CHARS + 1], *p;
+    int i, pass;
+
+    /* all the characters take three bytes */
+    p = utf8;
+    for (i = 0; i < REPEATS * NUM_CHARS; i++) {
+	unsigned long c = nth_char (i);
+
+	*p++ = 0xe0 | (c >> 12);
+	*p++ = 0x80 | ((c >> 6) & 0x3f);
+	*p++ = 0x80 | (c & 0x3f);
+    }
+    *p = '\0';
+
+    face = cairo_user_font_face_create ();
+    cairo_user_font_face_set_render_glyph_func (face, many_render_glyph);
+    cairo_user_font_face_set_unicode_to_glyph_func (face, many_unicode_to_glyph);
+
+    cairo_matrix_init_scale (&font_matrix, FONT_SIZE, FONT_SIZE);
+    cairo_matrix_init_identity (&ctm);
+    options = cairo_font_options_create ();
+    cairo_font_options_set_hint_metrics (options, CAIRO_HINT_METRICS_OFF);
+    scaled_font = cairo_scaled_font_create (face, &font_matrix, &ctm, options);
+    cairo_font_options_destroy (options);
+    cairo_font_face_destroy (face);
+
+    /* the table grows after each of the first passes */
+    for (pass = 0; pass < 4 && status == CAIRO_TEST_SUCCESS; pass++)
+	status = check_text (ctx, scaled_font, utf8, pass);
+
+    cairo_scaled_font_destroy (scaled_font);
+
+    return status;
+}
+
+CAIRO_TEST (text_to_glyphs_many,
+	    "Check text to glyphs conversion of many distinct characters",
+	    "text, font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,203 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * the authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. The authors make no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Draw the same text from a scalable user font at several sizes, and
+ * check that each glyph is drawn by the user only once, that the glyphs
+ * still grow with the font, and that the face refuses to change once
+ * in use. At a large size, the shared glyphs must also match the same
+ * face drawn afresh for that size, to the pixel.
+ */
+
+#include "cairo-test.h"
+
+#define TEXT "abba"
+
+#define LARGE_SIZE 250
+#define LARGE_WIDTH 400
+#define LARGE_HEIGHT 250
+
+static int render_count;
+
+static cairo_status_t
+render_glyph (cairo_scaled_font_t  *scaled_font,
+	      unsigned long         glyph,
+	      cairo_t              *cr,
+	      cairo_text_extents_t *extents)
+{
+    cairo_rectangle (cr, .1, -.7, glyph == 'a' ? .5 : .3, .7);
+    cairo_fill (cr);
+
+    /* edges well off the 1/256 em grid */
+    cairo_move_to (cr, .1037, -.0519);
+    cairo_line_to (cr, .3313, -.6871);
+    cairo_line_to (cr, glyph == 'a' ? .5933 : .3981, -.1129);
+    cairo_close_path (cr);
+    cairo_set_operator (cr, CAIRO_OPERATOR_XOR);
+    cairo_fill (cr);
+
+    extents->x_advance = .7;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+count_render_glyph (cairo_scaled_font_t  *scaled_font,
+		    unsigned long         glyph,
+		    cairo_t              *cr,
+		    cairo_text_extents_t *extents)
+{
+    render_count++;
+
+    return render_glyph (scaled_font, glyph, cr, extents);
+}
+
+static cairo_surface_t *
+draw_large (cairo_font_face_t *face)
+{
+    cairo_surface_t *surface;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8,
+					  LARGE_WIDTH, LARGE_HEIGHT);
+    cr = cairo_create (surface);
+
+    cairo_set_font_face (cr, face);
+    cairo_set_font_size (cr, LARGE_SIZE);
+    cairo_move_to (cr, 10, LARGE_HEIGHT - 20);
+    cairo_show_text (cr, "ab");
+
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+/* Returns the largest difference between two A8 surfaces */
+static int
+max_difference (cairo_surface_t *a, cairo_surface_t *b)
+{
+    const uint8_t *data_a, *data_b;
+    int stride, x, y, diff, max = 0;
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    data_a = cairo_image_surface_get_data (a);
+    data_b = cairo_image_surface_get_data (b);
+    stride = cairo_image_surface_get_stride (a);
+
+    for (y = 0; y < LARGE_HEIGHT; y++) {
+	for (x = 0; x < LARGE_WIDTH; x++) {
+	    diff = abs (data_a[y * stride + x] - data_b[y * stride + x]);
+	    if (diff > max)
+		max = diff;
+	}
+    }
+
+    return max;
+}
+
+static cairo_test_status_t
+check_large (cairo_test_context_t *ctx, cairo_font_face_t *scalable)
+{
+    cairo_font_face_t *face;
+    cairo_surface_t *shared, *fresh;
+    int diff;
+
+    face = cairo_user_font_face_create ();
+    cairo_user_font_face_set_render_glyph_func (face, render_glyph);
+
+    shared = draw_large (scalable);
+    fresh = draw_large (face);
+    diff = max_difference (shared, fresh);
+
+    cairo_surface_destroy (shared);
+    cairo_surface_destroy (fresh);
+    cairo_font_face_destroy (face);
+
+    cairo_test_log (ctx, "shared glyphs at size %d differ by %d\n",
+		    LARGE_SIZE, diff);
+
+    /* An edge of the shared glyph a quarter pixel away would be 64 */
+    return diff <= 8 ? CAIRO_TEST_SUCCESS : CAIRO_TEST_FAILURE;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t status = CAIRO_TEST_SUCCESS;
+    cairo_text_extents_t small, large;
+    cairo_font_face_t *face;
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int size;
+
+    face = cairo_user_font_face_create ();
+    cairo_user_font_face_set_render_glyph_func (face, count_render_glyph);
+    cairo_user_font_face_set_scalable (face, TRUE);
+    if (! cairo_user_font_face_get_scalable (face)) {
+	cairo_font_face_destroy (face);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 400, 100);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    cairo_set_font_face (cr, face);
+    for (size = 10; size <= 40; size += 10) {
+	cairo_set_font_size (cr, size);
+	cairo_move_to (cr, 10, 80);
+	cairo_show_text (cr, TEXT);
+    }
+
+    cairo_set_font_size (cr, 10);
+    cairo_text_extents (cr, "a", &small);
+    cairo_set_font_size (cr, 40);
+    cairo_text_extents (cr, "a", &large);
+
+    cairo_test_log (ctx, "%d glyphs drawn, glyph widths %g and %g\n",
+		    render_count, small.width, large.width);
+
+    if (render_count != 2)
+	status = CAIRO_TEST_FAILURE;
+
+    if (fabs (large.width - 4 * small.width) > .5)
+	status = CAIRO_TEST_FAILURE;
+
+    if (check_large (ctx, face) != CAIRO_TEST_SUCCESS)
+	status = CAIRO_TEST_FAILURE;
+
+    cairo_user_font_face_set_scalable (face, FALSE);
+    if (cairo_font_face_status (face) != CAIRO_STATUS_USER_FONT_IMMUTABLE) {
+	cairo_test_log (ctx, "scalable face changed after use\n");
+	status = CAIRO_TEST_FAILURE;
+    }
+
+    cairo_destroy (cr);
+    cairo_font_face_destroy (face);
+
+    return status;
+}
+
+CAIRO_TEST (user_font_scalable,
+	    "Check that the glyphs of scalable user fonts are drawn once",
+	    "font, user-font", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)